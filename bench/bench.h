@@ -0,0 +1,54 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+ Shared helpers for the benchmark programs in this directory
+*/
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/**
+ * Returns a monotonic timestamp in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec*1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Returns the next value of a xorshift64* generator. Benchmarks seed their
+ * generators with fixed values so every run sees the same inputs
+ * @param state  The generator state, must not be 0
+ */
+static inline uint64_t bench_rand(uint64_t* state){
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x*0x2545F4914F6CDD1Dull;
+}
+
+/**
+ * Parses the largest benchmark size from the command line, defaulting to def
+ */
+static inline size_t bench_maxsize(int argc, char const *argv[], size_t def){
+    if(argc > 1){
+        return (size_t) strtod(argv[1], NULL);
+    }
+    return def;
+}
+
+/**
+ * Returns the peak resident set size of the calling process in kilobytes
+ */
+static inline long bench_peak_rss_kb(void){
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ Per request container setup and teardown with malloc against an arena
+
+ usage: bench_allocator [max elements per request, default 1e4]
+ Each simulated request builds an arraylist, a 4-ary priorityqueue and a
+ linkedlist of n elements, polls the queue, and then throws everything away:
+ with malloc by freeing each container, with an arena by resetting it once.
+ Also times a linkedlist whose nodes come from a poolallocator_t.
+ Runs n = 10, 100, ... up to the maximum
+*/
+#include <stdio.h>
+#include "allocator.h"
+#include "arraylist.h"
+#include "linkedlist.h"
+#include "priorityqueue.h"
+#include "bench.h"
+
+#define TOTAL_ELEMS 10000000
+
+static int cmp_ptr(const void* a, const void* b){
+    return (a > b) - (a < b);
+}
+
+static uint64_t request(allocator_t* alloc, void** vals, size_t n){
+    arraylist_t lst;
+    priorityqueue_t pq;
+    linkedlist_t ll;
+    arraylist_init_allocator(&lst, alloc);
+    priorityqueue_init_allocator(&pq, cmp_ptr, 4, alloc);
+    linkedlist_init(&ll);
+    linkedlist_setallocator(&ll, alloc);
+    size_t i;
+    for(i = 0; i < n; i++){
+        arraylist_append(&lst, vals[i]);
+        priorityqueue_add(&pq, vals[i]);
+        linkedlist_append(&ll, vals[i]);
+    }
+    uint64_t sum = 0;
+    for(i = 0; i < n/2; i++){
+        sum += (uintptr_t) priorityqueue_poll(&pq);
+    }
+    sum += (uintptr_t) arraylist_get(&lst, n/2);
+    sum += (uintptr_t) linkedlist_peeklast(&ll);
+    if(alloc == NULL){
+        arraylist_free(&lst);
+        priorityqueue_free(&pq);
+        linkedlist_free(&ll);
+    }
+    return sum;
+}
+
+static uint64_t nodes(allocator_t* alloc, void** vals, size_t n){
+    linkedlist_t ll;
+    linkedlist_init(&ll);
+    linkedlist_setallocator(&ll, alloc);
+    size_t i;
+    for(i = 0; i < n; i++){
+        linkedlist_append(&ll, vals[i]);
+    }
+    uint64_t sum = (uintptr_t) linkedlist_peeklast(&ll);
+    linkedlist_free(&ll);
+    return sum;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 10000);
+    size_t n, i, r;
+    void** vals = (void**) malloc(max*sizeof(void*));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    for(i = 0; i < max; i++){
+        vals[i] = (void*) (uintptr_t) bench_rand(&seed);
+    }
+
+    printf("allocator,test,n,requests,ns_per_request,checksum\n");
+    for(n = 10; n <= max; n *= 10){
+        size_t requests = TOTAL_ELEMS/n;
+        uint64_t sum = 0;
+        uint64_t start = bench_now_ns();
+        for(r = 0; r < requests; r++){
+            sum += request(NULL, vals, n);
+        }
+        printf("malloc,request,%zu,%zu,%.1f,%llu\n", n, requests,
+               (double) (bench_now_ns() - start)/requests,
+               (unsigned long long) sum);
+
+        arena_t arena;
+        arena_init(&arena, 0);
+        sum = 0;
+        start = bench_now_ns();
+        for(r = 0; r < requests; r++){
+            sum += request(&arena.allocator, vals, n);
+            arena_reset(&arena);
+        }
+        printf("arena,request,%zu,%zu,%.1f,%llu\n", n, requests,
+               (double) (bench_now_ns() - start)/requests,
+               (unsigned long long) sum);
+        arena_free(&arena);
+
+        sum = 0;
+        start = bench_now_ns();
+        for(r = 0; r < requests; r++){
+            sum += nodes(NULL, vals, n);
+        }
+        printf("malloc,linkedlist,%zu,%zu,%.1f,%llu\n", n, requests,
+               (double) (bench_now_ns() - start)/requests,
+               (unsigned long long) sum);
+
+        poolallocator_t pa;
+        poolallocator_init(&pa, sizeof(_llnode_t));
+        sum = 0;
+        start = bench_now_ns();
+        for(r = 0; r < requests; r++){
+            sum += nodes(&pa.allocator, vals, n);
+        }
+        printf("pool,linkedlist,%zu,%zu,%.1f,%llu\n", n, requests,
+               (double) (bench_now_ns() - start)/requests,
+               (unsigned long long) sum);
+        poolallocator_free(&pa);
+        fflush(stdout);
+    }
+    free(vals);
+    return 0;
+}
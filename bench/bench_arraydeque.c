@@ -0,0 +1,115 @@
+/*
+ FIFO queue throughput of arraydeque against linkedlist
+
+ usage: bench_arraydeque [max elements, default 1e6]
+ For queue depths of 1e3, 1e4, ... up to the maximum, fills the queue, cycles
+ it by adding at the back and polling from the front depth times, and drains
+ it, reporting ns per element for each phase. Linkedlists are timed with
+ malloc'd nodes and with a private node pool. The arraydeque is also timed
+ filling and draining in bulk with addall and drainto
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "arraydeque.h"
+#include "linkedlist.h"
+#include "bench.h"
+
+static void row(const char* queue, size_t n, uint64_t t0, uint64_t t1,
+                uint64_t t2, uint64_t t3, uint64_t sum){
+    printf("%s,%zu,%.2f,%.2f,%.2f,%llu\n", queue, n, (double) (t1 - t0)/n,
+           (double) (t2 - t1)/n, (double) (t3 - t2)/n,
+           (unsigned long long) sum);
+}
+
+static void bench_linkedlist(const char* name, size_t n, bool pool){
+    linkedlist_t lst;
+    linkedlist_init(&lst);
+    if(pool){
+        linkedlist_setpool(&lst, NULL);
+    }
+    uint64_t sum = 0;
+    size_t i;
+    uint64_t t0 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        linkedlist_append(&lst, (void*) (uintptr_t) i);
+    }
+    uint64_t t1 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        linkedlist_append(&lst, (void*) (uintptr_t) i);
+        sum += (uintptr_t) linkedlist_pollfirst(&lst);
+    }
+    uint64_t t2 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        sum += (uintptr_t) linkedlist_pollfirst(&lst);
+    }
+    uint64_t t3 = bench_now_ns();
+    row(name, n, t0, t1, t2, t3, sum);
+    linkedlist_free(&lst);
+}
+
+static void bench_arraydeque(size_t n){
+    arraydeque_t dq;
+    arraydeque_init(&dq);
+    uint64_t sum = 0;
+    size_t i;
+    uint64_t t0 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        arraydeque_addlast(&dq, (void*) (uintptr_t) i);
+    }
+    uint64_t t1 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        arraydeque_addlast(&dq, (void*) (uintptr_t) i);
+        sum += (uintptr_t) arraydeque_pollfirst(&dq);
+    }
+    uint64_t t2 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        sum += (uintptr_t) arraydeque_pollfirst(&dq);
+    }
+    uint64_t t3 = bench_now_ns();
+    row("arraydeque", n, t0, t1, t2, t3, sum);
+    arraydeque_free(&dq);
+}
+
+static void bench_arraydeque_bulk(size_t n, void** ary){
+    arraydeque_t dq;
+    arraydeque_init(&dq);
+    uint64_t sum = 0;
+    size_t i;
+    uint64_t t0 = bench_now_ns();
+    arraydeque_addall(&dq, ary, n);
+    uint64_t t1 = bench_now_ns();
+    // Cycle in batches of 64 so the queue wraps around its buffer
+    for(i = 0; i < n; i += 64){
+        size_t batch = n - i < 64 ? n - i : 64;
+        arraydeque_addall(&dq, ary + i, batch);
+        arraydeque_drainto(&dq, ary + i, batch);
+    }
+    uint64_t t2 = bench_now_ns();
+    arraydeque_drainto(&dq, ary, n);
+    uint64_t t3 = bench_now_ns();
+    for(i = 0; i < n; i++){
+        sum += (uintptr_t) ary[i];
+    }
+    row("arraydeque_bulk", n, t0, t1, t2, t3, sum);
+    arraydeque_free(&dq);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    void** ary = (void**) malloc(max*sizeof(void*));
+    size_t n, i;
+
+    printf("queue,n,fill_ns,cycle_ns,drain_ns,checksum\n");
+    for(n = 1000; n <= max; n *= 10){
+        bench_linkedlist("linkedlist", n, false);
+        bench_linkedlist("linkedlist_pool", n, true);
+        bench_arraydeque(n);
+        for(i = 0; i < n; i++){
+            ary[i] = (void*) (uintptr_t) i;
+        }
+        bench_arraydeque_bulk(n, ary);
+        fflush(stdout);
+    }
+    free(ary);
+    return 0;
+}
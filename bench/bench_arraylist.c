@@ -0,0 +1,103 @@
+/*
+ Editor-like insert bursts and membership checks on arraylist
+
+ usage: bench_arraylist [max elements, default 1e6]
+ For lists of 1e3, 1e4, ... elements up to the maximum, first moves a cursor
+ to a random position 1000 times and inserts 64 elements followed by 16
+ removals at the cursor each time, with and without gap buffer mode. Then
+ looks up 100 random elements of a sorted list with indexof, identity search
+ and binary search
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "arraylist.h"
+#include "bench.h"
+
+#define BURSTS 1000
+#define BURST_ADDS 64
+#define BURST_REMOVES 16
+#define LOOKUPS 100
+
+static int cmp_ptr(const void* a, const void* b){
+    return (a > b) - (a < b);
+}
+
+static double edit_bursts(size_t n, bool gapbuffer){
+    arraylist_t lst;
+    arraylist_init(&lst);
+    arraylist_setgapbuffer(&lst, gapbuffer);
+    size_t i, b;
+    for(i = 0; i < n; i++){
+        arraylist_append(&lst, (void*) (uintptr_t) i);
+    }
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    uint64_t start = bench_now_ns();
+    for(b = 0; b < BURSTS; b++){
+        size_t cursor = bench_rand(&seed) % arraylist_length(&lst);
+        for(i = 0; i < BURST_ADDS; i++){
+            arraylist_add(&lst, cursor++, (void*) (uintptr_t) i);
+        }
+        for(i = 0; i < BURST_REMOVES; i++){
+            arraylist_remove(&lst, --cursor);
+        }
+    }
+    double ns = (bench_now_ns() - start)/
+                (double) (BURSTS*(BURST_ADDS + BURST_REMOVES));
+    arraylist_free(&lst);
+    return ns;
+}
+
+static void lookups(size_t n){
+    arraylist_t lst;
+    arraylist_init(&lst);
+    void** targets = (void**) malloc(LOOKUPS*sizeof(void*));
+    size_t i;
+    for(i = 0; i < n; i++){
+        arraylist_append(&lst, (void*) (uintptr_t) (2*i + 2));
+    }
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    for(i = 0; i < LOOKUPS; i++){
+        targets[i] = arraylist_get(&lst, bench_rand(&seed) % n);
+    }
+    int method;
+    for(method = 0; method < 3; method++){
+        const char* names[] = {"indexof", "indexof_identity", "binarysearch"};
+        ptrdiff_t found = 0;
+        uint64_t start = bench_now_ns();
+        for(i = 0; i < LOOKUPS; i++){
+            if(method == 0){
+                found += arraylist_indexof(&lst, targets[i], cmp_ptr);
+            }
+            else if(method == 1){
+                found += arraylist_indexof_identity(&lst, targets[i]);
+            }
+            else{
+                found += arraylist_binarysearch(&lst, targets[i], cmp_ptr);
+            }
+        }
+        double ns = (bench_now_ns() - start)/(double) LOOKUPS;
+        printf("%s,%zu,%.1f,%.3f,%td\n", names[method], n, ns,
+               method < 2 ? n*sizeof(void*)/2/ns : 0.0, found);
+    }
+    free(targets);
+    arraylist_free(&lst);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n;
+
+    printf("mode,elements,ns_per_edit\n");
+    for(n = 1000; n <= max; n *= 10){
+        printf("shift,%zu,%.2f\n", n, edit_bursts(n, false));
+        printf("gapbuffer,%zu,%.2f\n", n, edit_bursts(n, true));
+        fflush(stdout);
+    }
+
+    printf("\nsearch,elements,ns_per_lookup,gb_per_s,index_sum\n");
+    for(n = 1000; n <= max; n *= 10){
+        lookups(n);
+        fflush(stdout);
+    }
+    return 0;
+}
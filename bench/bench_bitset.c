@@ -0,0 +1,152 @@
+/*
+ Membership flags in a bitset against an arraylist of boxed ids
+
+ usage: bench_bitset [max ids, default 1e7]
+ For 1e3, 1e4, ... ids up to the maximum, flags a random half of them and
+ times setting, testing, iterating and counting the flags, and the bulk
+ operations between two such sets. Bulk operation bandwidth counts the bytes
+ of both operands read and the result written, and memcpy of the same words
+ is timed as the bandwidth ceiling. The arraylist is only searched up to 1e5
+ ids and on a sample of lookups
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arraylist.h"
+#include "bitset.h"
+#include "bench.h"
+
+#define SCAN_MAX 100000
+#define SCAN_LOOKUPS 1000
+#define BULK_REPS 10
+
+static int cmp_u64(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void row(const char* container, const char* op, size_t n, size_t ops,
+                size_t bytes, uint64_t start, size_t check){
+    uint64_t elapsed = bench_now_ns() - start;
+    printf("%s,%s,%zu,%.3f,%.2f,%zu\n", container, op, n,
+           (double) elapsed/ops, (double) bytes*ops/elapsed, check);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 10000000);
+    uint64_t* ids = (uint64_t*) malloc(max*sizeof(uint64_t));
+    size_t* probes = (size_t*) malloc(max*sizeof(size_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t n, i, r;
+    for(i = 0; i < max; i++){
+        ids[i] = i;
+    }
+
+    printf("container,op,n,ns_per_op,gb_per_s,check\n");
+    for(n = 1000; n <= max; n *= 10){
+        for(i = 0; i < n; i++){
+            probes[i] = (size_t) (bench_rand(&seed) % n);
+        }
+        bitset_t a, b;
+        bitset_init(&a);
+        bitset_init(&b);
+        bitset_reserve(&a, n);
+        bitset_reserve(&b, n);
+        uint64_t start = bench_now_ns();
+        for(i = 0; i < n/2; i++){
+            bitset_set(&a, probes[i]);
+        }
+        row("bitset", "set", n, n/2, 0, start, bitset_cardinality(&a));
+        for(i = n/2; i < n; i++){
+            bitset_set(&b, probes[i]);
+        }
+
+        size_t found = 0;
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            found += bitset_get(&a, probes[i]);
+        }
+        row("bitset", "get", n, n, 0, start, found);
+
+        found = 0;
+        start = bench_now_ns();
+        ptrdiff_t ind;
+        for(ind = bitset_nextsetbit(&a, 0); ind >= 0;
+            ind = bitset_nextsetbit(&a, ind + 1)){
+            found++;
+        }
+        row("bitset", "nextsetbit", n, found, 0, start, found);
+
+        size_t words = a.nwords;
+        size_t bytes = words*sizeof(uint64_t);
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            found = bitset_cardinality(&a);
+        }
+        row("bitset", "cardinality", n, BULK_REPS, bytes, start, found);
+
+        // xor runs an even number of times, so it leaves a as it was, and the
+        // other operations change a only on their first run
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            bitset_xor(&a, &b);
+        }
+        row("bitset", "xor", n, BULK_REPS, 3*bytes, start,
+            bitset_cardinality(&a));
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            bitset_or(&a, &b);
+        }
+        row("bitset", "or", n, BULK_REPS, 3*bytes, start,
+            bitset_cardinality(&a));
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            bitset_and(&a, &b);
+        }
+        row("bitset", "and", n, BULK_REPS, 3*bytes, start,
+            bitset_cardinality(&a));
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            bitset_andnot(&a, &b);
+        }
+        row("bitset", "andnot", n, BULK_REPS, 3*bytes, start,
+            bitset_cardinality(&a));
+        start = bench_now_ns();
+        for(r = 0; r < BULK_REPS; r++){
+            memcpy(a.words, b.words, bytes);
+        }
+        row("memcpy", "copy", n, BULK_REPS, 2*bytes, start, 0);
+        printf("bitset,memory_bytes,%zu,0,0,%zu\n", n, bytes);
+        bitset_free(&b);
+        bitset_free(&a);
+
+        // The boxed ids are pointers into ids, so the list holds a pointer per
+        // flagged id and every id is a separate 8 byte value
+        arraylist_t lst;
+        arraylist_init(&lst);
+        start = bench_now_ns();
+        for(i = 0; i < n/2; i++){
+            arraylist_append(&lst, &ids[probes[i]]);
+        }
+        row("arraylist", "set", n, n/2, 0, start, arraylist_length(&lst));
+        if(n <= SCAN_MAX){
+            size_t lookups = n < SCAN_LOOKUPS ? n : SCAN_LOOKUPS;
+            found = 0;
+            start = bench_now_ns();
+            for(i = 0; i < lookups; i++){
+                found += arraylist_indexof(&lst, &ids[probes[i]],
+                                           cmp_u64) >= 0;
+            }
+            row("arraylist", "get", n, lookups, 0, start, found);
+        }
+        bytes = lst.size*sizeof(void*) +
+                arraylist_length(&lst)*sizeof(uint64_t);
+        printf("arraylist,memory_bytes,%zu,0,0,%zu\n", n, bytes);
+        arraylist_free(&lst);
+        fflush(stdout);
+    }
+    free(probes);
+    free(ids);
+    return 0;
+}
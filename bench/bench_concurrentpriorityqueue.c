@@ -0,0 +1,94 @@
+/*
+ Scaling of concurrentpriorityqueue add/poll throughput with thread count
+
+ usage: bench_concurrentpriorityqueue [total operations, default 1e6]
+ The queue is prefilled with 1e5 elements, then every thread runs a share of
+ the operations as alternating poll and add. Prints one CSV row per (mode,
+ threads) pair for 1, 2, 4, ... threads up to twice the number of cpus
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "concurrentpriorityqueue.h"
+#include "bench.h"
+
+#define PREFILL 100000
+
+typedef struct worker_t{
+    concurrentpriorityqueue_t* cpq;
+    uint64_t* keys;
+    size_t ops;
+} worker_t;
+
+static int cmp_u64(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void* worker(void* arg){
+    worker_t* w = (worker_t*) arg;
+    size_t i;
+    for(i = 0; i < w->ops; i++){
+        uint64_t* key = (uint64_t*) concurrentpriorityqueue_poll(w->cpq);
+        if(key == NULL){
+            key = &w->keys[i % PREFILL];
+        }
+        *key += i & 0xffff;
+        concurrentpriorityqueue_add(w->cpq, key);
+    }
+    return NULL;
+}
+
+static void run(bool strict, size_t nthreads, size_t ops){
+    concurrentpriorityqueue_t cpq;
+    concurrentpriorityqueue_init(&cpq, cmp_u64, nthreads, strict);
+    uint64_t* keys = (uint64_t*) malloc((nthreads + 1)*PREFILL*sizeof(uint64_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t i;
+    for(i = 0; i < (nthreads + 1)*PREFILL; i++){
+        keys[i] = bench_rand(&seed) >> 16;
+    }
+    for(i = 0; i < PREFILL; i++){
+        concurrentpriorityqueue_add(&cpq, &keys[i]);
+    }
+
+    pthread_t* threads = (pthread_t*) malloc(nthreads*sizeof(pthread_t));
+    worker_t* workers = (worker_t*) malloc(nthreads*sizeof(worker_t));
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < nthreads; i++){
+        workers[i].cpq = &cpq;
+        workers[i].keys = &keys[(i + 1)*PREFILL];
+        workers[i].ops = ops/nthreads;
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+    for(i = 0; i < nthreads; i++){
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    // Each worker iteration is one poll and one add
+    size_t total = 2*nthreads*(ops/nthreads);
+    printf("%s,%zu,%.2f,%.2f\n", strict ? "strict" : "relaxed", nthreads,
+           (double) elapsed/total, total*1e3/elapsed);
+    fflush(stdout);
+
+    free(workers);
+    free(threads);
+    free(keys);
+    concurrentpriorityqueue_free(&cpq);
+}
+
+int main(int argc, char const *argv[]){
+    size_t ops = bench_maxsize(argc, argv, 1000000);
+    size_t maxthreads = 2*(size_t) sysconf(_SC_NPROCESSORS_ONLN);
+    size_t n;
+
+    printf("mode,threads,ns_per_op,mops\n");
+    for(n = 1; n <= maxthreads; n *= 2){
+        run(true, n, ops);
+        run(false, n, ops);
+    }
+    return 0;
+}
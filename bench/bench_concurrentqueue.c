@@ -0,0 +1,268 @@
+/*
+ Throughput and latency of spscqueue and mpmcqueue against a locked linkedlist
+
+ usage: bench_concurrentqueue [total elements, default 1e6]
+ Throughput rows split the elements between 1, 2, 4, ... producers and as
+ many consumers, up to the number of cpus (at least 2), passing them one at a
+ time and in batches of 32. spscqueue only runs with one of each. Latency rows
+ bounce one element between two threads through a pair of queues and report
+ the round trip time. The baseline is a linkedlist_t guarded by a mutex
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include "concurrentqueue.h"
+#include "linkedlist.h"
+#include "bench.h"
+
+#define CAPACITY 1024
+#define BATCH 32
+
+typedef struct lockedlist_t{
+    pthread_mutex_t lock;
+    linkedlist_t lst;
+} lockedlist_t;
+
+typedef struct queue_t{
+    const char* name;
+    void* (*create)(void);
+    void (*destroy)(void*);
+    size_t (*offerall)(void*, void**, size_t);
+    size_t (*drainto)(void*, void**, size_t);
+} queue_t;
+
+static void* locked_create(void){
+    lockedlist_t* q = (lockedlist_t*) malloc(sizeof(lockedlist_t));
+    pthread_mutex_init(&q->lock, NULL);
+    linkedlist_init(&q->lst);
+    return q;
+}
+
+static void locked_destroy(void* q){
+    lockedlist_t* l = (lockedlist_t*) q;
+    linkedlist_free(&l->lst);
+    pthread_mutex_destroy(&l->lock);
+    free(l);
+}
+
+static size_t locked_offerall(void* q, void** ary, size_t len){
+    lockedlist_t* l = (lockedlist_t*) q;
+    size_t i;
+    pthread_mutex_lock(&l->lock);
+    for(i = 0; i < len; i++){
+        linkedlist_append(&l->lst, ary[i]);
+    }
+    pthread_mutex_unlock(&l->lock);
+    return len;
+}
+
+static size_t locked_drainto(void* q, void** ary, size_t max){
+    lockedlist_t* l = (lockedlist_t*) q;
+    size_t n = 0;
+    pthread_mutex_lock(&l->lock);
+    while(n < max && (ary[n] = linkedlist_pollfirst(&l->lst)) != NULL){
+        n++;
+    }
+    pthread_mutex_unlock(&l->lock);
+    return n;
+}
+
+static void* spsc_create(void){
+    spscqueue_t* q = (spscqueue_t*) aligned_alloc(64, sizeof(spscqueue_t));
+    spscqueue_init(q, CAPACITY);
+    return q;
+}
+
+static void spsc_destroy(void* q){
+    spscqueue_free((spscqueue_t*) q);
+    free(q);
+}
+
+static size_t spsc_offerall(void* q, void** ary, size_t len){
+    if(len == 1){
+        return spscqueue_offer((spscqueue_t*) q, ary[0]);
+    }
+    return spscqueue_offerall((spscqueue_t*) q, ary, len);
+}
+
+static size_t spsc_drainto(void* q, void** ary, size_t max){
+    if(max == 1){
+        return (ary[0] = spscqueue_poll((spscqueue_t*) q)) != NULL;
+    }
+    return spscqueue_drainto((spscqueue_t*) q, ary, max);
+}
+
+static void* mpmc_create(void){
+    mpmcqueue_t* q = (mpmcqueue_t*) aligned_alloc(64, sizeof(mpmcqueue_t));
+    mpmcqueue_init(q, CAPACITY);
+    return q;
+}
+
+static void mpmc_destroy(void* q){
+    mpmcqueue_free((mpmcqueue_t*) q);
+    free(q);
+}
+
+static size_t mpmc_offerall(void* q, void** ary, size_t len){
+    if(len == 1){
+        return mpmcqueue_offer((mpmcqueue_t*) q, ary[0]);
+    }
+    return mpmcqueue_offerall((mpmcqueue_t*) q, ary, len);
+}
+
+static size_t mpmc_drainto(void* q, void** ary, size_t max){
+    if(max == 1){
+        return (ary[0] = mpmcqueue_poll((mpmcqueue_t*) q)) != NULL;
+    }
+    return mpmcqueue_drainto((mpmcqueue_t*) q, ary, max);
+}
+
+static const queue_t queues[] = {
+    {"lockedlist", locked_create, locked_destroy, locked_offerall,
+     locked_drainto},
+    {"spscqueue", spsc_create, spsc_destroy, spsc_offerall, spsc_drainto},
+    {"mpmcqueue", mpmc_create, mpmc_destroy, mpmc_offerall, mpmc_drainto},
+};
+
+typedef struct worker_t{
+    const queue_t* queue;
+    void* q;
+    void* back;            // Queue the latency test replies on
+    size_t batch;
+    size_t n;              // Elements to produce, or rounds to bounce
+    size_t total;          // Elements all consumers take
+    atomic_size_t* taken;
+} worker_t;
+
+static void* producer(void* arg){
+    worker_t* w = (worker_t*) arg;
+    void* batch[BATCH];
+    size_t i, j;
+    for(i = 0; i < w->n; ){
+        size_t len = w->batch < w->n - i ? w->batch : w->n - i;
+        for(j = 0; j < len; j++){
+            batch[j] = (void*) (uintptr_t) (i + j + 1);
+        }
+        for(j = 0; j < len; ){
+            size_t n = w->queue->offerall(w->q, batch + j, len - j);
+            if(n == 0){
+                sched_yield();
+            }
+            j += n;
+        }
+        i += len;
+    }
+    return NULL;
+}
+
+static void* consumer(void* arg){
+    worker_t* w = (worker_t*) arg;
+    void* batch[BATCH];
+    while(atomic_load_explicit(w->taken, memory_order_relaxed) < w->total){
+        size_t n = w->queue->drainto(w->q, batch, w->batch);
+        if(n == 0){
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add_explicit(w->taken, n, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static void throughput(const queue_t* queue, size_t nthreads, size_t batch,
+                       size_t elems){
+    atomic_size_t taken;
+    atomic_init(&taken, 0);
+    void* q = queue->create();
+    pthread_t* threads = (pthread_t*) malloc(2*nthreads*sizeof(pthread_t));
+    worker_t* workers = (worker_t*) malloc(2*nthreads*sizeof(worker_t));
+    size_t i;
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < 2*nthreads; i++){
+        workers[i].queue = queue;
+        workers[i].q = q;
+        workers[i].batch = batch;
+        workers[i].n = elems/nthreads;
+        workers[i].total = nthreads*(elems/nthreads);
+        workers[i].taken = &taken;
+        pthread_create(&threads[i], NULL, i < nthreads ? producer : consumer,
+                       &workers[i]);
+    }
+    for(i = 0; i < 2*nthreads; i++){
+        pthread_join(threads[i], NULL);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    size_t total = nthreads*(elems/nthreads);
+    printf("%s,throughput,%zu,%zu,%zu,%.2f,%.2f\n", queue->name, nthreads,
+           nthreads, batch, (double) elapsed/total, total*1e3/elapsed);
+    fflush(stdout);
+    free(workers);
+    free(threads);
+    queue->destroy(q);
+}
+
+static void* echo(void* arg){
+    worker_t* w = (worker_t*) arg;
+    void* elem;
+    size_t i;
+    for(i = 0; i < w->n; i++){
+        while(w->queue->drainto(w->q, &elem, 1) == 0){
+            sched_yield();
+        }
+        while(w->queue->offerall(w->back, &elem, 1) == 0){
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void latency(const queue_t* queue, size_t rounds){
+    worker_t w = {queue, queue->create(), queue->create(), 1, rounds, 0, NULL};
+    pthread_t thread;
+    pthread_create(&thread, NULL, echo, &w);
+    void* elem = (void*) (uintptr_t) 1;
+    size_t i;
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < rounds; i++){
+        while(queue->offerall(w.q, &elem, 1) == 0){
+            sched_yield();
+        }
+        while(queue->drainto(w.back, &elem, 1) == 0){
+            sched_yield();
+        }
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    pthread_join(thread, NULL);
+
+    printf("%s,roundtrip,1,1,1,%.2f,%.2f\n", queue->name,
+           (double) elapsed/rounds, rounds*1e3/elapsed);
+    fflush(stdout);
+    queue->destroy(w.q);
+    queue->destroy(w.back);
+}
+
+int main(int argc, char const *argv[]){
+    size_t elems = bench_maxsize(argc, argv, 1000000);
+    size_t maxthreads = (size_t) sysconf(_SC_NPROCESSORS_ONLN);
+    maxthreads = maxthreads < 2 ? 2 : maxthreads;
+    size_t nqueues = sizeof(queues)/sizeof(queues[0]);
+    size_t i, n;
+
+    printf("queue,test,producers,consumers,batch,ns_per_elem,mops\n");
+    for(n = 1; n <= maxthreads; n *= 2){
+        for(i = 0; i < nqueues; i++){
+            if(queues[i].create == spsc_create && n > 1){
+                continue;
+            }
+            throughput(&queues[i], n, 1, elems);
+            throughput(&queues[i], n, BATCH, elems);
+        }
+    }
+    for(i = 0; i < nqueues; i++){
+        latency(&queues[i], elems/10);
+    }
+    return 0;
+}
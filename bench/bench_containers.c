@@ -0,0 +1,823 @@
+/*
+ Microbenchmarks of every public operation of arraylist, linkedlist and
+ priorityqueue, with a plain array as the baseline
+
+ usage: bench_containers [max elements, default 1e6] [filter]
+ Runs every benchmark whose container.op name contains filter for 10, 100, ...
+ elements up to the maximum. Each row runs in a forked child, so peak_rss_kb is
+ the peak resident set size of that benchmark alone. A benchmark builds its
+ container untimed and then times one pass of operations on it. One untimed
+ pass warms up caches and the allocator, and passes are repeated until 50 ms
+ have been timed. Keys and indices come from fixed seeds, so every run sees
+ the same inputs. Operations that cost O(n) each run at most 1e7/n times per
+ pass. ns_per_op excludes setup and the cost of reading the clock, and
+ cmp_per_op counts comparator calls
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "arraylist.h"
+#include "linkedlist.h"
+#include "priorityqueue.h"
+#include "threadpool.h"
+#include "bench.h"
+
+#define MIN_TIMED_NS 50000000ull
+#define MAX_PASSES 100000
+
+typedef struct sample_t{
+    uint64_t start; // Clock at the start of the timed section
+    uint64_t ns;    // Length of the timed section
+    size_t cmps;    // Comparator calls in the timed section
+} sample_t;
+
+typedef struct bench_t{
+    const char* container;
+    const char* op;
+    size_t (*run)(size_t n, sample_t* s); // Returns the # of ops timed
+} bench_t;
+
+static size_t cmp_calls = 0;
+static uint64_t* keys;  // n random keys
+static void** elems;    // Pointers to the keys in order
+static size_t* picks;   // n random indices below n
+static void* volatile sink;
+
+static int cmp_key(const void* a, const void* b){
+    cmp_calls++;
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+// qsort and bsearch pass pointers to the array slots rather than the elements
+static int cmp_slot(const void* a, const void* b){
+    return cmp_key(*((void* const*) a), *((void* const*) b));
+}
+
+static inline void timer_start(sample_t* s){
+    cmp_calls = 0;
+    s->start = bench_now_ns();
+}
+
+static inline void timer_stop(sample_t* s){
+    s->ns = bench_now_ns() - s->start;
+    s->cmps = cmp_calls;
+}
+
+/**
+ * Returns how many operations of O(n) cost to time per pass
+ */
+static size_t linear_ops(size_t n){
+    size_t ops = 10000000/n;
+    return ops < 1 ? 1 : ops > n ? n : ops;
+}
+
+static void build_arraylist(arraylist_t* lst, size_t n){
+    arraylist_init(lst);
+    arraylist_addall(lst, 0, n, elems);
+}
+
+static void build_linkedlist(linkedlist_t* lst, size_t n, bool deque){
+    size_t i;
+    if(deque){
+        linkedlist_init_deque(lst);
+    }
+    else{
+        linkedlist_init(lst);
+    }
+    for(i = 0; i < n; i++){
+        linkedlist_addlast(lst, elems[i]);
+    }
+}
+
+/* plain array baselines */
+
+static size_t array_append(size_t n, sample_t* s){
+    void** ary = (void**) malloc(n*sizeof(void*));
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        ary[i] = elems[i];
+    }
+    timer_stop(s);
+    sink = ary;
+    free(ary);
+    return n;
+}
+
+static size_t array_get(size_t n, sample_t* s){
+    void** ary = (void**) malloc(n*sizeof(void*));
+    memcpy(ary, elems, n*sizeof(void*));
+    uintptr_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sum += (uintptr_t) ary[picks[i]];
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    free(ary);
+    return n;
+}
+
+static size_t array_indexof(size_t n, sample_t* s){
+    size_t ops = linear_ops(n);
+    size_t i, j;
+    uintptr_t sum = 0;
+    timer_start(s);
+    for(j = 0; j < ops; j++){
+        const void* target = elems[picks[j]];
+        for(i = 0; i < n && cmp_key(target, elems[i]) != 0; i++);
+        sum += i;
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    return ops;
+}
+
+static size_t array_qsort(size_t n, sample_t* s){
+    void** ary = (void**) malloc(n*sizeof(void*));
+    memcpy(ary, elems, n*sizeof(void*));
+    timer_start(s);
+    qsort(ary, n, sizeof(void*), cmp_slot);
+    timer_stop(s);
+    free(ary);
+    return n;
+}
+
+static size_t array_bsearch(size_t n, sample_t* s){
+    void** ary = (void**) malloc(n*sizeof(void*));
+    memcpy(ary, elems, n*sizeof(void*));
+    qsort(ary, n, sizeof(void*), cmp_slot);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = bsearch(&elems[picks[i]], ary, n, sizeof(void*), cmp_slot);
+    }
+    timer_stop(s);
+    free(ary);
+    return n;
+}
+
+/* arraylist */
+
+static size_t arraylist_bench_append(size_t n, sample_t* s){
+    arraylist_t lst;
+    arraylist_init(&lst);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        arraylist_append(&lst, elems[i]);
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_add(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        arraylist_add(&lst, picks[i], elems[i]);
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return ops;
+}
+
+static size_t arraylist_bench_add_gapbuffer(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    arraylist_setgapbuffer(&lst, true);
+    size_t cursor = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        // Bursts of 64 inserts at a cursor that then jumps elsewhere
+        if(i % 64 == 0){
+            cursor = picks[i];
+        }
+        arraylist_add(&lst, cursor++, elems[i]);
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_addall(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    timer_start(s);
+    arraylist_addall(&lst, n/2, n, elems);
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_remove(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sink = arraylist_remove(&lst, picks[i] % arraylist_length(&lst));
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return ops;
+}
+
+static size_t arraylist_bench_get(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    uintptr_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sum += (uintptr_t) arraylist_get(&lst, picks[i]);
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_toarray(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = arraylist_toarray(&lst);
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_indexof(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    size_t ops = linear_ops(n);
+    ptrdiff_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sum += arraylist_indexof(&lst, elems[picks[i]], cmp_key);
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    arraylist_free(&lst);
+    return ops;
+}
+
+static size_t arraylist_bench_indexof_identity(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    size_t ops = linear_ops(n);
+    ptrdiff_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sum += arraylist_indexof_identity(&lst, elems[picks[i]]);
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    arraylist_free(&lst);
+    return ops;
+}
+
+static size_t arraylist_bench_binarysearch(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    arraylist_sort(&lst, cmp_key);
+    ptrdiff_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sum += arraylist_binarysearch(&lst, elems[picks[i]], cmp_key);
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_add_sorted(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    arraylist_sort(&lst, cmp_key);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        arraylist_add_sorted(&lst, elems[picks[i]], cmp_key);
+    }
+    timer_stop(s);
+    arraylist_free(&lst);
+    return ops;
+}
+
+static size_t arraylist_bench_sort(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    timer_start(s);
+    arraylist_sort(&lst, cmp_key);
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_parallel_sort(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    threadpool_t* pool = threadpool_default();
+    timer_start(s);
+    arraylist_parallel_sort(&lst, cmp_key, pool);
+    timer_stop(s);
+    arraylist_free(&lst);
+    return n;
+}
+
+static size_t arraylist_bench_reserve(size_t n, sample_t* s){
+    arraylist_t lst;
+    arraylist_init(&lst);
+    timer_start(s);
+    arraylist_reserve(&lst, n);
+    timer_stop(s);
+    arraylist_free(&lst);
+    return 1;
+}
+
+static size_t arraylist_bench_clear(size_t n, sample_t* s){
+    arraylist_t lst;
+    build_arraylist(&lst, n);
+    timer_start(s);
+    arraylist_clear(&lst);
+    timer_stop(s);
+    arraylist_free(&lst);
+    return 1;
+}
+
+/* linkedlist */
+
+static size_t linkedlist_bench_append(size_t n, sample_t* s){
+    linkedlist_t lst;
+    linkedlist_init(&lst);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        linkedlist_append(&lst, elems[i]);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_append_pooled(size_t n, sample_t* s){
+    linkedlist_t lst;
+    linkedlist_init(&lst);
+    linkedlist_setpool(&lst, NULL);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        linkedlist_append(&lst, elems[i]);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_addfirst(size_t n, sample_t* s){
+    linkedlist_t lst;
+    linkedlist_init(&lst);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        linkedlist_addfirst(&lst, elems[i]);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_add(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        linkedlist_add(&lst, picks[i], elems[i]);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return ops;
+}
+
+static size_t linkedlist_bench_remove(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sink = linkedlist_remove(&lst, picks[i] % linkedlist_length(&lst));
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return ops;
+}
+
+static size_t linkedlist_bench_pollfirst(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = linkedlist_pollfirst(&lst);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_polllast_deque(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, true);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = linkedlist_polllast(&lst);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_peekfirst(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = linkedlist_peekfirst(&lst);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_get(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sink = linkedlist_get(&lst, picks[i]);
+    }
+    timer_stop(s);
+    linkedlist_free(&lst);
+    return ops;
+}
+
+static size_t linkedlist_bench_indexof(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    size_t ops = linear_ops(n);
+    ptrdiff_t sum = 0;
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        sum += linkedlist_indexof(&lst, elems[picks[i]], cmp_key);
+    }
+    timer_stop(s);
+    sink = (void*) sum;
+    linkedlist_free(&lst);
+    return ops;
+}
+
+static size_t linkedlist_bench_toarray(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    timer_start(s);
+    void** ary = linkedlist_toarray(&lst);
+    timer_stop(s);
+    free(ary);
+    linkedlist_free(&lst);
+    return n;
+}
+
+static size_t linkedlist_bench_free(size_t n, sample_t* s){
+    linkedlist_t lst;
+    build_linkedlist(&lst, n, false);
+    timer_start(s);
+    linkedlist_free(&lst);
+    timer_stop(s);
+    return n;
+}
+
+/* priorityqueue */
+
+static void build_priorityqueue(priorityqueue_t* pq, size_t n, bool indexed){
+    if(indexed){
+        priorityqueue_init_indexed(pq, cmp_key, 2);
+    }
+    else{
+        priorityqueue_init(pq, cmp_key);
+    }
+    size_t i;
+    for(i = 0; i < n; i++){
+        priorityqueue_add(pq, elems[i]);
+    }
+}
+
+static size_t priorityqueue_bench_add(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    priorityqueue_init(&pq, cmp_key);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        priorityqueue_add(&pq, elems[i]);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_addall(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    priorityqueue_init(&pq, cmp_key);
+    timer_start(s);
+    priorityqueue_addall(&pq, elems, n);
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_init_from_array(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    // The queue takes ownership of the array
+    void** ary = (void**) malloc(n*sizeof(void*));
+    memcpy(ary, elems, n*sizeof(void*));
+    timer_start(s);
+    priorityqueue_init_from_array(&pq, cmp_key, ary, n);
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_poll(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = priorityqueue_poll(&pq);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_peek(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = priorityqueue_peek(&pq);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_contains(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    size_t ops = linear_ops(n);
+    size_t i, found = 0;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        found += priorityqueue_contains(&pq, elems[picks[i]]);
+    }
+    timer_stop(s);
+    sink = (void*) found;
+    priorityqueue_free(&pq);
+    return ops;
+}
+
+static size_t priorityqueue_bench_remove(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    size_t ops = linear_ops(n);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < ops; i++){
+        priorityqueue_remove(&pq, elems[picks[i]]);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return ops;
+}
+
+static size_t priorityqueue_bench_decrease_key(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, true);
+    uint64_t* lower = (uint64_t*) malloc(n*sizeof(uint64_t));
+    size_t i;
+    for(i = 0; i < n; i++){
+        lower[i] = keys[i]/2;
+    }
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        priorityqueue_decrease_key(&pq, i, &lower[i]);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    free(lower);
+    return n;
+}
+
+static size_t priorityqueue_bench_update_key(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, true);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        priorityqueue_update_key(&pq, i, elems[picks[i]]);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_remove_handle(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, true);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = priorityqueue_remove_handle(&pq, i);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_toarray(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    size_t i;
+    timer_start(s);
+    for(i = 0; i < n; i++){
+        sink = priorityqueue_toarray(&pq);
+    }
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return n;
+}
+
+static size_t priorityqueue_bench_clear(size_t n, sample_t* s){
+    priorityqueue_t pq;
+    build_priorityqueue(&pq, n, false);
+    timer_start(s);
+    priorityqueue_clear(&pq);
+    timer_stop(s);
+    priorityqueue_free(&pq);
+    return 1;
+}
+
+static const bench_t benches[] = {
+    {"array", "append", array_append},
+    {"array", "get", array_get},
+    {"array", "indexof", array_indexof},
+    {"array", "qsort", array_qsort},
+    {"array", "bsearch", array_bsearch},
+    {"arraylist", "append", arraylist_bench_append},
+    {"arraylist", "add", arraylist_bench_add},
+    {"arraylist", "add_gapbuffer", arraylist_bench_add_gapbuffer},
+    {"arraylist", "addall", arraylist_bench_addall},
+    {"arraylist", "remove", arraylist_bench_remove},
+    {"arraylist", "get", arraylist_bench_get},
+    {"arraylist", "toarray", arraylist_bench_toarray},
+    {"arraylist", "indexof", arraylist_bench_indexof},
+    {"arraylist", "indexof_identity", arraylist_bench_indexof_identity},
+    {"arraylist", "binarysearch", arraylist_bench_binarysearch},
+    {"arraylist", "add_sorted", arraylist_bench_add_sorted},
+    {"arraylist", "sort", arraylist_bench_sort},
+    {"arraylist", "parallel_sort", arraylist_bench_parallel_sort},
+    {"arraylist", "reserve", arraylist_bench_reserve},
+    {"arraylist", "clear", arraylist_bench_clear},
+    {"linkedlist", "append", linkedlist_bench_append},
+    {"linkedlist", "append_pooled", linkedlist_bench_append_pooled},
+    {"linkedlist", "addfirst", linkedlist_bench_addfirst},
+    {"linkedlist", "add", linkedlist_bench_add},
+    {"linkedlist", "remove", linkedlist_bench_remove},
+    {"linkedlist", "pollfirst", linkedlist_bench_pollfirst},
+    {"linkedlist", "polllast_deque", linkedlist_bench_polllast_deque},
+    {"linkedlist", "peekfirst", linkedlist_bench_peekfirst},
+    {"linkedlist", "get", linkedlist_bench_get},
+    {"linkedlist", "indexof", linkedlist_bench_indexof},
+    {"linkedlist", "toarray", linkedlist_bench_toarray},
+    {"linkedlist", "free", linkedlist_bench_free},
+    {"priorityqueue", "add", priorityqueue_bench_add},
+    {"priorityqueue", "addall", priorityqueue_bench_addall},
+    {"priorityqueue", "init_from_array", priorityqueue_bench_init_from_array},
+    {"priorityqueue", "poll", priorityqueue_bench_poll},
+    {"priorityqueue", "peek", priorityqueue_bench_peek},
+    {"priorityqueue", "contains", priorityqueue_bench_contains},
+    {"priorityqueue", "remove", priorityqueue_bench_remove},
+    {"priorityqueue", "decrease_key", priorityqueue_bench_decrease_key},
+    {"priorityqueue", "update_key", priorityqueue_bench_update_key},
+    {"priorityqueue", "remove_handle", priorityqueue_bench_remove_handle},
+    {"priorityqueue", "toarray", priorityqueue_bench_toarray},
+    {"priorityqueue", "clear", priorityqueue_bench_clear},
+};
+
+/**
+ * Returns the smallest measured cost of an empty timed section
+ */
+static uint64_t clock_overhead(void){
+    sample_t s;
+    uint64_t min = UINT64_MAX;
+    int i;
+    for(i = 0; i < 1000; i++){
+        timer_start(&s);
+        timer_stop(&s);
+        min = s.ns < min ? s.ns : min;
+    }
+    return min;
+}
+
+/**
+ * Run one benchmark at one size and print its row. Called in a child process
+ */
+static void run(const bench_t* b, size_t n, uint64_t overhead){
+    keys = (uint64_t*) malloc(n*sizeof(uint64_t));
+    elems = (void**) malloc(n*sizeof(void*));
+    picks = (size_t*) malloc(n*sizeof(size_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t i;
+    for(i = 0; i < n; i++){
+        keys[i] = bench_rand(&seed);
+        elems[i] = &keys[i];
+        picks[i] = (size_t) (bench_rand(&seed) % n);
+    }
+
+    sample_t s;
+    b->run(n, &s);
+    uint64_t ns = 0;
+    size_t ops = 0, cmps = 0, passes = 0;
+    while(ns < MIN_TIMED_NS && passes < MAX_PASSES){
+        ops += b->run(n, &s);
+        ns += s.ns > overhead ? s.ns - overhead : 0;
+        cmps += s.cmps;
+        passes++;
+    }
+    printf("%s,%s,%zu,%zu,%.2f,%.0f,%.2f,%ld\n", b->container, b->op, n,
+           passes, (double) ns/ops, ns > 0 ? ops*1e9/ns : 0.0,
+           (double) cmps/ops, bench_peak_rss_kb());
+    fflush(stdout);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    const char* filter = argc > 2 ? argv[2] : "";
+    uint64_t overhead = clock_overhead();
+    char name[64];
+    size_t n, i;
+
+    printf("container,op,n,passes,ns_per_op,ops_per_s,cmp_per_op,"
+           "peak_rss_kb\n");
+    fflush(stdout);
+    for(i = 0; i < sizeof(benches)/sizeof(benches[0]); i++){
+        snprintf(name, sizeof(name), "%s.%s", benches[i].container,
+                 benches[i].op);
+        if(strstr(name, filter) == NULL){
+            continue;
+        }
+        for(n = 10; n <= max; n *= 10){
+            pid_t pid = fork();
+            if(pid == 0){
+                run(&benches[i], n, overhead);
+                _exit(0);
+            }
+            int status;
+            if(pid < 0 || waitpid(pid, &status, 0) < 0 || status != 0){
+                fprintf(stderr, "%s at n = %zu failed\n", name, n);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
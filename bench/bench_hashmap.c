@@ -0,0 +1,103 @@
+/*
+ Keyed lookups with hashmap against a linear arraylist_indexof scan
+
+ usage: bench_hashmap [max keys, default 1e6]
+ Inserts random 64 bit keys for 1e3, 1e4, ... keys up to the maximum and times
+ lookups of present keys in random order and of absent keys. The arraylist
+ scan is only timed up to 1e5 keys and on a sample of lookups
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "arraylist.h"
+#include "hashmap.h"
+#include "bench.h"
+
+#define SCAN_MAX 100000
+#define SCAN_LOOKUPS 1000
+
+static size_t hash_u64(const void* a){
+    return (size_t) *((const uint64_t*) a);
+}
+
+static int cmp_u64(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void row(const char* container, const char* op, size_t n, size_t ops,
+                uint64_t start, size_t found){
+    printf("%s,%s,%zu,%.2f,%zu\n", container, op, n,
+           (double) (bench_now_ns() - start)/ops, found);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    uint64_t* keys = (uint64_t*) malloc(max*sizeof(uint64_t));
+    uint64_t* misses = (uint64_t*) malloc(max*sizeof(uint64_t));
+    size_t* order = (size_t*) malloc(max*sizeof(size_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t n, i;
+    for(i = 0; i < max; i++){
+        // Odd keys are present and even keys are absent
+        keys[i] = bench_rand(&seed) | 1;
+        misses[i] = keys[i] - 1;
+    }
+
+    printf("container,op,n,ns_per_op,found\n");
+    for(n = 1000; n <= max; n *= 10){
+        for(i = 0; i < n; i++){
+            order[i] = (size_t) (bench_rand(&seed) % n);
+        }
+        hashmap_t map;
+        hashmap_init(&map, hash_u64, cmp_u64);
+        uint64_t start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            hashmap_put(&map, &keys[i], &keys[i]);
+        }
+        row("hashmap", "put", n, n, start, hashmap_size(&map));
+
+        size_t found = 0;
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            found += hashmap_get(&map, &keys[order[i]]) != NULL;
+        }
+        row("hashmap", "get_hit", n, n, start, found);
+
+        found = 0;
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            found += hashmap_containskey(&map, &misses[order[i]]);
+        }
+        row("hashmap", "get_miss", n, n, start, found);
+        hashmap_free(&map);
+
+        if(n <= SCAN_MAX){
+            arraylist_t lst;
+            arraylist_init(&lst);
+            for(i = 0; i < n; i++){
+                arraylist_append(&lst, &keys[i]);
+            }
+            size_t lookups = n < SCAN_LOOKUPS ? n : SCAN_LOOKUPS;
+            found = 0;
+            start = bench_now_ns();
+            for(i = 0; i < lookups; i++){
+                found += arraylist_indexof(&lst, &keys[order[i]], cmp_u64) >= 0;
+            }
+            row("arraylist", "get_hit", n, lookups, start, found);
+            found = 0;
+            start = bench_now_ns();
+            for(i = 0; i < lookups; i++){
+                found += arraylist_indexof(&lst, &misses[order[i]],
+                                           cmp_u64) >= 0;
+            }
+            row("arraylist", "get_miss", n, lookups, start, found);
+            arraylist_free(&lst);
+        }
+        fflush(stdout);
+    }
+    free(order);
+    free(misses);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ Throughput of keyedpriorityqueue against priorityqueue with a comparator on
+ the same integer keys
+
+ usage: bench_keyedpriorityqueue [max elements, default 1e6]
+ Prints one CSV row per (queue, size) pair for sizes 1e3, 1e4, ... up to the
+ maximum
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "priorityqueue.h"
+#include "keyedpriorityqueue.h"
+#include "bench.h"
+
+static int cmp_u64(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void report(const char* name, size_t n, uint64_t add_ns,
+                   uint64_t hold_ns, uint64_t poll_ns){
+    printf("%s,%zu,%.2f,%.2f,%.2f\n", name, n, (double) add_ns/n,
+           (double) hold_ns/n, (double) poll_ns/n);
+    fflush(stdout);
+}
+
+static void run_priorityqueue(const char* name, size_t arity, size_t n,
+                              uint64_t* keys){
+    priorityqueue_t pq;
+    priorityqueue_init_arity(&pq, cmp_u64, arity);
+    size_t i;
+
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        priorityqueue_add(&pq, &keys[i]);
+    }
+    uint64_t add_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        uint64_t* key = (uint64_t*) priorityqueue_poll(&pq);
+        *key += i & 0xffff;
+        priorityqueue_add(&pq, key);
+    }
+    uint64_t hold_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        priorityqueue_poll(&pq);
+    }
+    uint64_t poll_ns = bench_now_ns() - start;
+
+    report(name, n, add_ns, hold_ns, poll_ns);
+    priorityqueue_free(&pq);
+}
+
+static void run_keyed(size_t n, uint64_t* keys){
+    keyedpriorityqueue_t kpq;
+    keyedpriorityqueue_init(&kpq);
+    size_t i;
+
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        keyedpriorityqueue_add(&kpq, keys[i], &keys[i]);
+    }
+    uint64_t add_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        uint64_t key;
+        void* elem = keyedpriorityqueue_poll(&kpq, &key);
+        keyedpriorityqueue_add(&kpq, key + (i & 0xffff), elem);
+    }
+    uint64_t hold_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        keyedpriorityqueue_poll(&kpq, NULL);
+    }
+    uint64_t poll_ns = bench_now_ns() - start;
+
+    report("keyed8", n, add_ns, hold_ns, poll_ns);
+    keyedpriorityqueue_free(&kpq);
+}
+
+static void fill(uint64_t* keys, size_t n){
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t i;
+    for(i = 0; i < n; i++){
+        keys[i] = bench_rand(&seed) >> 16;
+    }
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n;
+
+    printf("queue,n,add_ns_per_op,hold_ns_per_op,poll_ns_per_op\n");
+    for(n = 1000; n <= max; n *= 10){
+        uint64_t* keys = (uint64_t*) malloc(n*sizeof(uint64_t));
+        fill(keys, n);
+        run_priorityqueue("priorityqueue2", 2, n, keys);
+        fill(keys, n);
+        run_priorityqueue("priorityqueue8", 8, n, keys);
+        fill(keys, n);
+        run_keyed(n, keys);
+        free(keys);
+    }
+    return 0;
+}
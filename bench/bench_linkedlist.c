@@ -0,0 +1,73 @@
+/*
+ Node allocation churn of linkedlist with malloc against pools
+
+ usage: bench_linkedlist [max elements, default 1e6]
+ For 1e3, 1e4, ... elements up to the maximum, repeatedly fills a deque to that
+ length and drains it again with a mix of addfirst/addlast and
+ pollfirst/polllast, with nodes from malloc, a private pool and a shared
+ threadsafe pool. Every configuration performs 1e7 node allocations
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "linkedlist.h"
+#include "bench.h"
+
+#define TOTAL_OPS 10000000
+
+static double churn(linkedlist_t* lst, size_t n){
+    size_t rounds = TOTAL_OPS/n > 0 ? TOTAL_OPS/n : 1;
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t r, i;
+    uint64_t start = bench_now_ns();
+    for(r = 0; r < rounds; r++){
+        for(i = 0; i < n; i++){
+            if(bench_rand(&seed) & 1){
+                linkedlist_addfirst(lst, (void*) (uintptr_t) i);
+            }
+            else{
+                linkedlist_addlast(lst, (void*) (uintptr_t) i);
+            }
+        }
+        for(i = 0; i < n; i++){
+            if(bench_rand(&seed) & 1){
+                linkedlist_pollfirst(lst);
+            }
+            else{
+                linkedlist_polllast(lst);
+            }
+        }
+    }
+    return (bench_now_ns() - start)/(double) (rounds*n);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n;
+
+    printf("allocator,elements,ns/element,hitrate\n");
+    for(n = 1000; n <= max; n *= 10){
+        linkedlist_t lst;
+        linkedlist_init_deque(&lst);
+        printf("malloc,%zu,%.2f,0\n", n, churn(&lst, n));
+        linkedlist_free(&lst);
+
+        linkedlist_init_deque(&lst);
+        linkedlist_setpool(&lst, NULL);
+        double ns = churn(&lst, n);
+        printf("private,%zu,%.2f,%.4f\n", n, ns,
+               linkedlist_pool_hitrate(lst.pool));
+        linkedlist_free(&lst);
+
+        linkedlist_pool_t pool;
+        linkedlist_pool_init(&pool, true);
+        linkedlist_init_deque(&lst);
+        linkedlist_setpool(&lst, &pool);
+        ns = churn(&lst, n);
+        linkedlist_free(&lst);
+        linkedlist_pool_flushcache(&pool);
+        printf("shared,%zu,%.2f,%.4f\n", n, ns, linkedlist_pool_hitrate(&pool));
+        linkedlist_pool_free(&pool);
+        fflush(stdout);
+    }
+    return 0;
+}
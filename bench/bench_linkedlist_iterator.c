@@ -0,0 +1,101 @@
+/*
+ Traversal and filtering of a linkedlist by index against an iterator
+
+ usage: bench_linkedlist_iterator [max elements, default 1e6]
+ For 1e3, 1e4, ... elements up to the maximum, times a traversal with get(i)
+ and with an iterator, and removing every other element with remove(i) and
+ with iterator_remove and removeif. The indexed loops walk from the start for
+ every element, so they are only timed up to 1e5 elements
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "linkedlist.h"
+#include "bench.h"
+
+#define INDEXED_MAX 100000
+
+static void row(const char* op, size_t n, size_t ops, uint64_t start,
+                uint64_t check){
+    printf("linkedlist,%s,%zu,%.2f,%llu\n", op, n,
+           (double) (bench_now_ns() - start)/ops, (unsigned long long) check);
+}
+
+static void fill(linkedlist_t* lst, size_t n){
+    size_t i;
+    linkedlist_init(lst);
+    for(i = 0; i < n; i++){
+        linkedlist_append(lst, (void*) (uintptr_t) i);
+    }
+}
+
+static void add_check(void* data, void* arg){
+    *((uint64_t*) arg) += (uintptr_t) data;
+}
+
+static bool is_even(const void* data, void* arg){
+    (void) arg;
+    return (uintptr_t) data % 2 == 0;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n, i;
+
+    printf("container,op,n,ns_per_op,check\n");
+    for(n = 1000; n <= max; n *= 10){
+        linkedlist_t lst;
+        linkedlist_iterator_t it;
+        uint64_t check, start;
+        fill(&lst, n);
+        if(n <= INDEXED_MAX){
+            check = 0;
+            start = bench_now_ns();
+            for(i = 0; i < n; i++){
+                check += (uintptr_t) linkedlist_get(&lst, i);
+            }
+            row("get_traverse", n, n, start, check);
+        }
+
+        check = 0;
+        start = bench_now_ns();
+        linkedlist_iterator(&lst, &it);
+        while(linkedlist_iterator_hasnext(&it)){
+            check += (uintptr_t) linkedlist_iterator_next(&it);
+        }
+        row("iterator_traverse", n, n, start, check);
+
+        check = 0;
+        start = bench_now_ns();
+        linkedlist_foreach(&lst, add_check, &check);
+        row("foreach", n, n, start, check);
+
+        // Every other element removed, reported per element visited
+        if(n <= INDEXED_MAX){
+            start = bench_now_ns();
+            for(i = 0; i < linkedlist_length(&lst); i++){
+                linkedlist_remove(&lst, i);
+            }
+            row("remove_filter", n, n, start, linkedlist_length(&lst));
+            linkedlist_free(&lst);
+            fill(&lst, n);
+        }
+
+        start = bench_now_ns();
+        linkedlist_iterator(&lst, &it);
+        while(linkedlist_iterator_hasnext(&it)){
+            if(is_even(linkedlist_iterator_next(&it), NULL)){
+                linkedlist_iterator_remove(&it);
+            }
+        }
+        row("iterator_filter", n, n, start, linkedlist_length(&lst));
+        linkedlist_free(&lst);
+
+        fill(&lst, n);
+        start = bench_now_ns();
+        linkedlist_removeif(&lst, is_even, NULL);
+        row("removeif", n, n, start, linkedlist_length(&lst));
+        linkedlist_free(&lst);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ Persisting and reloading a list of records with mappedlist against writing
+ out an arraylist element by element
+
+ usage: bench_mappedlist [max records, default 1e6]
+ Saves 64 byte records to a temporary file and loads them back for 1e4, 1e5,
+ ... records up to the maximum. The arraylist is saved by writing each element
+ and loaded by reading and mallocing each element again. The mappedlist is
+ saved by closing it and loaded by mapping the file. scan_ms is the time to
+ sum a field of every loaded record, which for the mappedlist includes
+ faulting its pages in from the page cache
+*/
+#include <stdio.h>
+#include <unistd.h>
+#include "arraylist.h"
+#include "mappedlist.h"
+#include "bench.h"
+
+typedef struct record_t{
+    uint64_t id;
+    uint64_t fields[7];
+} record_t;
+
+static double ms_since(uint64_t start){
+    return (bench_now_ns() - start)/1e6;
+}
+
+static void bench_arraylist(const char* path, size_t n){
+    arraylist_t lst;
+    arraylist_init(&lst);
+    size_t i;
+    for(i = 0; i < n; i++){
+        record_t* rec = (record_t*) calloc(1, sizeof(record_t));
+        rec->id = i;
+        arraylist_append(&lst, rec);
+    }
+    uint64_t start = bench_now_ns();
+    FILE* f = fopen(path, "wb");
+    void** ary = arraylist_toarray(&lst);
+    for(i = 0; i < n; i++){
+        fwrite(ary[i], sizeof(record_t), 1, f);
+    }
+    fclose(f);
+    double save = ms_since(start);
+    for(i = 0; i < n; i++){
+        free(arraylist_get(&lst, i));
+    }
+    arraylist_free(&lst);
+
+    start = bench_now_ns();
+    arraylist_init(&lst);
+    f = fopen(path, "rb");
+    record_t* rec = (record_t*) malloc(sizeof(record_t));
+    while(fread(rec, sizeof(record_t), 1, f) == 1){
+        arraylist_append(&lst, rec);
+        rec = (record_t*) malloc(sizeof(record_t));
+    }
+    free(rec);
+    fclose(f);
+    double load = ms_since(start);
+
+    start = bench_now_ns();
+    uint64_t sum = 0;
+    for(i = 0; i < arraylist_length(&lst); i++){
+        sum += ((record_t*) arraylist_get(&lst, i))->id;
+    }
+    double scan = ms_since(start);
+    printf("arraylist,%zu,%.3f,%.3f,%.3f,%llu\n", n, save, load, scan,
+           (unsigned long long) sum);
+    for(i = 0; i < arraylist_length(&lst); i++){
+        free(arraylist_get(&lst, i));
+    }
+    arraylist_free(&lst);
+}
+
+static void bench_mappedlist(const char* path, size_t n){
+    unlink(path);
+    mappedlist_t ml;
+    mappedlist_open(&ml, path, sizeof(record_t), false);
+    record_t rec = {0, {0}};
+    size_t i;
+    for(i = 0; i < n; i++){
+        rec.id = i;
+        mappedlist_append(&ml, &rec);
+    }
+    uint64_t start = bench_now_ns();
+    mappedlist_close(&ml);
+    double save = ms_since(start);
+
+    start = bench_now_ns();
+    mappedlist_open(&ml, path, sizeof(record_t), true);
+    double load = ms_since(start);
+
+    start = bench_now_ns();
+    const record_t* recs = (const record_t*) mappedlist_toarray(&ml);
+    uint64_t sum = 0;
+    for(i = 0; i < mappedlist_length(&ml); i++){
+        sum += recs[i].id;
+    }
+    double scan = ms_since(start);
+    printf("mappedlist,%zu,%.3f,%.3f,%.3f,%llu\n", n, save, load, scan,
+           (unsigned long long) sum);
+    mappedlist_close(&ml);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    char path[] = "/tmp/bench_mappedlist_XXXXXX";
+    int fd = mkstemp(path);
+    if(fd < 0){
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    printf("list,records,save_ms,load_ms,scan_ms,checksum\n");
+    size_t n;
+    for(n = 10000; n <= max; n *= 10){
+        bench_arraylist(path, n);
+        bench_mappedlist(path, n);
+        fflush(stdout);
+    }
+    unlink(path);
+    return 0;
+}
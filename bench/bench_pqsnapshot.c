@@ -0,0 +1,85 @@
+/*
+ Warm restart of a priorityqueue from a snapshot against re-adding every
+ element
+
+ usage: bench_pqsnapshot [max elements, default 1e6]
+ Saves a queue of random 32 bit keys to a temporary file and rebuilds it, once
+ by reading the keys and adding them one by one and once with
+ priorityqueue_restore, for 1e4, 1e5, ... elements up to the maximum. Both
+ decode the keys into the same array. Built with NDEBUG, so restore does not
+ validate the heap
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include "priorityqueue.h"
+#include "bench.h"
+
+static uint32_t* decoded;
+static size_t ndecoded;
+
+static int cmp_u32(const void* a, const void* b){
+    uint32_t x = *((const uint32_t*) a);
+    uint32_t y = *((const uint32_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void encode_u32(const void* elem, void* buf){
+    memcpy(buf, elem, sizeof(uint32_t));
+}
+
+static void* decode_u32(const void* buf){
+    uint32_t* elem = &decoded[ndecoded++];
+    memcpy(elem, buf, sizeof(uint32_t));
+    return elem;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    uint32_t* keys = (uint32_t*) malloc(max*sizeof(uint32_t));
+    decoded = (uint32_t*) malloc(max*sizeof(uint32_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t n, i;
+    for(i = 0; i < max; i++){
+        keys[i] = (uint32_t) bench_rand(&seed);
+    }
+
+    printf("restart,n,ms,min\n");
+    for(n = 10000; n <= max; n *= 10){
+        priorityqueue_t pq;
+        priorityqueue_init_arity(&pq, cmp_u32, 4);
+        for(i = 0; i < n; i++){
+            priorityqueue_add(&pq, &keys[i]);
+        }
+        FILE* f = tmpfile();
+        priorityqueue_snapshot(&pq, f, sizeof(uint32_t), encode_u32);
+        priorityqueue_free(&pq);
+
+        // Re-adding reads the same bytes, skipping the snapshot header
+        uint64_t start = bench_now_ns();
+        fseek(f, 32, SEEK_SET);
+        ndecoded = fread(decoded, sizeof(uint32_t), n, f);
+        priorityqueue_init_arity(&pq, cmp_u32, 4);
+        for(i = 0; i < ndecoded; i++){
+            priorityqueue_add(&pq, &decoded[i]);
+        }
+        double ms = (bench_now_ns() - start)/1e6;
+        printf("add,%zu,%.3f,%u\n", n, ms,
+               *((uint32_t*) priorityqueue_peek(&pq)));
+        priorityqueue_free(&pq);
+
+        rewind(f);
+        ndecoded = 0;
+        start = bench_now_ns();
+        priorityqueue_restore(&pq, cmp_u32, f, decode_u32);
+        ms = (bench_now_ns() - start)/1e6;
+        printf("restore,%zu,%.3f,%u\n", n, ms,
+               *((uint32_t*) priorityqueue_peek(&pq)));
+        priorityqueue_free(&pq);
+        fclose(f);
+        fflush(stdout);
+    }
+    free(decoded);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ Throughput of priorityqueue add and poll for different heap arities
+
+ usage: bench_priorityqueue [max elements, default 1e6]
+ Prints one CSV row per (arity, size) pair for sizes 1e3, 1e4, ... up to the
+ maximum
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "priorityqueue.h"
+#include "bench.h"
+
+static int cmp_u32(const void* a, const void* b){
+    uint32_t x = *((const uint32_t*) a);
+    uint32_t y = *((const uint32_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void run(size_t arity, size_t n, uint32_t* keys){
+    priorityqueue_t pq;
+    priorityqueue_init_arity(&pq, cmp_u32, arity);
+    size_t i;
+
+    uint64_t start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        priorityqueue_add(&pq, &keys[i]);
+    }
+    uint64_t add_ns = bench_now_ns() - start;
+
+    // Hold model: poll the minimum and re-add it with a later key
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        uint32_t* key = (uint32_t*) priorityqueue_poll(&pq);
+        *key += (uint32_t) (i & 0xffff);
+        priorityqueue_add(&pq, key);
+    }
+    uint64_t hold_ns = bench_now_ns() - start;
+
+    start = bench_now_ns();
+    for(i = 0; i < n; i++){
+        priorityqueue_poll(&pq);
+    }
+    uint64_t poll_ns = bench_now_ns() - start;
+
+    printf("%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f\n", arity, n,
+           (double) add_ns/n, (double) poll_ns/n, (double) hold_ns/n,
+           n*1e3/add_ns, n*1e3/poll_ns);
+    fflush(stdout);
+    priorityqueue_free(&pq);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t arities[3] = {2, 4, 8};
+    size_t n, a, i;
+
+    printf("arity,n,add_ns_per_op,poll_ns_per_op,hold_ns_per_op,"
+           "add_mops,poll_mops\n");
+    for(n = 1000; n <= max; n *= 10){
+        uint32_t* keys = (uint32_t*) malloc(n*sizeof(uint32_t));
+        for(a = 0; a < 3; a++){
+            uint64_t seed = 0x9E3779B97F4A7C15ull;
+            for(i = 0; i < n; i++){
+                keys[i] = (uint32_t) bench_rand(&seed);
+            }
+            run(arities[a], n, keys);
+        }
+        free(keys);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ Dijkstra's algorithm with radixheap against priorityqueue
+
+ usage: bench_radixheap [max nodes, default 1e6]
+ Runs single source shortest paths on random graphs with 4 edges per node and
+ weights in [1, 1000] for 1e3, 1e4, ... nodes up to the maximum. Both queues
+ use lazy deletion, pushing a new entry whenever a distance improves
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "priorityqueue.h"
+#include "radixheap.h"
+#include "bench.h"
+
+#define DEGREE 4
+
+typedef struct graph_t{
+    size_t n;
+    uint32_t* targets; // DEGREE targets per node
+    uint32_t* weights; // DEGREE weights per node
+} graph_t;
+
+typedef struct entry_t{
+    uint64_t dist;
+    uint32_t node;
+} entry_t;
+
+static int cmp_entry(const void* a, const void* b){
+    uint64_t x = ((const entry_t*) a)->dist;
+    uint64_t y = ((const entry_t*) b)->dist;
+    return (x > y) - (x < y);
+}
+
+static uint64_t dijkstra_priorityqueue(const graph_t* g, uint64_t* dist,
+                                       entry_t* entries){
+    priorityqueue_t pq;
+    priorityqueue_init(&pq, cmp_entry);
+    size_t nentries = 0;
+    uint64_t checksum = 0;
+    entries[nentries] = (entry_t) {0, 0};
+    dist[0] = 0;
+    priorityqueue_add(&pq, &entries[nentries++]);
+    entry_t* e;
+    while((e = (entry_t*) priorityqueue_poll(&pq)) != NULL){
+        if(e->dist != dist[e->node]){
+            continue;
+        }
+        checksum += e->dist;
+        size_t k;
+        for(k = 0; k < DEGREE; k++){
+            uint32_t v = g->targets[e->node*DEGREE + k];
+            uint64_t d = e->dist + g->weights[e->node*DEGREE + k];
+            if(d < dist[v]){
+                dist[v] = d;
+                entries[nentries] = (entry_t) {d, v};
+                priorityqueue_add(&pq, &entries[nentries++]);
+            }
+        }
+    }
+    priorityqueue_free(&pq);
+    return checksum;
+}
+
+static uint64_t dijkstra_radixheap(const graph_t* g, uint64_t* dist){
+    radixheap_t rh;
+    radixheap_init(&rh);
+    uint64_t checksum = 0;
+    dist[0] = 0;
+    radixheap_add(&rh, 0, (void*) (uintptr_t) 0);
+    uint64_t du;
+    while(radixheap_size(&rh) > 0){
+        uint32_t u = (uint32_t) (uintptr_t) radixheap_poll(&rh, &du);
+        if(du != dist[u]){
+            continue;
+        }
+        checksum += du;
+        size_t k;
+        for(k = 0; k < DEGREE; k++){
+            uint32_t v = g->targets[u*DEGREE + k];
+            uint64_t d = du + g->weights[u*DEGREE + k];
+            if(d < dist[v]){
+                dist[v] = d;
+                radixheap_add(&rh, d, (void*) (uintptr_t) v);
+            }
+        }
+    }
+    radixheap_free(&rh);
+    return checksum;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n, i;
+
+    printf("queue,nodes,ms,checksum\n");
+    for(n = 1000; n <= max; n *= 10){
+        graph_t g = {n, (uint32_t*) malloc(n*DEGREE*sizeof(uint32_t)),
+                     (uint32_t*) malloc(n*DEGREE*sizeof(uint32_t))};
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for(i = 0; i < n*DEGREE; i++){
+            g.targets[i] = (uint32_t) (bench_rand(&seed) % n);
+            g.weights[i] = (uint32_t) (bench_rand(&seed) % 1000) + 1;
+        }
+        uint64_t* dist = (uint64_t*) malloc(n*sizeof(uint64_t));
+        entry_t* entries = (entry_t*) malloc((n*DEGREE + 1)*sizeof(entry_t));
+
+        for(i = 0; i < n; i++){
+            dist[i] = UINT64_MAX;
+        }
+        uint64_t start = bench_now_ns();
+        uint64_t sum = dijkstra_priorityqueue(&g, dist, entries);
+        printf("priorityqueue,%zu,%.3f,%llu\n", n,
+               (bench_now_ns() - start)/1e6, (unsigned long long) sum);
+
+        for(i = 0; i < n; i++){
+            dist[i] = UINT64_MAX;
+        }
+        start = bench_now_ns();
+        sum = dijkstra_radixheap(&g, dist);
+        printf("radixheap,%zu,%.3f,%llu\n", n,
+               (bench_now_ns() - start)/1e6, (unsigned long long) sum);
+        fflush(stdout);
+
+        free(entries);
+        free(dist);
+        free(g.weights);
+        free(g.targets);
+    }
+    return 0;
+}
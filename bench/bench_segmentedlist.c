@@ -0,0 +1,90 @@
+/*
+ Append latency of segmentedlist against arraylist
+
+ usage: bench_segmentedlist [max elements, default 1e7]
+ Times every single append while filling each list to 1e5, 1e6, ... elements
+ up to the maximum, and reports latency percentiles and the total time.
+ Latencies include the cost of reading the clock twice
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arraylist.h"
+#include "segmentedlist.h"
+#include "bench.h"
+
+// Latencies below HIST_LINEAR ns are counted exactly, longer ones in buckets
+// of powers of two
+#define HIST_LINEAR 1024
+#define HIST_BUCKETS (HIST_LINEAR + 64)
+
+typedef struct hist_t{
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} hist_t;
+
+static void hist_add(hist_t* h, uint64_t ns){
+    size_t b = ns < HIST_LINEAR ? ns :
+               HIST_LINEAR + 63 - __builtin_clzll(ns) - 10;
+    h->counts[b]++;
+    h->total++;
+    h->max = ns > h->max ? ns : h->max;
+}
+
+// Returns an upper bound on the latency of the given percentile
+static uint64_t hist_percentile(const hist_t* h, double p){
+    uint64_t want = (uint64_t) (p/100*h->total);
+    uint64_t seen = 0;
+    size_t b;
+    for(b = 0; b < HIST_BUCKETS; b++){
+        seen += h->counts[b];
+        if(seen > want){
+            return b < HIST_LINEAR ? b : 2ull << (b - HIST_LINEAR + 10);
+        }
+    }
+    return h->max;
+}
+
+static void report(const char* name, size_t n, const hist_t* h, uint64_t ns){
+    printf("%s,%zu,%llu,%llu,%llu,%llu,%.3f\n", name, n,
+           (unsigned long long) hist_percentile(h, 50),
+           (unsigned long long) hist_percentile(h, 99),
+           (unsigned long long) hist_percentile(h, 99.9),
+           (unsigned long long) h->max, ns/1e6);
+    fflush(stdout);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 10000000);
+    static hist_t h;
+    size_t n, i;
+
+    printf("list,elements,p50_ns,p99_ns,p99.9_ns,max_ns,total_ms\n");
+    for(n = 100000; n <= max; n *= 10){
+        arraylist_t al;
+        arraylist_init(&al);
+        memset(&h, 0, sizeof(h));
+        uint64_t start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            uint64_t t = bench_now_ns();
+            arraylist_append(&al, (void*) (uintptr_t) i);
+            hist_add(&h, bench_now_ns() - t);
+        }
+        report("arraylist", n, &h, bench_now_ns() - start);
+        arraylist_free(&al);
+
+        segmentedlist_t sl;
+        segmentedlist_init(&sl);
+        memset(&h, 0, sizeof(h));
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            uint64_t t = bench_now_ns();
+            segmentedlist_append(&sl, (void*) (uintptr_t) i);
+            hist_add(&h, bench_now_ns() - t);
+        }
+        report("segmentedlist", n, &h, bench_now_ns() - start);
+        segmentedlist_free(&sl);
+    }
+    return 0;
+}
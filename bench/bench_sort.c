@@ -0,0 +1,81 @@
+/*
+ arraylist_sort and arraylist_parallel_sort against qsort
+
+ usage: bench_sort [max elements, default 1e7]
+ Sorts lists of pointers to random 64 bit keys for 1e5, 1e6, ... elements up
+ to the maximum. qsort sorts a copy of the same pointer array. The parallel
+ sort runs on threadpool_default(), which has one thread per online processor
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "arraylist.h"
+#include "threadpool.h"
+#include "bench.h"
+
+static int cmp_key(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+// qsort passes pointers to the array slots rather than the elements
+static int cmp_slot(const void* a, const void* b){
+    return cmp_key(*((void* const*) a), *((void* const*) b));
+}
+
+static int is_sorted(void** ary, size_t n){
+    size_t i;
+    for(i = 1; i < n; i++){
+        if(cmp_key(ary[i - 1], ary[i]) > 0){
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 10000000);
+    size_t n, i;
+    threadpool_t* pool = threadpool_default();
+
+    printf("sort,elements,threads,ms,sorted\n");
+    for(n = 100000; n <= max; n *= 10){
+        uint64_t* keys = (uint64_t*) malloc(n*sizeof(uint64_t));
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for(i = 0; i < n; i++){
+            keys[i] = bench_rand(&seed);
+        }
+        arraylist_t lst;
+        arraylist_init(&lst);
+
+        int method;
+        for(method = 0; method < 3; method++){
+            arraylist_clear(&lst);
+            for(i = 0; i < n; i++){
+                arraylist_append(&lst, &keys[i]);
+            }
+            void** ary = arraylist_toarray(&lst);
+            uint64_t start = bench_now_ns();
+            if(method == 0){
+                qsort(ary, n, sizeof(void*), cmp_slot);
+            }
+            else if(method == 1){
+                arraylist_sort(&lst, cmp_key);
+            }
+            else{
+                arraylist_parallel_sort(&lst, cmp_key, pool);
+            }
+            double ms = (bench_now_ns() - start)/1e6;
+            const char* names[] = {"qsort", "arraylist_sort",
+                                   "arraylist_parallel_sort"};
+            printf("%s,%zu,%zu,%.3f,%d\n", names[method], n,
+                   method == 2 && pool ? threadpool_parallelism(pool) : 1, ms,
+                   is_sorted(arraylist_toarray(&lst), n));
+            fflush(stdout);
+        }
+        arraylist_free(&lst);
+        free(keys);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ Ordered lookups and range scans with treemap against a sorted arraylist
+
+ usage: bench_treemap [max keys, default 1e6]
+ Inserts random 64 bit keys for 1e3, 1e4, ... keys up to the maximum, then
+ times lookups in random order, scans of RANGE keys starting at random keys
+ and a scan of every key. The arraylist is kept sorted with
+ arraylist_add_sorted and binarysearch, and its inserts are only timed up to
+ 1e5 keys since each one shifts half the list; larger lists are sorted once
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "arraylist.h"
+#include "treemap.h"
+#include "bench.h"
+
+#define SORTED_INSERT_MAX 100000
+#define RANGE 100
+
+static int cmp_u64(const void* a, const void* b){
+    uint64_t x = *((const uint64_t*) a);
+    uint64_t y = *((const uint64_t*) b);
+    return (x > y) - (x < y);
+}
+
+static void row(const char* container, const char* op, size_t n, size_t ops,
+                uint64_t start, uint64_t check){
+    printf("%s,%s,%zu,%.2f,%llu\n", container, op, n,
+           (double) (bench_now_ns() - start)/ops, (unsigned long long) check);
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    uint64_t* keys = (uint64_t*) malloc(max*sizeof(uint64_t));
+    size_t* order = (size_t*) malloc(max*sizeof(size_t));
+    uint64_t seed = 0x9E3779B97F4A7C15ull;
+    size_t n, i, j;
+    for(i = 0; i < max; i++){
+        keys[i] = bench_rand(&seed);
+    }
+
+    printf("container,op,n,ns_per_op,check\n");
+    for(n = 1000; n <= max; n *= 10){
+        for(i = 0; i < n; i++){
+            order[i] = (size_t) (bench_rand(&seed) % n);
+        }
+        size_t scans = n/RANGE;
+        uint64_t check = 0;
+
+        treemap_t map;
+        treemap_init(&map, cmp_u64);
+        uint64_t start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            treemap_put(&map, &keys[i], &keys[i]);
+        }
+        row("treemap", "put", n, n, start, treemap_size(&map));
+
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            check += treemap_get(&map, &keys[order[i]]) != NULL;
+        }
+        row("treemap", "get", n, n, start, check);
+
+        // Ranges of RANGE consecutive keys, reported per key visited
+        check = 0;
+        start = bench_now_ns();
+        for(i = 0; i < scans; i++){
+            treemap_iterator_t it;
+            treemap_iterator(&map, &it, &keys[order[i]], NULL);
+            for(j = 0; j < RANGE && treemap_iterator_hasnext(&it); j++){
+                check += *(uint64_t*) treemap_iterator_next(&it, NULL) >> 32;
+            }
+        }
+        row("treemap", "range_scan", n, scans*RANGE, start, check);
+
+        check = 0;
+        start = bench_now_ns();
+        treemap_iterator_t it;
+        treemap_iterator(&map, &it, NULL, NULL);
+        while(treemap_iterator_hasnext(&it)){
+            check += *(uint64_t*) treemap_iterator_next(&it, NULL) >> 32;
+        }
+        row("treemap", "full_scan", n, n, start, check);
+        treemap_free(&map);
+
+        arraylist_t lst;
+        arraylist_init(&lst);
+        if(n <= SORTED_INSERT_MAX){
+            start = bench_now_ns();
+            for(i = 0; i < n; i++){
+                arraylist_add_sorted(&lst, &keys[i], cmp_u64);
+            }
+            row("arraylist", "put", n, n, start, arraylist_length(&lst));
+        }
+        else{
+            for(i = 0; i < n; i++){
+                arraylist_append(&lst, &keys[i]);
+            }
+            arraylist_sort(&lst, cmp_u64);
+        }
+
+        check = 0;
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            check += arraylist_binarysearch(&lst, &keys[order[i]],
+                                            cmp_u64) >= 0;
+        }
+        row("arraylist", "get", n, n, start, check);
+
+        check = 0;
+        start = bench_now_ns();
+        for(i = 0; i < scans; i++){
+            ptrdiff_t ind = arraylist_binarysearch(&lst, &keys[order[i]],
+                                                   cmp_u64);
+            for(j = (size_t) ind; j < (size_t) ind + RANGE && j < n; j++){
+                check += *(uint64_t*) arraylist_get(&lst, j) >> 32;
+            }
+        }
+        row("arraylist", "range_scan", n, scans*RANGE, start, check);
+
+        check = 0;
+        start = bench_now_ns();
+        for(i = 0; i < n; i++){
+            check += *(uint64_t*) arraylist_get(&lst, i) >> 32;
+        }
+        row("arraylist", "full_scan", n, n, start, check);
+        arraylist_free(&lst);
+        fflush(stdout);
+    }
+    free(order);
+    free(keys);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ Traversal and positional access of unrolledlist against linkedlist
+
+ usage: bench_unrolledlist [max elements, default 1e6]
+ For 1e3, 1e4, ... elements up to the maximum, builds both lists by appending
+ and times a full indexof scan for a missing element, 1000 gets at random
+ indices and 1000 adds and removes at random indices. The linkedlist is built
+ by inserting near its front so that consecutive nodes are scattered across the
+ heap as they are after long use
+*/
+#include <stdio.h>
+#include <stdint.h>
+#include "linkedlist.h"
+#include "unrolledlist.h"
+#include "bench.h"
+
+#define RANDOM_OPS 1000
+
+static int cmp_ptr(const void* a, const void* b){
+    return a != b;
+}
+
+int main(int argc, char const *argv[]){
+    size_t max = bench_maxsize(argc, argv, 1000000);
+    size_t n, i;
+    int missing;
+
+    printf("list,elements,indexof_ns_per_elem,get_us_per_op,"
+           "addremove_us_per_op\n");
+    for(n = 1000; n <= max; n *= 10){
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        linkedlist_t ll;
+        linkedlist_init(&ll);
+        for(i = 0; i < n; i++){
+            linkedlist_add(&ll, bench_rand(&seed) % (i < 64 ? i + 1 : 64),
+                           (void*) (uintptr_t) (i + 1));
+        }
+        unrolledlist_t ul;
+        unrolledlist_init(&ul);
+        for(i = 0; i < n; i++){
+            unrolledlist_append(&ul, (void*) (uintptr_t) (i + 1));
+        }
+
+        uint64_t start = bench_now_ns();
+        linkedlist_indexof(&ll, &missing, cmp_ptr);
+        double scan = (bench_now_ns() - start)/(double) n;
+        seed = 0x2545F4914F6CDD1Dull;
+        start = bench_now_ns();
+        for(i = 0; i < RANDOM_OPS; i++){
+            linkedlist_get(&ll, bench_rand(&seed) % n);
+        }
+        double get = (bench_now_ns() - start)/1e3/RANDOM_OPS;
+        start = bench_now_ns();
+        for(i = 0; i < RANDOM_OPS; i++){
+            size_t ind = bench_rand(&seed) % n;
+            linkedlist_add(&ll, ind, (void*) 1);
+            linkedlist_remove(&ll, ind);
+        }
+        double addremove = (bench_now_ns() - start)/1e3/RANDOM_OPS;
+        printf("linkedlist,%zu,%.2f,%.3f,%.3f\n", n, scan, get, addremove);
+
+        start = bench_now_ns();
+        unrolledlist_indexof(&ul, &missing, cmp_ptr);
+        scan = (bench_now_ns() - start)/(double) n;
+        seed = 0x2545F4914F6CDD1Dull;
+        start = bench_now_ns();
+        for(i = 0; i < RANDOM_OPS; i++){
+            unrolledlist_get(&ul, bench_rand(&seed) % n);
+        }
+        get = (bench_now_ns() - start)/1e3/RANDOM_OPS;
+        start = bench_now_ns();
+        for(i = 0; i < RANDOM_OPS; i++){
+            size_t ind = bench_rand(&seed) % n;
+            unrolledlist_add(&ul, ind, (void*) 1);
+            unrolledlist_remove(&ul, ind);
+        }
+        addremove = (bench_now_ns() - start)/1e3/RANDOM_OPS;
+        printf("unrolledlist,%zu,%.2f,%.3f,%.3f\n", n, scan, get, addremove);
+        fflush(stdout);
+
+        unrolledlist_free(&ul);
+        linkedlist_free(&ll);
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ Pluggable memory allocators for the containers
+
+ An allocator_t is a table of functions. Concrete allocators embed it as their
+ first member, so a pointer to an arena_t or poolallocator_t is also a pointer
+ to an allocator_t. Containers initialized with an allocator take all of their
+ memory from it, and a NULL allocator means malloc, realloc and free. Every
+ call passes the size of the block, so allocators need not store it.
+
+ Containers in an arena may be abandoned without freeing them: arena_reset or
+ arena_free releases all of their memory at once.
+*/
+
+typedef struct allocator_t allocator_t;
+struct allocator_t{
+    // Returns size bytes aligned to align, a power of two, or NULL
+    void* (*alloc)(allocator_t*, size_t size, size_t align);
+    // Grows or shrinks a block from alloc with the default alignment like
+    // realloc. Returns NULL and leaves the block untouched on failure
+    void* (*resize)(allocator_t*, void* ptr, size_t oldsize, size_t size);
+    // Releases a block of the given size
+    void (*free)(allocator_t*, void* ptr, size_t size);
+};
+
+typedef struct arena_t arena_t;
+struct arena_t{
+    allocator_t allocator; // Function table, so an arena_t* is an allocator_t*
+    void* blocks;          // Allocated blocks, linked through their first word
+    char* bump;            // Next free byte in the newest block
+    char* end;             // End of the newest block
+    char* last;            // Newest allocation, which can grow in place
+    size_t blocksize;      // Usable bytes of a regular block
+    size_t allocated;      // Bytes handed out since init or the last reset
+};
+
+typedef struct poolallocator_t poolallocator_t;
+struct poolallocator_t{
+    allocator_t allocator; // Function table, so a poolallocator_t* is an
+                           // allocator_t*
+    size_t objsize;        // Bytes per object, a multiple of sizeof(void*)
+    void* slabs;           // Allocated slabs, linked through their first word
+    char* bump;            // Next unused object in the newest slab
+    char* end;             // End of the newest slab
+    void* freelist;        // Released objects, linked through their first word
+};
+
+extern const size_t allocator_default_align;
+
+/**
+ * Allocate size bytes aligned to align from an allocator, or from malloc if it
+ * is NULL
+ */
+static inline void* allocator_alloc(allocator_t* a, size_t size, size_t align){
+    if(a != NULL){
+        return a->alloc(a, size, align);
+    }
+    if(align <= allocator_default_align){
+        return malloc(size);
+    }
+    return aligned_alloc(align, (size + align - 1) & ~(align - 1));
+}
+
+/**
+ * Resize a block with the default alignment from an allocator, or with realloc
+ * if it is NULL
+ */
+static inline void* allocator_resize(allocator_t* a, void* ptr, size_t oldsize,
+                                     size_t size){
+    if(a != NULL){
+        return a->resize(a, ptr, oldsize, size);
+    }
+    return realloc(ptr, size);
+}
+
+/**
+ * Release a block to an allocator, or to free if it is NULL
+ */
+static inline void allocator_free(allocator_t* a, void* ptr, size_t size){
+    if(a != NULL){
+        a->free(a, ptr, size);
+    }
+    else{
+        free(ptr);
+    }
+}
+
+bool arena_init(arena_t*, size_t blocksize);
+void arena_reset(arena_t*);
+void arena_free(arena_t*);
+size_t arena_allocated(const arena_t*);
+
+bool poolallocator_init(poolallocator_t*, size_t objsize);
+void poolallocator_free(poolallocator_t*);
+
+#endif
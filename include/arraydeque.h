@@ -0,0 +1,41 @@
+#ifndef ARRAYDEQUE_H
+#define ARRAYDEQUE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ A double ended queue in a circular buffer
+
+ The buffer size is always a power of 2, so positions wrap with a mask. The
+ elements occupy at most two contiguous runs of the buffer: from head to the
+ end of the buffer, and from the start of the buffer on.
+*/
+
+typedef struct arraydeque_t arraydeque_t;
+struct arraydeque_t{
+    void** data;   // Circular buffer of data pointers
+    size_t head;   // Index in data of the first element
+    size_t length; // # of elements in the deque
+    size_t size;   // # of slots in data, a power of 2
+};
+
+bool arraydeque_init(arraydeque_t*);
+void arraydeque_free(arraydeque_t*);
+bool arraydeque_reserve(arraydeque_t*, const size_t);
+
+bool arraydeque_addfirst(arraydeque_t*, void*);
+bool arraydeque_addlast(arraydeque_t*, void*);
+bool arraydeque_addall(arraydeque_t*, void**, const size_t);
+void* arraydeque_pollfirst(arraydeque_t*);
+void* arraydeque_polllast(arraydeque_t*);
+size_t arraydeque_drainto(arraydeque_t*, void**, const size_t);
+void arraydeque_clear(arraydeque_t*);
+
+void* arraydeque_peekfirst(const arraydeque_t*);
+void* arraydeque_peeklast(const arraydeque_t*);
+void* arraydeque_get(const arraydeque_t*, const size_t);
+size_t arraydeque_length(const arraydeque_t*);
+
+#endif
@@ -3,18 +3,36 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include "threadpool.h"
+#include "javautil_stats.h"
+#include "allocator.h"
 
 typedef struct arraylist_t arraylist_t;
 struct arraylist_t{
-    void** list;   // The array of pointers to data
-    size_t length; // The number of spaces in the list that have been filled
-    size_t size;   // The number of allocated spaces in the list
+    void** list;    // The array of pointers to data
+    size_t length;  // The number of spaces in the list that have been filled
+    size_t size;    // The number of allocated spaces in the list
+    size_t gap;     // Index of the unused spaces within the list. Equal to
+                    // length unless the list is in gap buffer mode
+    bool gapbuffer; // Whether the unused spaces move to each edit
+    allocator_t* alloc; // Allocator for list, or NULL for malloc
+#ifdef JAVAUTIL_STATS
+    javautil_stats_t stats; // Instrumentation counters
+#endif
 };
 
+extern const size_t arraylist_initsize;
+extern const size_t arraylist_resize_factor;
+
 bool arraylist_init(arraylist_t*);
+bool arraylist_init_allocator(arraylist_t*, allocator_t*);
 void arraylist_free(arraylist_t*);
 bool arraylist_resize(arraylist_t*, const size_t);
 bool arraylist_reserve(arraylist_t*, const size_t);
+void arraylist_setgapbuffer(arraylist_t*, bool);
+void arraylist_stats(const arraylist_t*, javautil_stats_t*);
+void arraylist_resetstats(arraylist_t*);
 
 bool arraylist_append(arraylist_t*, void*);
 bool arraylist_add(arraylist_t*, const size_t, void*);
@@ -23,9 +41,18 @@ void* arraylist_remove(arraylist_t*, const size_t);
 void arraylist_clear(arraylist_t*);
 
 size_t arraylist_length(const arraylist_t*);
-void** arraylist_toarray(const arraylist_t*);
+void** arraylist_toarray(arraylist_t*);
 void* arraylist_get(const arraylist_t*, const size_t);
 ptrdiff_t arraylist_indexof(const arraylist_t*, const void*, 
                             int (*)(const void*, const void*));
+ptrdiff_t arraylist_indexof_identity(const arraylist_t*, const void*);
+ptrdiff_t arraylist_binarysearch(const arraylist_t*, const void*,
+                                 int (*)(const void*, const void*));
+bool arraylist_add_sorted(arraylist_t*, void*,
+                          int (*)(const void*, const void*));
+
+void arraylist_sort(arraylist_t*, int (*)(const void*, const void*));
+void arraylist_parallel_sort(arraylist_t*, int (*)(const void*, const void*),
+                             threadpool_t*);
 
 #endif
@@ -0,0 +1,166 @@
+#ifndef ARRAYLIST_TEMPLATE_H
+#define ARRAYLIST_TEMPLATE_H
+
+/*
+ Type-specialized arraylist templates
+
+ arraylist_t stores an array of pointers, so each element lives in its own
+ allocation. The macros in this file generate an arraylist that stores values
+ of a given type inline in one contiguous buffer instead:
+
+     ARRAYLIST_DECLARE(pointlist, point_t)        // in a header
+     ARRAYLIST_DEFINE(pointlist, point_t, cmp_pt) // in exactly one .c file
+
+ This declares the type pointlist_t and the functions pointlist_init,
+ pointlist_free, pointlist_resize, pointlist_reserve, pointlist_append,
+ pointlist_add, pointlist_addall, pointlist_remove, pointlist_clear,
+ pointlist_length, pointlist_toarray, pointlist_get and pointlist_indexof,
+ which behave like their arraylist_* counterparts but take and return T values
+ (or T pointers into the buffer) instead of void pointers.
+
+ The comparator given to ARRAYLIST_DEFINE must be callable as
+ int cmp(const T*, const T*). It is called directly rather than through a
+ function pointer, so a static inline comparator (or a macro) visible in the
+ defining file is inlined into indexof.
+*/
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "arraylist.h"
+
+/**
+ * Declares the struct and functions of an arraylist of T named name##_t
+ * <p>
+ * The accessors are defined here as static inline functions so that element
+ * access compiles to a plain array index in every translation unit
+ */
+#define ARRAYLIST_DECLARE(name, T)                                             \
+typedef struct name##_t name##_t;                                              \
+struct name##_t{                                                               \
+    T* list;       /* The array of elements */                                 \
+    size_t length; /* The number of spaces in the list that have been filled */\
+    size_t size;   /* The number of allocated spaces in the list */            \
+};                                                                             \
+                                                                               \
+bool name##_init(name##_t*);                                                   \
+void name##_free(name##_t*);                                                   \
+bool name##_resize(name##_t*, const size_t);                                   \
+bool name##_reserve(name##_t*, const size_t);                                  \
+                                                                               \
+bool name##_append(name##_t*, T);                                              \
+bool name##_add(name##_t*, const size_t, T);                                   \
+bool name##_addall(name##_t*, const size_t, const size_t, const T*);           \
+T name##_remove(name##_t*, const size_t);                                      \
+void name##_clear(name##_t*);                                                  \
+ptrdiff_t name##_indexof(const name##_t*, const T*);                           \
+                                                                               \
+static inline size_t name##_length(const name##_t* lst){                       \
+    return lst->length;                                                        \
+}                                                                              \
+                                                                               \
+static inline T* name##_toarray(const name##_t* lst){                          \
+    return lst->list;                                                          \
+}                                                                              \
+                                                                               \
+static inline T* name##_get(const name##_t* lst, const size_t ind){            \
+    return &lst->list[ind];                                                    \
+}
+
+/**
+ * Defines the functions declared by ARRAYLIST_DECLARE(name, T)
+ * <p>
+ * Growth follows the same policy as arraylist_reserve. cmp is used by indexof
+ * and must be callable as int cmp(const T*, const T*)
+ */
+#define ARRAYLIST_DEFINE(name, T, cmp)                                         \
+bool name##_init(name##_t* lst){                                               \
+    lst->size = arraylist_initsize;                                            \
+    lst->length = 0;                                                           \
+    lst->list = (T*) malloc(arraylist_initsize*sizeof(T));                     \
+    return lst->list != NULL;                                                  \
+}                                                                              \
+                                                                               \
+void name##_free(name##_t* lst){                                               \
+    if(lst->list){                                                             \
+        free(lst->list);                                                       \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+bool name##_resize(name##_t* lst, const size_t size){                          \
+    T* list = (T*) realloc(lst->list, size*sizeof(T));                         \
+    if(list == NULL){                                                          \
+        return false;                                                          \
+    }                                                                          \
+    lst->list = list;                                                          \
+    lst->size = size;                                                          \
+    if(lst->length > size){                                                    \
+        lst->length = size;                                                    \
+    }                                                                          \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+bool name##_reserve(name##_t* lst, const size_t newsize){                      \
+    if(lst->size < newsize){                                                   \
+        size_t size = lst->size;                                               \
+        while(size < newsize){                                                 \
+            size *= arraylist_resize_factor;                                   \
+        }                                                                      \
+        return name##_resize(lst, size);                                       \
+    }                                                                          \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+bool name##_append(name##_t* lst, T data){                                     \
+    bool success = name##_reserve(lst, lst->length + 1);                       \
+    if(success){                                                               \
+        lst->list[lst->length] = data;                                         \
+        lst->length++;                                                         \
+    }                                                                          \
+    return success;                                                            \
+}                                                                              \
+                                                                               \
+bool name##_add(name##_t* lst, const size_t ind, T data){                      \
+    bool success = name##_reserve(lst, lst->length + 1);                       \
+    if(success){                                                               \
+        memmove(&lst->list[ind + 1], &lst->list[ind],                          \
+                (lst->length - ind)*sizeof(T));                                \
+        lst->list[ind] = data;                                                 \
+        lst->length++;                                                         \
+    }                                                                          \
+    return success;                                                            \
+}                                                                              \
+                                                                               \
+bool name##_addall(name##_t* lst, const size_t ind, const size_t len,          \
+                   const T* ary){                                              \
+    bool success = name##_reserve(lst, lst->length + len);                     \
+    if(success){                                                               \
+        memmove(&lst->list[ind + len], &lst->list[ind],                        \
+                (lst->length - ind)*sizeof(T));                                \
+        memcpy(&lst->list[ind], ary, len*sizeof(T));                           \
+        lst->length += len;                                                    \
+    }                                                                          \
+    return success;                                                            \
+}                                                                              \
+                                                                               \
+T name##_remove(name##_t* lst, const size_t ind){                              \
+    T data = lst->list[ind];                                                   \
+    memmove(&lst->list[ind], &lst->list[ind + 1],                              \
+            (lst->length - ind - 1)*sizeof(T));                                \
+    lst->length--;                                                             \
+    return data;                                                               \
+}                                                                              \
+                                                                               \
+void name##_clear(name##_t* lst){                                              \
+    lst->length = 0;                                                           \
+}                                                                              \
+                                                                               \
+ptrdiff_t name##_indexof(const name##_t* lst, const T* data){                  \
+    size_t i = 0;                                                              \
+    while(i < lst->length && cmp(data, &lst->list[i]) != 0){                   \
+        i++;                                                                   \
+    }                                                                          \
+    return i < lst->length ? (ptrdiff_t) i : -1;                               \
+}
+
+#endif
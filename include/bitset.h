@@ -0,0 +1,43 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ A growable vector of bits
+
+ Bit i is bit i % 64 of words[i / 64], so a flag costs one bit instead of a
+ pointer in a list. Bits past the allocated words read as clear, and setting
+ one grows the set. The bulk operations and cardinality process whole words
+ with AVX2 when the cpu supports it.
+*/
+
+typedef struct bitset_t bitset_t;
+struct bitset_t{
+    uint64_t* words; // The bits, 64 to a word
+    size_t nwords;   // # of words allocated
+};
+
+bool bitset_init(bitset_t*);
+void bitset_free(bitset_t*);
+bool bitset_reserve(bitset_t*, size_t nbits);
+
+bool bitset_set(bitset_t*, size_t);
+void bitset_clear(bitset_t*, size_t);
+void bitset_clearall(bitset_t*);
+bool bitset_get(const bitset_t*, size_t);
+
+ptrdiff_t bitset_nextsetbit(const bitset_t*, size_t);
+size_t bitset_cardinality(const bitset_t*);
+size_t bitset_length(const bitset_t*);
+size_t bitset_size(const bitset_t*);
+
+void bitset_and(bitset_t*, const bitset_t*);
+bool bitset_or(bitset_t*, const bitset_t*);
+bool bitset_xor(bitset_t*, const bitset_t*);
+void bitset_andnot(bitset_t*, const bitset_t*);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CONCURRENTPRIORITYQUEUE_H
+#define CONCURRENTPRIORITYQUEUE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "priorityqueue.h"
+
+/*
+ A thread safe priority queue built from locked priorityqueue_t shards
+
+ In strict mode there is a single shard, so poll always returns the minimum
+ element. In relaxed mode the queue is a MultiQueue: add inserts into a random
+ shard and poll takes the smaller minimum of two random shards. Polled elements
+ are then only approximately in order, in exchange for throughput that scales
+ with the number of threads.
+*/
+
+typedef struct _cpqshard_t _cpqshard_t;
+struct _cpqshard_t{
+    _Alignas(64) pthread_mutex_t lock; // Padded so shards share no cache line
+    priorityqueue_t pq;                // The heap guarded by lock
+};
+
+typedef struct concurrentpriorityqueue_t concurrentpriorityqueue_t;
+struct concurrentpriorityqueue_t{
+    _cpqshard_t* shards;   // Array of locked heaps
+    size_t nshards;        // # of shards, 1 in strict mode
+    atomic_size_t length;  // # of elements in all shards
+};
+
+bool concurrentpriorityqueue_init(concurrentpriorityqueue_t*,
+                                  int (*)(const void*, const void*),
+                                  size_t nthreads, bool strict);
+void concurrentpriorityqueue_free(concurrentpriorityqueue_t*);
+
+bool concurrentpriorityqueue_add(concurrentpriorityqueue_t*, void*);
+void* concurrentpriorityqueue_poll(concurrentpriorityqueue_t*);
+
+size_t concurrentpriorityqueue_size(const concurrentpriorityqueue_t*);
+
+#endif
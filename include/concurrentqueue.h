@@ -0,0 +1,70 @@
+#ifndef CONCURRENTQUEUE_H
+#define CONCURRENTQUEUE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ Bounded lock free FIFO queues for passing pointers between threads
+
+ spscqueue_t is a ring for exactly one producer and one consumer thread. Both
+ sides are wait free: each writes only its own index and keeps a cached copy
+ of the other side's index, so it only reads the shared one when the cached
+ copy says the ring is full or empty.
+
+ mpmcqueue_t allows any number of producers and consumers. Every slot carries
+ a sequence number that tells whether it is ready to be written or read for
+ a given position, so threads claim positions with a single compare and swap
+ and never wait on a lock (Vyukov's bounded MPMC queue).
+
+ Indices written by different threads are padded onto their own cache lines.
+ Both queues hold a power of 2 number of elements and reject NULL elements,
+ since poll returns NULL for an empty queue.
+*/
+
+typedef struct spscqueue_t spscqueue_t;
+struct spscqueue_t{
+    void** data;                       // Ring of element pointers
+    size_t mask;                       // # of slots - 1
+    _Alignas(64) atomic_size_t head;   // Next position to poll, consumer owned
+    size_t tailcache;                  // Consumer's last read of tail
+    _Alignas(64) atomic_size_t tail;   // Next position to offer, producer owned
+    size_t headcache;                  // Producer's last read of head
+};
+
+typedef struct _mpmccell_t _mpmccell_t;
+struct _mpmccell_t{
+    atomic_size_t seq; // Position the cell is ready to be written for, or 1 +
+                       // the position it is ready to be read for
+    void* data;        // The element stored at that position
+};
+
+typedef struct mpmcqueue_t mpmcqueue_t;
+struct mpmcqueue_t{
+    _mpmccell_t* cells;                // Ring of sequenced slots
+    size_t mask;                       // # of slots - 1
+    _Alignas(64) atomic_size_t tail;   // Next position to offer
+    _Alignas(64) atomic_size_t head;   // Next position to poll
+};
+
+bool spscqueue_init(spscqueue_t*, size_t capacity);
+void spscqueue_free(spscqueue_t*);
+bool spscqueue_offer(spscqueue_t*, void*);
+size_t spscqueue_offerall(spscqueue_t*, void**, const size_t);
+void* spscqueue_poll(spscqueue_t*);
+size_t spscqueue_drainto(spscqueue_t*, void**, const size_t);
+size_t spscqueue_size(const spscqueue_t*);
+size_t spscqueue_capacity(const spscqueue_t*);
+
+bool mpmcqueue_init(mpmcqueue_t*, size_t capacity);
+void mpmcqueue_free(mpmcqueue_t*);
+bool mpmcqueue_offer(mpmcqueue_t*, void*);
+size_t mpmcqueue_offerall(mpmcqueue_t*, void**, const size_t);
+void* mpmcqueue_poll(mpmcqueue_t*);
+size_t mpmcqueue_drainto(mpmcqueue_t*, void**, const size_t);
+size_t mpmcqueue_size(const mpmcqueue_t*);
+size_t mpmcqueue_capacity(const mpmcqueue_t*);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HASHMAP_H
+#define HASHMAP_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ A hash map from keys to values using open addressing in the style of
+ SwissTable
+
+ Every slot has a control byte that is either _HM_EMPTY, _HM_DELETED or the low
+ 7 bits of the hash of the key stored there. Slots are probed in aligned groups
+ of _HM_GROUP, and the control bytes of a whole group are compared against the
+ hash at once, so most lookups compare a single key and touch two cache lines.
+*/
+
+#define _HM_GROUP 16
+#define _HM_EMPTY ((int8_t) -128)
+#define _HM_DELETED ((int8_t) -2)
+
+typedef struct _hmentry_t _hmentry_t;
+struct _hmentry_t{
+    void* key;   // Pointer to the key
+    void* value; // Pointer to the value
+};
+
+typedef struct hashmap_t hashmap_t;
+struct hashmap_t{
+    int8_t* ctrl;         // Control byte of each slot
+    _hmentry_t* entries;  // Key and value of each slot
+    size_t capacity;      // # of slots, a power of 2 and a multiple of a group
+    size_t size;          // # of keys in the map
+    size_t growthleft;    // # of empty slots that may still be filled
+    size_t (*hash)(const void*);          // Hash function for keys
+    int (*cmp)(const void*, const void*); // Returns 0 for equal keys
+};
+
+bool hashmap_init(hashmap_t*, size_t (*)(const void*),
+                  int (*)(const void*, const void*));
+void hashmap_free(hashmap_t*);
+bool hashmap_reserve(hashmap_t*, size_t);
+
+bool hashmap_put(hashmap_t*, void* key, void* value);
+void* hashmap_remove(hashmap_t*, const void* key);
+void hashmap_clear(hashmap_t*);
+
+void* hashmap_get(const hashmap_t*, const void* key);
+bool hashmap_containskey(const hashmap_t*, const void* key);
+size_t hashmap_size(const hashmap_t*);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef JAVAUTIL_STATS_H
+#define JAVAUTIL_STATS_H
+
+#include <stddef.h>
+
+/*
+ Instrumentation counters for the hot paths of arraylist_t, linkedlist_t and
+ priorityqueue_t, compiled in only when JAVAUTIL_STATS is defined (make
+ STATS=1). Without it the containers have no stats member and every counting
+ macro expands to nothing, so release builds pay nothing for them. Each
+ container reads its counters with *_stats and zeroes them with *_resetstats.
+ Counters that do not apply to a container stay 0
+
+ Lookups through a const pointer count too, so in a stats build concurrent
+ readers of one container race on its counters
+*/
+
+typedef struct javautil_stats_t javautil_stats_t;
+struct javautil_stats_t{
+    size_t cmps;       // Comparator calls
+    size_t sifts;      // Sift ups and sift downs
+    size_t siftlevels; // Heap levels moved by all sifts together
+    size_t maxsift;    // Most levels moved by a single sift
+    size_t moves;      // Elements moved or shifted to another slot
+    size_t steps;      // Nodes walked past to reach an index
+    size_t reallocs;   // Times the element array was reallocated
+    size_t bytes;      // Bytes requested from malloc and realloc
+    size_t nodes;      // Nodes allocated with malloc or an allocator_t
+    size_t highwater;  // Most elements held at once
+};
+
+#ifdef JAVAUTIL_STATS
+#define _STATS_ONLY(...) __VA_ARGS__
+#define _STATS_INC(obj, field, n) \
+    (((javautil_stats_t*) &(obj)->stats)->field += (n))
+#define _STATS_MAX(obj, field, v) do{ \
+        size_t _stats_v = (v); \
+        if(_stats_v > (obj)->stats.field){ \
+            ((javautil_stats_t*) &(obj)->stats)->field = _stats_v; \
+        } \
+    }while(0)
+#define _STATS_READ(obj, out) (*(out) = (obj)->stats)
+#define _STATS_RESET(obj) ((obj)->stats = (javautil_stats_t) {0})
+#else
+#define _STATS_ONLY(...)
+#define _STATS_INC(obj, field, n) ((void) 0)
+#define _STATS_MAX(obj, field, v) ((void) 0)
+#define _STATS_READ(obj, out) (*(out) = (javautil_stats_t) {0})
+#define _STATS_RESET(obj) ((void) 0)
+#endif
+
+#endif
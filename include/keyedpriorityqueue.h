@@ -0,0 +1,62 @@
+#ifndef KEYEDPRIORITYQUEUE_H
+#define KEYEDPRIORITYQUEUE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ A min-heap of elements prioritized by a numeric key stored next to each
+ element pointer. Keys are compared directly instead of through a comparator,
+ which makes this queue much cheaper than priorityqueue_t when priorities are
+ plain numbers. priorityqueue_t remains the generic fallback.
+*/
+
+typedef struct keyedpriorityqueue_t keyedpriorityqueue_t;
+struct keyedpriorityqueue_t{
+    uint64_t* keys; // Array of element keys in heap order
+    void** data;    // Array of data pointers, parallel to keys
+    size_t length;  // # of elements in heap array
+    size_t size;    // Allocated space in heap arrays
+};
+
+bool keyedpriorityqueue_init(keyedpriorityqueue_t*);
+void keyedpriorityqueue_free(keyedpriorityqueue_t*);
+bool keyedpriorityqueue_reserve(keyedpriorityqueue_t*, size_t size);
+
+bool keyedpriorityqueue_add(keyedpriorityqueue_t*, uint64_t key, void*);
+void keyedpriorityqueue_clear(keyedpriorityqueue_t*);
+void* keyedpriorityqueue_poll(keyedpriorityqueue_t*, uint64_t* key);
+
+size_t keyedpriorityqueue_size(const keyedpriorityqueue_t*);
+void* keyedpriorityqueue_peek(const keyedpriorityqueue_t*, uint64_t* key);
+
+bool validate_keyedheap(const keyedpriorityqueue_t*);
+
+/**
+ * Maps a double to a key that orders the same way, so doubles can be used as
+ * priorities. Every NaN, whatever its sign and payload, maps to the key of the
+ * positive quiet NaN and orders after +infinity
+ */
+static inline uint64_t keyedpriorityqueue_key_double(double d){
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    if(d != d){
+        bits = 0x7ff8000000000000ull;
+    }
+    return (bits >> 63) ? ~bits : bits | (1ull << 63);
+}
+
+/**
+ * Inverse of keyedpriorityqueue_key_double
+ */
+static inline double keyedpriorityqueue_double_key(uint64_t key){
+    uint64_t bits = (key >> 63) ? key & ~(1ull << 63) : ~key;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+#endif
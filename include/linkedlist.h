@@ -3,6 +3,10 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "javautil_stats.h"
+#include "allocator.h"
 
 typedef struct _llnode_t _llnode_t;
 struct _llnode_t{
@@ -10,23 +14,96 @@ struct _llnode_t{
     void* data;      // Pointer to the data in this node
 };
 
+typedef struct _lldnode_t _lldnode_t;
+struct _lldnode_t{
+    _llnode_t node;  // Next and data, so a _lldnode_t* is also a _llnode_t*
+    _llnode_t* prev; // Previous element in list
+};
+
+typedef struct linkedlist_pool_t linkedlist_pool_t;
+struct linkedlist_pool_t{
+    size_t nodesize;      // Bytes per node handed out by the pool
+    void* slabs;          // Allocated slabs, linked through their first word
+    char* bump;           // Next unused node in the newest slab
+    char* bumpend;        // End of the newest slab
+    _llnode_t* freelist;  // Released nodes, linked through next
+    bool threadsafe;      // Whether the pool is shared between threads
+    pthread_mutex_t lock; // Guards the pool when threadsafe
+    unsigned long id;     // Identifies the pool to thread local caches
+    size_t allocs;        // # of nodes handed out
+    size_t frees;         // # of nodes given back
+    size_t slabcount;     // # of slabs allocated, the only calls to malloc
+    size_t cachehits;     // # of allocs served by a thread local cache
+};
+
 typedef struct linkedlist_t linkedlist_t;
 struct linkedlist_t{
     size_t length;    // Number of elements in list, stored for convenience
     _llnode_t* start; // Pointer to the first node in the list
+    _llnode_t* end;   // Pointer to the last node in the list
+    bool deque;       // Whether nodes are _lldnode_t linked in both directions
+    linkedlist_pool_t* pool; // Pool nodes are allocated from, or NULL
+    bool ownpool;     // Whether pool is private to this list
+    allocator_t* alloc; // Allocator nodes come from without a pool, or NULL
+    size_t modcount;  // # of adds and removes, checked by iterators
+#ifdef JAVAUTIL_STATS
+    javautil_stats_t stats; // Instrumentation counters
+#endif
 };
 
+typedef struct linkedlist_iterator_t linkedlist_iterator_t;
+struct linkedlist_iterator_t{
+    linkedlist_t* lst;   // The list being iterated over
+    _llnode_t* prev;     // Node before the cursor, NULL at the front
+    _llnode_t* prevprev; // Node before prev, kept so prev can be unlinked
+    bool returned;       // Whether prev was returned by next and not since
+                         // removed or preceded by an add
+    size_t index;        // Index of the element next returns
+    size_t modcount;     // The list's modcount the iterator expects
+};
+
+bool linkedlist_pool_init(linkedlist_pool_t*, bool threadsafe);
+void linkedlist_pool_free(linkedlist_pool_t*);
+void linkedlist_pool_flushcache(linkedlist_pool_t*);
+double linkedlist_pool_hitrate(const linkedlist_pool_t*);
+
 void linkedlist_init(linkedlist_t*);
+void linkedlist_init_deque(linkedlist_t*);
+bool linkedlist_setpool(linkedlist_t*, linkedlist_pool_t*);
+bool linkedlist_setallocator(linkedlist_t*, allocator_t*);
+void linkedlist_stats(const linkedlist_t*, javautil_stats_t*);
+void linkedlist_resetstats(linkedlist_t*);
 void linkedlist_free(linkedlist_t*);
 
 bool linkedlist_append(linkedlist_t*, void*);
 bool linkedlist_add(linkedlist_t*, const size_t, void*);
 void* linkedlist_remove(linkedlist_t*, const size_t);
 
+bool linkedlist_addfirst(linkedlist_t*, void*);
+bool linkedlist_addlast(linkedlist_t*, void*);
+void* linkedlist_pollfirst(linkedlist_t*);
+void* linkedlist_polllast(linkedlist_t*);
+void* linkedlist_removefirst(linkedlist_t*);
+void* linkedlist_removelast(linkedlist_t*);
+void* linkedlist_peekfirst(const linkedlist_t*);
+void* linkedlist_peeklast(const linkedlist_t*);
+
 size_t linkedlist_length(const linkedlist_t*);
 void** linkedlist_toarray(const linkedlist_t*);
 void* linkedlist_get(const linkedlist_t*, const size_t);
-ptrdiff_t linkedlist_indexof(const linkedlist_t*, const void*, 
+ptrdiff_t linkedlist_indexof(const linkedlist_t*, const void*,
                             int (*)(const void*, const void*));
 
+void linkedlist_iterator(linkedlist_t*, linkedlist_iterator_t*);
+bool linkedlist_iterator_hasnext(const linkedlist_iterator_t*);
+void* linkedlist_iterator_next(linkedlist_iterator_t*);
+bool linkedlist_iterator_remove(linkedlist_iterator_t*);
+bool linkedlist_iterator_add(linkedlist_iterator_t*, void*);
+bool linkedlist_iterator_set(linkedlist_iterator_t*, void*);
+size_t linkedlist_iterator_nextindex(const linkedlist_iterator_t*);
+bool linkedlist_iterator_isvalid(const linkedlist_iterator_t*);
+void linkedlist_foreach(const linkedlist_t*, void (*)(void*, void*), void*);
+size_t linkedlist_removeif(linkedlist_t*, bool (*)(const void*, void*),
+                           void*);
+
 #endif
@@ -0,0 +1,56 @@
+#ifndef MAPPEDLIST_H
+#define MAPPEDLIST_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ A list of fixed size records stored in a memory mapped file
+
+ The file starts with a _mlheader_t and is followed by the records, so opening
+ an existing file maps it and uses the records in place without reading or
+ copying them. Records are stored by value, not as pointers. The mapping is
+ shared, so other processes mapping the same file see every change, and growing
+ the list grows the file. Read only lists map more of the file when they find
+ a writer has grown it.
+*/
+
+#define _ML_MAGIC 0x314c53494c4a4c4dull // "MLJLISL1" little endian
+
+typedef struct _mlheader_t _mlheader_t;
+struct _mlheader_t{
+    uint64_t magic;   // _ML_MAGIC
+    uint64_t recsize; // Bytes per record
+    uint64_t length;  // # of records in the list
+    uint64_t pad[5];  // Keeps the records cache line aligned
+};
+
+typedef struct mappedlist_t mappedlist_t;
+struct mappedlist_t{
+    int fd;              // Descriptor of the backing file
+    _mlheader_t* header; // Start of the mapping
+    char* records;       // First record, just past the header
+    size_t recsize;      // Bytes per record
+    size_t size;         // # of records the file has room for
+    bool readonly;       // Whether the file was opened read only
+};
+
+bool mappedlist_open(mappedlist_t*, const char* path, size_t recsize,
+                     bool readonly);
+bool mappedlist_close(mappedlist_t*);
+bool mappedlist_flush(mappedlist_t*);
+bool mappedlist_reserve(mappedlist_t*, const size_t);
+
+bool mappedlist_append(mappedlist_t*, const void*);
+bool mappedlist_set(mappedlist_t*, const size_t, const void*);
+bool mappedlist_removelast(mappedlist_t*, void*);
+bool mappedlist_clear(mappedlist_t*);
+
+size_t mappedlist_length(mappedlist_t*);
+size_t mappedlist_recsize(const mappedlist_t*);
+void* mappedlist_get(mappedlist_t*, const size_t);
+void* mappedlist_toarray(mappedlist_t*);
+
+#endif
@@ -4,42 +4,81 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
+#include "javautil_stats.h"
+#include "allocator.h"
 
-static inline const size_t _PQ_PARENT(size_t ind){
-    return (ind-1)/2;
+static inline const size_t _PQ_PARENT(size_t ind, size_t arity){
+    return (ind-1)/arity;
 }
 
-static inline const size_t _PQ_LEFT(size_t ind){
-    return 2*ind+1;
+static inline const size_t _PQ_CHILD(size_t ind, size_t arity){
+    return arity*ind+1;
 }
 
-static inline const size_t _PQ_RIGHT(size_t ind){
-    return 2*ind+2;
-}
+typedef size_t priorityqueue_handle_t;
 
 typedef struct priorityqueue_t priorityqueue_t;
 struct priorityqueue_t{
     void** data;   // Array of data pointers
     size_t length; // # of elements in heap array
     size_t size;   // Allocated space in heap array
+    size_t arity;  // # of children of each node in the heap
+    size_t pad;    // # of unused slots allocated in front of data
     int (*cmp)(const void*, const void*); // Comparator for queue items
+    size_t* pos;    // Heap index of each handle, NULL unless indexed
+    size_t* hnd;    // Handle at each heap index, then the released handles
+    size_t handles; // # of handles given out so far
+    allocator_t* alloc; // Allocator for the arrays, or NULL for malloc
+#ifdef JAVAUTIL_STATS
+    javautil_stats_t stats; // Instrumentation counters
+#endif
 };
 
+extern const size_t priorityqueue_max_arity;
+
 bool priorityqueue_init(priorityqueue_t*, int (*)(const void*, const void*));
+bool priorityqueue_init_arity(priorityqueue_t*,
+                              int (*)(const void*, const void*), size_t arity);
+bool priorityqueue_init_allocator(priorityqueue_t*,
+                                  int (*)(const void*, const void*),
+                                  size_t arity, allocator_t*);
+bool priorityqueue_init_from_array(priorityqueue_t*,
+                                   int (*)(const void*, const void*),
+                                   void** ary, const size_t len);
+bool priorityqueue_init_indexed(priorityqueue_t*,
+                                int (*)(const void*, const void*),
+                                size_t arity);
 void priorityqueue_free(priorityqueue_t*);
 bool priorityqueue_reserve(priorityqueue_t*, size_t size);
+void priorityqueue_stats(const priorityqueue_t*, javautil_stats_t*);
+void priorityqueue_resetstats(priorityqueue_t*);
 
 bool priorityqueue_add(priorityqueue_t*, void*);
+bool priorityqueue_add_handle(priorityqueue_t*, void*,
+                              priorityqueue_handle_t* handle);
 bool priorityqueue_addall(priorityqueue_t*, void**, const size_t len);
 bool priorityqueue_remove(priorityqueue_t*, const void*);
 void priorityqueue_clear(priorityqueue_t*);
 void* priorityqueue_poll(priorityqueue_t*);
+void* priorityqueue_remove_handle(priorityqueue_t*, priorityqueue_handle_t);
+bool priorityqueue_decrease_key(priorityqueue_t*, priorityqueue_handle_t,
+                                void*);
+bool priorityqueue_update_key(priorityqueue_t*, priorityqueue_handle_t, void*);
 
 bool priorityqueue_contains(const priorityqueue_t*, const void*);
+bool priorityqueue_contains_handle(const priorityqueue_t*,
+                                   priorityqueue_handle_t);
+void* priorityqueue_get_handle(const priorityqueue_t*, priorityqueue_handle_t);
 size_t priorityqueue_size(const priorityqueue_t*);
 void** priorityqueue_toarray(const priorityqueue_t*);
 void* priorityqueue_peek(const priorityqueue_t*);
 
+bool priorityqueue_snapshot(const priorityqueue_t*, FILE*, size_t elemsize,
+                            void (*)(const void* elem, void* buf));
+bool priorityqueue_restore(priorityqueue_t*, int (*)(const void*, const void*),
+                           FILE*, void* (*)(const void* buf));
+
 bool validate_heap(const priorityqueue_t*);
 
 #endif
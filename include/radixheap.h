@@ -0,0 +1,48 @@
+#ifndef RADIXHEAP_H
+#define RADIXHEAP_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arraylist_template.h"
+
+/*
+ A monotone priority queue keyed on unsigned integers
+
+ Keys added to a radix heap may not be smaller than the last key polled, which
+ holds for Dijkstra's algorithm and for event simulations. Elements are kept in
+ buckets by the highest bit in which their key differs from the last polled
+ key, so operations cost amortized O(log C) for keys up to C with almost no
+ key comparisons.
+*/
+
+typedef struct _rhentry_t _rhentry_t;
+struct _rhentry_t{
+    uint64_t key; // Priority of the element
+    void* data;   // Pointer to the element
+};
+
+ARRAYLIST_DECLARE(_rhbucket, _rhentry_t)
+
+#define _RH_BUCKETS 65
+
+typedef struct radixheap_t radixheap_t;
+struct radixheap_t{
+    _rhbucket_t buckets[_RH_BUCKETS]; // Bucket i holds keys whose highest bit
+                                      // differing from last is bit i-1
+    uint64_t last;                    // The last key polled
+    size_t length;                    // # of elements in all buckets
+};
+
+bool radixheap_init(radixheap_t*);
+void radixheap_free(radixheap_t*);
+
+bool radixheap_add(radixheap_t*, uint64_t key, void*);
+void radixheap_clear(radixheap_t*);
+void* radixheap_poll(radixheap_t*, uint64_t* key);
+
+size_t radixheap_size(const radixheap_t*);
+void* radixheap_peek(radixheap_t*, uint64_t* key);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef SEGMENTEDLIST_H
+#define SEGMENTEDLIST_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ A dynamic array stored in geometrically growing segments
+
+ Segment k holds _SL_FIRSTSEG*2^k elements, so the segment and offset of an
+ index follow from its highest set bit. Growing allocates one new segment and
+ never copies or moves existing elements, which makes append O(1) in the worst
+ case and keeps the address of every element stable.
+*/
+
+#define _SL_FIRSTSEG 8
+#define _SL_FIRSTSHIFT 3
+#define _SL_MAXSEGS (64 - _SL_FIRSTSHIFT)
+
+typedef struct segmentedlist_t segmentedlist_t;
+struct segmentedlist_t{
+    void** segments[_SL_MAXSEGS]; // Allocated segments, NULL past the last
+    size_t nsegments;             // # of allocated segments
+    size_t length;                // # of elements in the list
+    size_t size;                  // # of elements the segments can hold
+};
+
+/**
+ * Returns the segment holding index ind
+ */
+static inline size_t _SL_SEGMENT(size_t ind){
+    return (size_t) (63 - __builtin_clzll(ind + _SL_FIRSTSEG)) -
+           _SL_FIRSTSHIFT;
+}
+
+/**
+ * Returns the position of index ind within its segment
+ */
+static inline size_t _SL_OFFSET(size_t ind, size_t seg){
+    return ind + _SL_FIRSTSEG - ((size_t) _SL_FIRSTSEG << seg);
+}
+
+void segmentedlist_init(segmentedlist_t*);
+void segmentedlist_free(segmentedlist_t*);
+bool segmentedlist_reserve(segmentedlist_t*, const size_t);
+
+bool segmentedlist_append(segmentedlist_t*, void*);
+void* segmentedlist_removelast(segmentedlist_t*);
+void segmentedlist_set(segmentedlist_t*, const size_t, void*);
+void segmentedlist_clear(segmentedlist_t*);
+
+size_t segmentedlist_length(const segmentedlist_t*);
+void** segmentedlist_toarray(const segmentedlist_t*);
+ptrdiff_t segmentedlist_indexof(const segmentedlist_t*, const void*,
+                                int (*)(const void*, const void*));
+
+/**
+ * Returns the address of the slot holding the element at ind, which stays
+ * valid until the list is freed
+ * @param lst  The segmentedlist to look in
+ * @param ind  The index of the slot, which must be less than the list length
+ * @return  The address of the slot at ind
+ */
+static inline void** segmentedlist_ref(const segmentedlist_t* lst,
+                                       const size_t ind){
+    size_t seg = _SL_SEGMENT(ind);
+    return &lst->segments[seg][_SL_OFFSET(ind, seg)];
+}
+
+/**
+ * Returns the item at the specified index of the segmentedlist in O(1)
+ * @param lst  The segmentedlist to look in
+ * @param ind  The index of the element to get
+ * @return  The element at the specified index, or NULL if it is out of range
+ */
+static inline void* segmentedlist_get(const segmentedlist_t* lst,
+                                      const size_t ind){
+    return ind < lst->length ? *segmentedlist_ref(lst, ind) : NULL;
+}
+
+#endif
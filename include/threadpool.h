@@ -0,0 +1,58 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/*
+ A work stealing thread pool for fork/join parallelism
+
+ Every worker owns a deque of tasks. A worker runs the newest task of its own
+ deque and steals the oldest task of another deque when its own is empty, so
+ a recursive divide and conquer spreads its largest pieces of work first.
+ Threads outside the pool share one extra deque. A thread waiting in
+ threadpool_join runs queued tasks until the joined task is done, which lets
+ tasks fork and join subtasks without blocking a worker.
+*/
+
+typedef struct threadpool_task_t threadpool_task_t;
+struct threadpool_task_t{
+    void (*fn)(void*); // The work to run
+    void* arg;         // Passed to fn
+    atomic_bool done;  // Set once fn has returned
+};
+
+typedef struct _tpdeque_t _tpdeque_t;
+struct _tpdeque_t{
+    _Alignas(64) pthread_mutex_t lock; // Padded so deques share no cache line
+    threadpool_task_t** tasks;         // Ring buffer of queued tasks
+    size_t head;                       // Position of the oldest task
+    size_t length;                     // # of queued tasks
+    size_t size;                       // Allocated space in tasks
+};
+
+typedef struct threadpool_t threadpool_t;
+struct threadpool_t{
+    pthread_t* threads;       // The worker threads
+    size_t nthreads;          // # of worker threads
+    _tpdeque_t* deques;       // Deque 0 is shared by outside threads, deque
+                              // i + 1 belongs to worker i
+    atomic_size_t pending;    // # of tasks queued in all deques
+    atomic_bool stop;         // Tells the workers to exit
+    pthread_mutex_t idlelock; // Guards sleeping on idle
+    pthread_cond_t idle;      // Signalled when tasks are queued
+};
+
+bool threadpool_init(threadpool_t*, size_t nthreads);
+void threadpool_free(threadpool_t*);
+threadpool_t* threadpool_default(void);
+size_t threadpool_parallelism(const threadpool_t*);
+
+bool threadpool_fork(threadpool_t*, threadpool_task_t*, void (*)(void*),
+                     void*);
+void threadpool_join(threadpool_t*, threadpool_task_t*);
+
+#endif
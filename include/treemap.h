@@ -0,0 +1,83 @@
+#ifndef TREEMAP_H
+#define TREEMAP_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ An ordered map from keys to values stored in a B+-tree
+
+ Every key and value lives in a leaf. Inner nodes only hold separator keys
+ that route searches, so they are small and dense enough to stay in cache.
+ The leaves are linked in key order in both directions, so a range scan walks
+ contiguous arrays of keys without going back up the tree. Every node but the
+ root is kept about half full.
+*/
+
+#define _TM_ORDER 32 // Most keys in a node
+#define _TM_MIN (_TM_ORDER/2 - 1) // Fewest keys in a node but the root
+
+typedef struct _tmnode_t _tmnode_t;
+struct _tmnode_t{
+    size_t length;          // # of keys in the node
+    bool leaf;              // Whether the node is a _tmleaf_t
+    void* keys[_TM_ORDER];  // Sorted keys
+};
+
+typedef struct _tmleaf_t _tmleaf_t;
+struct _tmleaf_t{
+    _tmnode_t node;           // Keys of the entries
+    void* values[_TM_ORDER];  // values[i] is the value of node.keys[i]
+    _tmleaf_t* prev;          // Leaf with the next smaller keys, or NULL
+    _tmleaf_t* next;          // Leaf with the next larger keys, or NULL
+};
+
+typedef struct _tminner_t _tminner_t;
+struct _tminner_t{
+    _tmnode_t node;                      // keys[i] is the least key under
+                                         // children[i + 1]
+    _tmnode_t* children[_TM_ORDER + 1];  // Subtrees, length + 1 of them
+};
+
+typedef struct treemap_t treemap_t;
+struct treemap_t{
+    _tmnode_t* root;     // Root of the tree, a leaf when the map is small
+    _tmleaf_t* first;    // Leaf with the smallest keys
+    _tmleaf_t* last;     // Leaf with the largest keys
+    size_t size;         // # of keys in the map
+    int (*cmp)(const void*, const void*); // Orders the keys
+};
+
+typedef struct treemap_iterator_t treemap_iterator_t;
+struct treemap_iterator_t{
+    _tmleaf_t* leaf;     // Leaf of the next entry
+    size_t index;        // Position of the next entry in leaf
+    _tmleaf_t* endleaf;  // Leaf of the first entry past the range
+    size_t endindex;     // Position of that entry in endleaf
+};
+
+bool treemap_init(treemap_t*, int (*)(const void*, const void*));
+void treemap_free(treemap_t*);
+
+bool treemap_put(treemap_t*, void* key, void* value);
+void* treemap_remove(treemap_t*, const void* key);
+void treemap_clear(treemap_t*);
+
+void* treemap_get(const treemap_t*, const void* key);
+bool treemap_containskey(const treemap_t*, const void* key);
+void* treemap_firstkey(const treemap_t*);
+void* treemap_lastkey(const treemap_t*);
+void* treemap_floorkey(const treemap_t*, const void* key);
+void* treemap_ceilingkey(const treemap_t*, const void* key);
+size_t treemap_size(const treemap_t*);
+
+void treemap_iterator(const treemap_t*, treemap_iterator_t*, const void* lo,
+                      const void* hi);
+bool treemap_iterator_hasnext(const treemap_iterator_t*);
+void* treemap_iterator_next(treemap_iterator_t*, void** key);
+
+bool validate_treemap(const treemap_t*);
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef UNROLLEDLIST_H
+#define UNROLLEDLIST_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ A linked list whose nodes each hold a small array of element pointers
+
+ Nodes are two cache lines, so walking the list costs one cache miss per
+ _UL_NODECAP elements instead of one per element. Full nodes are split in half
+ on insertion and nodes less than half full are merged with or refilled from
+ their successor on removal, which keeps every node but the last at least half
+ full.
+*/
+
+#define _UL_NODECAP 14
+
+typedef struct _ulnode_t _ulnode_t;
+struct _ulnode_t{
+    _ulnode_t* next;          // Next node in list
+    size_t count;             // # of elements used in data
+    void* data[_UL_NODECAP];  // Pointers to the data in this node
+};
+
+typedef struct unrolledlist_t unrolledlist_t;
+struct unrolledlist_t{
+    size_t length;    // Number of elements in list
+    _ulnode_t* start; // Pointer to the first node in the list
+    _ulnode_t* end;   // Pointer to the last node in the list
+};
+
+void unrolledlist_init(unrolledlist_t*);
+void unrolledlist_free(unrolledlist_t*);
+
+bool unrolledlist_append(unrolledlist_t*, void*);
+bool unrolledlist_add(unrolledlist_t*, const size_t, void*);
+void* unrolledlist_remove(unrolledlist_t*, const size_t);
+
+size_t unrolledlist_length(const unrolledlist_t*);
+void** unrolledlist_toarray(const unrolledlist_t*);
+void* unrolledlist_get(const unrolledlist_t*, const size_t);
+ptrdiff_t unrolledlist_indexof(const unrolledlist_t*, const void*,
+                               int (*)(const void*, const void*));
+
+#endif
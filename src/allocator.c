@@ -0,0 +1,275 @@
+/*
+ c arena and fixed size pool allocators
+*/
+#include <string.h>
+#include <stdint.h>
+#include "allocator.h"
+
+const size_t allocator_default_align = _Alignof(max_align_t);
+const size_t arena_default_blocksize = 64*1024;
+const size_t poolallocator_slabobjs = 256;
+
+// Blocks and slabs start with a link to the previous one, padded so that the
+// memory after it keeps the alignment of malloc
+#define _ALLOC_HEADER _Alignof(max_align_t)
+
+/**
+ * Round p up to a multiple of align, a power of two
+ */
+static inline char* _alloc_alignup(char* p, size_t align){
+    return (char*) (((uintptr_t) p + align - 1) & ~((uintptr_t) align - 1));
+}
+
+/**
+ * Start a new block with room for at least size bytes aligned to align
+ */
+static bool _arena_grow(arena_t* arena, size_t size, size_t align){
+    size_t usable = arena->blocksize;
+    if(size + align > usable){
+        usable = size + align;
+    }
+    char* block = (char*) malloc(_ALLOC_HEADER + usable);
+    if(block == NULL){
+        return false;
+    }
+    *((void**) block) = arena->blocks;
+    arena->blocks = block;
+    arena->bump = block + _ALLOC_HEADER;
+    arena->end = arena->bump + usable;
+    arena->last = NULL;
+    return true;
+}
+
+/**
+ * Bump allocate from the newest block, starting a new one if it is full
+ */
+static void* _arena_alloc(allocator_t* a, size_t size, size_t align){
+    arena_t* arena = (arena_t*) a;
+    if(align < allocator_default_align){
+        align = allocator_default_align;
+    }
+    char* p = _alloc_alignup(arena->bump, align);
+    if(arena->bump == NULL || p > arena->end ||
+       size > (size_t) (arena->end - p)){
+        if(!_arena_grow(arena, size, align)){
+            return NULL;
+        }
+        p = _alloc_alignup(arena->bump, align);
+    }
+    arena->bump = p + size;
+    arena->last = p;
+    arena->allocated += size;
+    return p;
+}
+
+/**
+ * Grow the newest allocation in place if it fits, otherwise move the block to
+ * a new allocation. The old copy is only reclaimed by a reset
+ */
+static void* _arena_resize(allocator_t* a, void* ptr, size_t oldsize,
+                           size_t size){
+    arena_t* arena = (arena_t*) a;
+    if(ptr == NULL){
+        return _arena_alloc(a, size, allocator_default_align);
+    }
+    if((char*) ptr == arena->last &&
+       size <= (size_t) (arena->end - arena->last)){
+        arena->bump = arena->last + size;
+        arena->allocated += size - oldsize;
+        return ptr;
+    }
+    if(size <= oldsize){
+        return ptr;
+    }
+    void* moved = _arena_alloc(a, size, allocator_default_align);
+    if(moved != NULL){
+        memcpy(moved, ptr, oldsize);
+    }
+    return moved;
+}
+
+/**
+ * Take back the newest allocation. Anything older waits for a reset
+ */
+static void _arena_free(allocator_t* a, void* ptr, size_t size){
+    arena_t* arena = (arena_t*) a;
+    if(ptr != NULL && (char*) ptr == arena->last){
+        arena->bump = arena->last;
+        arena->last = NULL;
+        arena->allocated -= size;
+    }
+}
+
+/**
+ * Initialize an arena, which hands out memory by bumping a pointer through
+ * large blocks
+ * <p>
+ * Allocating is a few instructions and freeing individual blocks does nothing
+ * except for the newest one. Everything allocated from the arena is released
+ * at once by arena_reset or arena_free, so containers set up for one request
+ * can be thrown away together without freeing each of them
+ * @param arena      The arena to initialize
+ * @param blocksize  The number of bytes to allocate from malloc at a time, or 0
+ *                   for 64 KiB. Larger allocations get a block of their own
+ * @return  t/f depending on the successful allocation of the first block
+ */
+bool arena_init(arena_t* arena, size_t blocksize){
+    arena->allocator.alloc = _arena_alloc;
+    arena->allocator.resize = _arena_resize;
+    arena->allocator.free = _arena_free;
+    arena->blocks = NULL;
+    arena->bump = NULL;
+    arena->end = NULL;
+    arena->last = NULL;
+    arena->blocksize = blocksize > 0 ? blocksize : arena_default_blocksize;
+    arena->allocated = 0;
+    return _arena_grow(arena, 0, allocator_default_align);
+}
+
+/**
+ * Release everything allocated from an arena so its memory can be reused
+ * <p>
+ * Keeps the newest block and frees the others. Containers using the arena
+ * must not be used again after a reset
+ * @param arena  The arena to reset
+ */
+void arena_reset(arena_t* arena){
+    if(arena->blocks == NULL){
+        return;
+    }
+    void* block = *((void**) arena->blocks);
+    while(block != NULL){
+        void* next = *((void**) block);
+        free(block);
+        block = next;
+    }
+    *((void**) arena->blocks) = NULL;
+    arena->bump = (char*) arena->blocks + _ALLOC_HEADER;
+    arena->last = NULL;
+    arena->allocated = 0;
+}
+
+/**
+ * Free all memory held by an arena
+ * <p>
+ * Containers using the arena must not be used again afterwards
+ * @param arena  The arena to free
+ */
+void arena_free(arena_t* arena){
+    void* block = arena->blocks;
+    while(block != NULL){
+        void* next = *((void**) block);
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+    arena->bump = NULL;
+    arena->end = NULL;
+    arena->last = NULL;
+    arena->allocated = 0;
+}
+
+/**
+ * Returns the number of bytes handed out by an arena since it was initialized
+ * or last reset
+ * @param arena  The arena
+ * @return  The bytes allocated, excluding alignment padding
+ */
+size_t arena_allocated(const arena_t* arena){
+    return arena->allocated;
+}
+
+/**
+ * Take an object from the free list or the newest slab, allocating a new slab
+ * if both are exhausted. Requests larger than an object fail
+ */
+static void* _poolallocator_alloc(allocator_t* a, size_t size, size_t align){
+    poolallocator_t* pa = (poolallocator_t*) a;
+    if(size > pa->objsize || (pa->objsize & (align - 1)) != 0 ||
+       align > allocator_default_align){
+        return NULL;
+    }
+    void* obj = pa->freelist;
+    if(obj != NULL){
+        pa->freelist = *((void**) obj);
+        return obj;
+    }
+    if(pa->bump == pa->end){
+        char* slab = (char*) malloc(_ALLOC_HEADER +
+                                    poolallocator_slabobjs*pa->objsize);
+        if(slab == NULL){
+            return NULL;
+        }
+        *((void**) slab) = pa->slabs;
+        pa->slabs = slab;
+        pa->bump = slab + _ALLOC_HEADER;
+        pa->end = pa->bump + poolallocator_slabobjs*pa->objsize;
+    }
+    obj = pa->bump;
+    pa->bump += pa->objsize;
+    return obj;
+}
+
+/**
+ * Objects cannot change size, so only sizes that still fit succeed
+ */
+static void* _poolallocator_resize(allocator_t* a, void* ptr, size_t oldsize,
+                                   size_t size){
+    if(ptr == NULL){
+        return _poolallocator_alloc(a, size, sizeof(void*));
+    }
+    return size <= ((poolallocator_t*) a)->objsize ? ptr : NULL;
+}
+
+/**
+ * Push an object onto the free list
+ */
+static void _poolallocator_free(allocator_t* a, void* ptr, size_t size){
+    poolallocator_t* pa = (poolallocator_t*) a;
+    if(ptr != NULL){
+        *((void**) ptr) = pa->freelist;
+        pa->freelist = ptr;
+    }
+}
+
+/**
+ * Initialize an allocator for objects of one size, such as list nodes
+ * <p>
+ * Objects are carved from slabs of many objects and recycled through a free
+ * list, so allocating and freeing are O(1) and rarely call malloc. Requests
+ * for more than objsize bytes fail. Not threadsafe
+ * @param pa       The pool allocator to initialize
+ * @param objsize  The largest allocation the pool serves
+ * @return  t/f depending on the validity of the size
+ */
+bool poolallocator_init(poolallocator_t* pa, size_t objsize){
+    if(objsize == 0){
+        return false;
+    }
+    pa->allocator.alloc = _poolallocator_alloc;
+    pa->allocator.resize = _poolallocator_resize;
+    pa->allocator.free = _poolallocator_free;
+    pa->objsize = (objsize + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    pa->slabs = NULL;
+    pa->bump = NULL;
+    pa->end = NULL;
+    pa->freelist = NULL;
+    return true;
+}
+
+/**
+ * Free all slabs of a pool allocator, including objects still in use
+ * @param pa  The pool allocator to free
+ */
+void poolallocator_free(poolallocator_t* pa){
+    void* slab = pa->slabs;
+    while(slab != NULL){
+        void* next = *((void**) slab);
+        free(slab);
+        slab = next;
+    }
+    pa->slabs = NULL;
+    pa->bump = NULL;
+    pa->end = NULL;
+    pa->freelist = NULL;
+}
@@ -0,0 +1,218 @@
+/*
+ c circular buffer double ended queue structure
+*/
+#include <string.h>
+#include "arraydeque.h"
+#include "arraylist.h"
+
+/**
+ * Returns the index in the buffer of the element at position ind
+ */
+static inline size_t _ad_slot(const arraydeque_t* dq, size_t ind){
+    return (dq->head + ind) & (dq->size - 1);
+}
+
+/**
+ * Initialize an empty deque with room for arraylist_initsize elements
+ * @param dq  The pointer to intialize as an arraydeque
+ * @return  t/f depending on the successful allocation of the buffer
+ */
+bool arraydeque_init(arraydeque_t* dq){
+    dq->head = 0;
+    dq->length = 0;
+    dq->size = arraylist_initsize;
+    dq->data = (void**) malloc(arraylist_initsize*sizeof(void*));
+    return dq->data != NULL;
+}
+
+/**
+ * Frees the memory allocated for a deque
+ * <p>
+ * This function should be called when the deque is no longer needed and
+ * before freeing the pointer itself
+ * @param dq  The deque to free
+ */
+void arraydeque_free(arraydeque_t* dq){
+    free(dq->data);
+    dq->data = NULL;
+}
+
+/**
+ * Ensure that the deque has room for the specified number of elements
+ * <p>
+ * Grows the buffer by the same factor as arraylist_reserve. If the elements
+ * wrap around the end of the old buffer, the shorter of their two runs is
+ * moved so that they are contiguous modulo the new size
+ * @param dq       The deque to resize
+ * @param newsize  The number of elements to reserve memory for
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool arraydeque_reserve(arraydeque_t* dq, const size_t newsize){
+    if(dq->size >= newsize){
+        return true;
+    }
+    size_t size = dq->size;
+    while(size < newsize){
+        size *= arraylist_resize_factor;
+    }
+    void** data = (void**) realloc(dq->data, size*sizeof(void*));
+    if(data == NULL){
+        return false;
+    }
+    size_t first = dq->size - dq->head; // Length of the run starting at head
+    if(dq->length > first){
+        size_t wrapped = dq->length - first;
+        if(wrapped <= first){
+            memcpy(data + dq->size, data, wrapped*sizeof(void*));
+        }
+        else{
+            memcpy(data + size - first, data + dq->head, first*sizeof(void*));
+            dq->head = size - first;
+        }
+    }
+    dq->data = data;
+    dq->size = size;
+    return true;
+}
+
+/**
+ * Add an element to the front of the deque in O(1)
+ * @param dq    The deque to add to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool arraydeque_addfirst(arraydeque_t* dq, void* data){
+    if(!arraydeque_reserve(dq, dq->length + 1)){
+        return false;
+    }
+    dq->head = (dq->head - 1) & (dq->size - 1);
+    dq->data[dq->head] = data;
+    dq->length++;
+    return true;
+}
+
+/**
+ * Add an element to the back of the deque in O(1)
+ * @param dq    The deque to add to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool arraydeque_addlast(arraydeque_t* dq, void* data){
+    if(!arraydeque_reserve(dq, dq->length + 1)){
+        return false;
+    }
+    dq->data[_ad_slot(dq, dq->length)] = data;
+    dq->length++;
+    return true;
+}
+
+/**
+ * Add all items in an array to the back of the deque with at most two memcpys
+ * @param dq   The deque to add to
+ * @param ary  The array of pointers to add
+ * @param len  The length of the array
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool arraydeque_addall(arraydeque_t* dq, void** ary, const size_t len){
+    if(!arraydeque_reserve(dq, dq->length + len)){
+        return false;
+    }
+    size_t tail = _ad_slot(dq, dq->length);
+    size_t first = dq->size - tail < len ? dq->size - tail : len;
+    memcpy(dq->data + tail, ary, first*sizeof(void*));
+    memcpy(dq->data, ary + first, (len - first)*sizeof(void*));
+    dq->length += len;
+    return true;
+}
+
+/**
+ * Remove and return the first element of the deque in O(1)
+ * @param dq  The deque to remove from
+ * @return  The first element, or NULL if the deque is empty
+ */
+void* arraydeque_pollfirst(arraydeque_t* dq){
+    if(dq->length == 0){
+        return NULL;
+    }
+    void* data = dq->data[dq->head];
+    dq->head = (dq->head + 1) & (dq->size - 1);
+    dq->length--;
+    return data;
+}
+
+/**
+ * Remove and return the last element of the deque in O(1)
+ * @param dq  The deque to remove from
+ * @return  The last element, or NULL if the deque is empty
+ */
+void* arraydeque_polllast(arraydeque_t* dq){
+    if(dq->length == 0){
+        return NULL;
+    }
+    dq->length--;
+    return dq->data[_ad_slot(dq, dq->length)];
+}
+
+/**
+ * Remove up to max elements from the front of the deque into an array, in
+ * order, with at most two memcpys
+ * @param dq   The deque to remove from
+ * @param ary  The array to copy the removed elements to
+ * @param max  The most elements to remove, at most the length of ary
+ * @return  The number of elements removed
+ */
+size_t arraydeque_drainto(arraydeque_t* dq, void** ary, const size_t max){
+    size_t len = dq->length < max ? dq->length : max;
+    size_t first = dq->size - dq->head < len ? dq->size - dq->head : len;
+    memcpy(ary, dq->data + dq->head, first*sizeof(void*));
+    memcpy(ary + first, dq->data, (len - first)*sizeof(void*));
+    dq->head = _ad_slot(dq, len);
+    dq->length -= len;
+    return len;
+}
+
+/**
+ * Delete all elements in the deque. Does not release any memory
+ * @param dq  The deque to clear
+ */
+void arraydeque_clear(arraydeque_t* dq){
+    dq->head = 0;
+    dq->length = 0;
+}
+
+/**
+ * Returns the first element of the deque without removing it
+ * @param dq  The deque to look in
+ * @return  The first element, or NULL if the deque is empty
+ */
+void* arraydeque_peekfirst(const arraydeque_t* dq){
+    return dq->length > 0 ? dq->data[dq->head] : NULL;
+}
+
+/**
+ * Returns the last element of the deque without removing it
+ * @param dq  The deque to look in
+ * @return  The last element, or NULL if the deque is empty
+ */
+void* arraydeque_peeklast(const arraydeque_t* dq){
+    return dq->length > 0 ? dq->data[_ad_slot(dq, dq->length - 1)] : NULL;
+}
+
+/**
+ * Returns the element at the specified position from the front in O(1)
+ * @param dq   The deque to look in
+ * @param ind  The position of the element
+ * @return  The element, or NULL if the position is out of range
+ */
+void* arraydeque_get(const arraydeque_t* dq, const size_t ind){
+    return ind < dq->length ? dq->data[_ad_slot(dq, ind)] : NULL;
+}
+
+/**
+ * Returns the number of elements in the deque
+ * @param dq  The deque
+ * @return  The length of the deque
+ */
+size_t arraydeque_length(const arraydeque_t* dq){
+    return dq->length;
+}
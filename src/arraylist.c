@@ -1,10 +1,51 @@
 /*
  c dynamic array structure
 */
+#include <string.h>
+#include <stdint.h>
 #include "arraylist.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _AL_X86
+#endif
+
+// Comparisons are counted per list by the searches and per thread by the sort
+// helpers, which have no list to count in
+#ifdef JAVAUTIL_STATS
+#include <stdatomic.h>
+static _Thread_local size_t _al_cmps = 0;
+#define _AL_CMP(cmp, a, b) (_al_cmps++, (*(cmp))(a, b))
+#define _AL_LSTCMP(lst, cmp, a, b) (_STATS_INC(lst, cmps, 1), (*(cmp))(a, b))
+#else
+#define _AL_CMP(cmp, a, b) ((*(cmp))(a, b))
+#define _AL_LSTCMP(lst, cmp, a, b) ((*(cmp))(a, b))
+#endif
+
 const size_t arraylist_initsize = 8;
 const size_t arraylist_resize_factor = 2;
+const size_t arraylist_sort_insertion = 16;
+const size_t arraylist_sort_ninther = 128;
+const size_t arraylist_sort_parallel_cutoff = 8192;
+
+/**
+ * Move the unused spaces of the list so that they start at index ind
+ * <p>
+ * Only the elements between the old and the new gap position are moved
+ */
+static void _al_movegap(arraylist_t* lst, size_t ind){
+    size_t gaplen = lst->size - lst->length;
+    _STATS_INC(lst, moves, ind < lst->gap ? lst->gap - ind : ind - lst->gap);
+    if(ind < lst->gap){
+        memmove(lst->list + ind + gaplen, lst->list + ind,
+                (lst->gap - ind)*sizeof(void*));
+    }
+    else if(ind > lst->gap){
+        memmove(lst->list + lst->gap, lst->list + lst->gap + gaplen,
+                (ind - lst->gap)*sizeof(void*));
+    }
+    lst->gap = ind;
+}
 
 /**
  * Initialize a pointer to an arraylist to a default size of 8. 
@@ -12,9 +53,28 @@ const size_t arraylist_resize_factor = 2;
  * @return  t/f depending on the successful allocation of the list
  */
 bool arraylist_init(arraylist_t* lst){
+    return arraylist_init_allocator(lst, NULL);
+}
+
+/**
+ * Initialize an arraylist that takes its array from an allocator
+ * <p>
+ * A list in an arena need not be freed, since resetting the arena releases it
+ * @param lst    The pointer to intialize as an arraylist
+ * @param alloc  The allocator for the array, or NULL for malloc
+ * @return  t/f depending on the successful allocation of the list
+ */
+bool arraylist_init_allocator(arraylist_t* lst, allocator_t* alloc){
     lst->size = arraylist_initsize;
     lst->length = 0;
-    lst->list = (void**) malloc(arraylist_initsize*sizeof(void*));
+    lst->gap = 0;
+    lst->gapbuffer = false;
+    lst->alloc = alloc;
+    lst->list = (void**) allocator_alloc(alloc,
+                                         arraylist_initsize*sizeof(void*),
+                                         sizeof(void*));
+    _STATS_RESET(lst);
+    _STATS_INC(lst, bytes, arraylist_initsize*sizeof(void*));
     return lst->list != NULL;
 }
 
@@ -27,7 +87,7 @@ bool arraylist_init(arraylist_t* lst){
  */
 void arraylist_free(arraylist_t* lst){
     if (lst->list){
-        free(lst->list);
+        allocator_free(lst->alloc, lst->list, lst->size*sizeof(void*));
     }
 }
 
@@ -38,9 +98,26 @@ void arraylist_free(arraylist_t* lst){
  * @return  t/f depending on the successful allocation of the requested memory
  */
 bool arraylist_resize(arraylist_t* lst, const size_t size){
+    if(size < lst->size){
+        _al_movegap(lst, lst->length);
+    }
+    size_t tail = lst->length - lst->gap;
+    void** list = (void**) allocator_resize(lst->alloc, lst->list,
+                                            lst->size*sizeof(void*),
+                                            size*sizeof(void*));
+    if(list == NULL && size > 0){
+        return false;
+    }
+    _STATS_INC(lst, reallocs, 1);
+    _STATS_INC(lst, bytes, size*sizeof(void*));
+    _STATS_INC(lst, moves, tail);
+    if(tail > 0){
+        memmove(list + size - tail, list + lst->size - tail,
+                tail*sizeof(void*));
+    }
+    lst->list = list;
     lst->size = size;
-    lst->list = (void**) realloc(lst->list, size*sizeof(void*));
-    return lst->list != NULL;
+    return true;
 }
 
 /**
@@ -64,6 +141,45 @@ bool arraylist_reserve(arraylist_t* lst, const size_t newsize){
     return true;
 }
 
+/**
+ * Read the instrumentation counters of a list
+ * <p>
+ * The counters are only kept when the library is built with JAVAUTIL_STATS,
+ * otherwise they all read as 0
+ * @param lst    The arraylist to read the counters of
+ * @param stats  Set to the counters accumulated since the list was initialized
+ *               or the counters were last reset
+ */
+void arraylist_stats(const arraylist_t* lst, javautil_stats_t* stats){
+    _STATS_READ(lst, stats);
+}
+
+/**
+ * Zero the instrumentation counters of a list. The high water mark restarts
+ * from the current length
+ * @param lst  The arraylist to reset the counters of
+ */
+void arraylist_resetstats(arraylist_t* lst){
+    _STATS_RESET(lst);
+    _STATS_MAX(lst, highwater, lst->length);
+}
+
+/**
+ * Turn gap buffer mode on or off
+ * <p>
+ * In gap buffer mode the unused spaces of the list are kept at the last edit
+ * instead of at the end, so adds and removes near the previous one only move
+ * the elements in between. Turning the mode off moves the gap back to the end
+ * @param lst  The arraylist
+ * @param on   Whether to keep the gap at the last edit
+ */
+void arraylist_setgapbuffer(arraylist_t* lst, bool on){
+    if(!on){
+        _al_movegap(lst, lst->length);
+    }
+    lst->gapbuffer = on;
+}
+
 /**
  * Append the given item to the arraylist
  * @param lst   The arraylist to append to
@@ -71,12 +187,15 @@ bool arraylist_reserve(arraylist_t* lst, const size_t newsize){
  * @return  t/f depending on the successful addition of the item to the array
  */
 bool arraylist_append(arraylist_t* lst, void* data){
-    bool success = arraylist_reserve(lst, lst->length + 1);
-    if(success){
-        lst->list[lst->length] = data;
-        lst->length++;
+    if(!arraylist_reserve(lst, lst->length + 1)){
+        return false;
     }
-    return success;
+    _al_movegap(lst, lst->length);
+    lst->list[lst->length] = data;
+    lst->length++;
+    lst->gap++;
+    _STATS_MAX(lst, highwater, lst->length);
+    return true;
 }
 
 /**
@@ -84,19 +203,11 @@ bool arraylist_append(arraylist_t* lst, void* data){
  * @param lst   The arraylist to add to
  * @param ind   The index at which to add the data
  * @param data  The data to add
- * @return  t/f depending on the successful addition of the item to the array
+ * @return  t/f depending on the validity of the index and the successful
+ *          addition of the item to the array
  */
 bool arraylist_add(arraylist_t* lst, const size_t ind, void* data){
-    bool success = arraylist_reserve(lst, lst->length + 1);
-    if(success){
-        size_t i;
-        for(i = lst->length; i > ind; i--){
-            lst->list[i] = lst->list[i - 1];
-        }
-        lst->list[i] = data;
-        lst->length++;
-    }
-    return success;
+    return arraylist_addall(lst, ind, 1, &data);
 }
 
 /**
@@ -105,21 +216,27 @@ bool arraylist_add(arraylist_t* lst, const size_t ind, void* data){
  * @param ind  The index at which to add the fist element of the array
  * @param len  The length of the array of data to add
  * @param ary  The array of pointers to add to the list
- * @return  t/f depending on the successful addition of the items to the array
+ * @return  t/f depending on the validity of the index and the successful
+ *          addition of the items to the array
  */
 bool arraylist_addall(arraylist_t* lst, const size_t ind, const size_t len, 
                       void** ary){
-    bool success = arraylist_reserve(lst, lst->length + len);
-    if(success){
-        size_t i;
-        for(i = lst->length + len; i > ind + len; i--){
-            lst->list[i] = lst->list[i - 1];
-        }
-        for(i = ind + len; i > ind; i--){
-            lst->list[i] = ary[i];
-        }
+    if(ind > lst->length || !arraylist_reserve(lst, lst->length + len)){
+        return false;
     }
-    return success;
+    if(lst->gapbuffer){
+        _al_movegap(lst, ind);
+    }
+    else{
+        memmove(lst->list + ind + len, lst->list + ind,
+                (lst->length - ind)*sizeof(void*));
+        _STATS_INC(lst, moves, lst->length - ind);
+    }
+    memcpy(lst->list + ind, ary, len*sizeof(void*));
+    lst->length += len;
+    _STATS_MAX(lst, highwater, lst->length);
+    lst->gap = lst->gapbuffer ? ind + len : lst->length;
+    return true;
 }
 
 /**
@@ -127,14 +244,26 @@ bool arraylist_addall(arraylist_t* lst, const size_t ind, const size_t len,
  * data pointer
  * @param lst  The arraylist to remove from
  * @param ind  The index of the element to remove
- * @return  The removed element
+ * @return  The removed element, or NULL if the index is out of range
  */
 void* arraylist_remove(arraylist_t* lst, const size_t ind){
-    void* data = lst->list[ind];
-    size_t i;
-    for(i = ind; i < lst->length - 1; i++){
-        lst->list[i] = lst->list[i + 1];
+    if(ind >= lst->length){
+        return NULL;
+    }
+    void* data;
+    if(lst->gapbuffer){
+        _al_movegap(lst, ind + 1);
+        data = lst->list[ind];
+        lst->gap = ind;
+    }
+    else{
+        data = lst->list[ind];
+        memmove(lst->list + ind, lst->list + ind + 1,
+                (lst->length - ind - 1)*sizeof(void*));
+        _STATS_INC(lst, moves, lst->length - ind - 1);
+        lst->gap = lst->length - 1;
     }
+    lst->length--;
     return data;
 }
 
@@ -143,11 +272,8 @@ void* arraylist_remove(arraylist_t* lst, const size_t ind){
  * @param  lst The arraylist to clear
  */
 void arraylist_clear(arraylist_t* lst){
-    size_t i;
-    for(i = 0; i < lst->length; i++){
-        lst->list[i] = NULL;
-    }
     lst->length = 0;
+    lst->gap = 0;
 }
 
 /**
@@ -161,10 +287,16 @@ size_t arraylist_length(const arraylist_t* lst){
 
 /**
  * Returns a pointer to the dynamic array contained in this arraylist
+ * <p>
+ * In gap buffer mode the gap is first moved to the end, so the elements are
+ * contiguous until the next edit. That changes the layout of the buffer
+ * though not the contents of the list, so the call counts as a write when
+ * the list is shared between threads
  * @param lst  The arraylist
  * @return  The array held by the given arraylist
  */
-void** arraylist_toarray(const arraylist_t* lst){
+void** arraylist_toarray(arraylist_t* lst){
+    _al_movegap(lst, lst->length);
     return lst->list;
 }
 
@@ -175,7 +307,7 @@ void** arraylist_toarray(const arraylist_t* lst){
  * @return  The element at the specified index
  */
 void* arraylist_get(const arraylist_t* lst, const size_t ind){
-    return lst->list[ind];
+    return lst->list[ind < lst->gap ? ind : ind + lst->size - lst->length];
 }
 
 /**
@@ -186,8 +318,511 @@ void* arraylist_get(const arraylist_t* lst, const size_t ind){
 ptrdiff_t arraylist_indexof(const arraylist_t* lst, const void* data, 
                             int (*cmp) (const void*, const void*)){
     size_t i = 0;
-    while(i < lst->length && (*cmp)(data, lst->list[i]) != 0){
+    while(i < lst->gap && _AL_LSTCMP(lst, cmp, data, lst->list[i]) != 0){
+        i++;
+    }
+    if(i < lst->gap){
+        return i;
+    }
+    void** tail = lst->list + lst->size - lst->length;
+    while(i < lst->length && _AL_LSTCMP(lst, cmp, data, tail[i]) != 0){
         i++;
     }
     return i < lst->length ? i : -1;
 }
+
+/**
+ * Returns the position of the first slot of a holding key, or n if none does
+ */
+static size_t _al_find_scalar(void* const* a, size_t n, const void* key){
+    size_t i = 0;
+    while(i < n && a[i] != key){
+        i++;
+    }
+    return i;
+}
+
+#ifdef _AL_X86
+/**
+ * Compare the 16 bytes of slots at a with the broadcast key k, returning all
+ * ones in every slot that matches
+ * <p>
+ * SSE2 has no 64 bit compare, so pointers are compared as pairs of 32 bit
+ * halves and a slot matches when both of its halves do
+ */
+static inline __m128i _al_eqslots_sse2(void* const* a, __m128i k){
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) a), k);
+    if(sizeof(void*) == 8){
+        eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+    return eq;
+}
+
+/**
+ * Returns the position of the first slot of a holding key, or n if none does,
+ * comparing 64 bytes of slots per iteration with SSE2
+ */
+static size_t _al_find_sse2(void* const* a, size_t n, const void* key){
+    const size_t lanes = 16/sizeof(void*);
+    __m128i k = sizeof(void*) == 8 ? _mm_set1_epi64x((int64_t) (intptr_t) key)
+                                   : _mm_set1_epi32((int) (intptr_t) key);
+    size_t i = 0;
+    for(; i + 4*lanes <= n; i += 4*lanes){
+        __m128i any = _mm_or_si128(
+            _mm_or_si128(_al_eqslots_sse2(a + i, k),
+                         _al_eqslots_sse2(a + i + lanes, k)),
+            _mm_or_si128(_al_eqslots_sse2(a + i + 2*lanes, k),
+                         _al_eqslots_sse2(a + i + 3*lanes, k)));
+        if(_mm_movemask_epi8(any) != 0){
+            break;
+        }
+    }
+    return i + _al_find_scalar(a + i, n - i, key);
+}
+
+/**
+ * Returns the position of the first slot of a holding key, or n if none does,
+ * comparing 16 pointers per iteration with AVX2
+ */
+__attribute__((target("avx2")))
+static size_t _al_find_avx2(void* const* a, size_t n, const void* key){
+    size_t i = 0;
+    if(sizeof(void*) == 8){
+        __m256i k = _mm256_set1_epi64x((int64_t) (intptr_t) key);
+        for(; i + 16 <= n; i += 16){
+            const __m256i* p = (const __m256i*) (a + i);
+            __m256i e0 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p), k);
+            __m256i e1 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 1), k);
+            __m256i e2 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 2), k);
+            __m256i e3 = _mm256_cmpeq_epi64(_mm256_loadu_si256(p + 3), k);
+            __m256i any = _mm256_or_si256(_mm256_or_si256(e0, e1),
+                                          _mm256_or_si256(e2, e3));
+            if(!_mm256_testz_si256(any, any)){
+                break;
+            }
+        }
+    }
+    return i + _al_find_scalar(a + i, n - i, key);
+}
+#endif
+
+/**
+ * Search a run of slots for a pointer with the widest compare the cpu supports
+ */
+static size_t _al_find(void* const* a, size_t n, const void* key){
+#ifdef _AL_X86
+    if(__builtin_cpu_supports("avx2")){
+        return _al_find_avx2(a, n, key);
+    }
+    return _al_find_sse2(a, n, key);
+#else
+    return _al_find_scalar(a, n, key);
+#endif
+}
+
+/**
+ * Searches the arraylist for the given pointer itself rather than an equal
+ * element. Returns the index at which the pointer was found or -1 if it was
+ * not found
+ * <p>
+ * Compares many pointers per instruction with SSE2 or AVX2, so the search runs
+ * at close to memory bandwidth
+ */
+ptrdiff_t arraylist_indexof_identity(const arraylist_t* lst, const void* data){
+    size_t i = _al_find(lst->list, lst->gap, data);
+    if(i < lst->gap){
+        return i;
+    }
+    size_t taillen = lst->length - lst->gap;
+    i = _al_find(lst->list + lst->size - taillen, taillen, data);
+    return i < taillen ? (ptrdiff_t) (lst->gap + i) : -1;
+}
+
+/**
+ * Returns the number of elements of a sorted list that order before data, or
+ * not after data if upper
+ */
+static size_t _al_searchbound(const arraylist_t* lst, const void* data,
+                              bool upper, int (*cmp)(const void*, const void*)){
+    size_t lo = 0;
+    size_t n = lst->length;
+    while(n > 0){
+        size_t half = n/2;
+        int c = _AL_LSTCMP(lst, cmp, data, arraylist_get(lst, lo + half));
+        if(c > 0 || (upper && c == 0)){
+            lo += half + 1;
+            n -= half + 1;
+        }
+        else{
+            n = half;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Searches a list sorted in ascending order of the comparator for an element
+ * equal to data in O(log n)
+ * @param lst   The sorted arraylist to look in
+ * @param data  The element to look for
+ * @param cmp   The compare function, called with data and an element
+ * @return  The index of the first equal element if there is one. Otherwise
+ *          -(insertion point) - 1, where the insertion point is the index at
+ *          which data would have to be added to keep the list sorted
+ */
+ptrdiff_t arraylist_binarysearch(const arraylist_t* lst, const void* data,
+                                 int (*cmp)(const void*, const void*)){
+    size_t ind = _al_searchbound(lst, data, false, cmp);
+    if(ind < lst->length &&
+       _AL_LSTCMP(lst, cmp, data, arraylist_get(lst, ind)) == 0){
+        return (ptrdiff_t) ind;
+    }
+    return -((ptrdiff_t) ind) - 1;
+}
+
+/**
+ * Add an element to a list sorted in ascending order of the comparator,
+ * keeping it sorted
+ * <p>
+ * The element is added after any equal elements, so equal elements stay in
+ * the order they were added. Runs of nearby insertions are cheap in gap buffer
+ * mode
+ * @param lst   The sorted arraylist to add to
+ * @param data  The element to add
+ * @param cmp   The compare function, called with data and an element
+ * @return  t/f depending on the successful addition of the item to the array
+ */
+bool arraylist_add_sorted(arraylist_t* lst, void* data,
+                          int (*cmp)(const void*, const void*)){
+    return arraylist_add(lst, _al_searchbound(lst, data, true, cmp), data);
+}
+
+/**
+ * Sort a short array by insertion
+ */
+static void _al_insertionsort(void** a, size_t n,
+                              int (*cmp)(const void*, const void*)){
+    size_t i;
+    for(i = 1; i < n; i++){
+        void* elem = a[i];
+        size_t j = i;
+        while(j > 0 && _AL_CMP(cmp, elem, a[j - 1]) < 0){
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = elem;
+    }
+}
+
+/**
+ * Restore the max-heap order below ind in a heap of n elements
+ */
+static void _al_siftdown(void** a, size_t ind, size_t n,
+                         int (*cmp)(const void*, const void*)){
+    void* elem = a[ind];
+    size_t child;
+    while((child = 2*ind + 1) < n){
+        if(child + 1 < n && _AL_CMP(cmp, a[child], a[child + 1]) < 0){
+            child++;
+        }
+        if(_AL_CMP(cmp, elem, a[child]) >= 0){
+            break;
+        }
+        a[ind] = a[child];
+        ind = child;
+    }
+    a[ind] = elem;
+}
+
+/**
+ * Sort an array with heapsort, used when quicksort recurses too deeply
+ */
+static void _al_heapsort(void** a, size_t n,
+                         int (*cmp)(const void*, const void*)){
+    size_t i;
+    for(i = n/2; i > 0; i--){
+        _al_siftdown(a, i - 1, n, cmp);
+    }
+    for(i = n - 1; i > 0; i--){
+        void* top = a[0];
+        a[0] = a[i];
+        a[i] = top;
+        _al_siftdown(a, 0, i, cmp);
+    }
+}
+
+/**
+ * Returns whichever of the indices i, j and k holds the median of the three
+ */
+static inline size_t _al_med3(void** a, size_t i, size_t j, size_t k,
+                              int (*cmp)(const void*, const void*)){
+    if(_AL_CMP(cmp, a[i], a[j]) < 0){
+        if(_AL_CMP(cmp, a[j], a[k]) < 0){
+            return j;
+        }
+        return _AL_CMP(cmp, a[i], a[k]) < 0 ? k : i;
+    }
+    if(_AL_CMP(cmp, a[k], a[j]) < 0){
+        return j;
+    }
+    return _AL_CMP(cmp, a[k], a[i]) < 0 ? k : i;
+}
+
+/**
+ * Sort an array with introsort: quicksort with a median of three pivot that
+ * switches to heapsort after depth levels and to insertion sort for short
+ * ranges. Recurses on the smaller side so the stack stays O(log n)
+ */
+static void _al_introsort(void** a, size_t n, size_t depth,
+                          int (*cmp)(const void*, const void*)){
+    while(n > arraylist_sort_insertion){
+        if(depth == 0){
+            _al_heapsort(a, n, cmp);
+            return;
+        }
+        depth--;
+        void* tmp;
+        size_t mid = n/2;
+        if(n > arraylist_sort_ninther){
+            // Tukey's ninther resists inputs made of a few sorted runs
+            size_t s = n/8;
+            size_t m = _al_med3(a, _al_med3(a, 1, s, 2*s, cmp),
+                                _al_med3(a, mid - s, mid, mid + s, cmp),
+                                _al_med3(a, n - 2 - 2*s, n - 2 - s, n - 2, cmp),
+                                cmp);
+            tmp = a[mid]; a[mid] = a[m]; a[m] = tmp;
+        }
+        if(_AL_CMP(cmp, a[mid], a[0]) < 0){
+            tmp = a[mid]; a[mid] = a[0]; a[0] = tmp;
+        }
+        if(_AL_CMP(cmp, a[n - 1], a[mid]) < 0){
+            tmp = a[n - 1]; a[n - 1] = a[mid]; a[mid] = tmp;
+            if(_AL_CMP(cmp, a[mid], a[0]) < 0){
+                tmp = a[mid]; a[mid] = a[0]; a[0] = tmp;
+            }
+        }
+        // a[0] <= pivot <= a[n - 1] stop both scans
+        void* pivot = a[mid];
+        size_t i = 0;
+        size_t j = n - 1;
+        for(;;){
+            while(_AL_CMP(cmp, a[++i], pivot) < 0);
+            while(_AL_CMP(cmp, pivot, a[--j]) < 0);
+            if(i >= j){
+                break;
+            }
+            tmp = a[i]; a[i] = a[j]; a[j] = tmp;
+        }
+        if(i < n - i){
+            _al_introsort(a, i, depth, cmp);
+            a += i;
+            n -= i;
+        }
+        else{
+            _al_introsort(a + i, n - i, depth, cmp);
+            n = i;
+        }
+    }
+    _al_insertionsort(a, n, cmp);
+}
+
+/**
+ * Sort an array of n elements with introsort
+ */
+static void _al_sortarray(void** a, size_t n,
+                          int (*cmp)(const void*, const void*)){
+    size_t depth = 0;
+    size_t m;
+    for(m = n; m > 1; m >>= 1){
+        depth += 2;
+    }
+    _al_introsort(a, n, depth, cmp);
+}
+
+/**
+ * Sorts the elements of the list in ascending order of the comparator
+ * <p>
+ * Uses introsort, so the sort takes O(n log n) time in the worst case and is
+ * not stable
+ * @param lst  The arraylist to sort
+ * @param cmp  The compare function, called with two elements of the list
+ */
+void arraylist_sort(arraylist_t* lst, int (*cmp)(const void*, const void*)){
+    _al_movegap(lst, lst->length);
+    _STATS_ONLY(size_t cmps = _al_cmps;)
+    _al_sortarray(lst->list, lst->length, cmp);
+    _STATS_INC(lst, cmps, _al_cmps - cmps);
+}
+
+typedef struct _almerge_t _almerge_t;
+struct _almerge_t{
+    threadpool_t* pool;                  // Pool to fork halves onto
+    void** a;                            // First sorted run
+    size_t na;                           // Length of a
+    void** b;                            // Second sorted run
+    size_t nb;                           // Length of b
+    void** out;                          // Receives the na + nb elements
+    int (*cmp)(const void*, const void*); // Element comparator
+#ifdef JAVAUTIL_STATS
+    atomic_size_t* cmps;                 // Comparisons made by the sort
+#endif
+};
+
+typedef struct _alsort_t _alsort_t;
+struct _alsort_t{
+    threadpool_t* pool;                  // Pool to fork halves onto
+    void** src;                          // Elements to sort
+    void** tmp;                          // Scratch space as long as src
+    size_t n;                            // # of elements
+    bool totmp;                          // Whether the result goes to tmp
+    size_t cutoff;                       // Largest range to sort sequentially
+    int (*cmp)(const void*, const void*); // Element comparator
+#ifdef JAVAUTIL_STATS
+    atomic_size_t* cmps;                 // Comparisons made by the sort
+#endif
+};
+
+/**
+ * Returns the number of elements of a sorted run that order before elem, or
+ * not after elem if upper
+ */
+static size_t _al_bound(void** a, size_t n, const void* elem, bool upper,
+                        int (*cmp)(const void*, const void*)){
+    size_t lo = 0;
+    while(n > 0){
+        size_t half = n/2;
+        int c = _AL_CMP(cmp, a[lo + half], elem);
+        if(c < 0 || (upper && c == 0)){
+            lo += half + 1;
+            n -= half + 1;
+        }
+        else{
+            n = half;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Merge two sorted runs, splitting the work at the median of the longer run
+ * and merging both halves in parallel while the runs are long
+ */
+static void _al_pmerge(void* arg){
+    _almerge_t* job = (_almerge_t*) arg;
+    void** a = job->a;
+    void** b = job->b;
+    size_t na = job->na;
+    size_t nb = job->nb;
+    // Only the sequential parts are counted, since the thread may run other
+    // tasks while it joins
+    _STATS_ONLY(size_t cmps = _al_cmps;)
+    if(na + nb <= arraylist_sort_parallel_cutoff){
+        void** out = job->out;
+        void** aend = a + na;
+        void** bend = b + nb;
+        while(a < aend && b < bend){
+            *out++ = _AL_CMP(job->cmp, *b, *a) < 0 ? *b++ : *a++;
+        }
+        memcpy(out, a, (aend - a)*sizeof(void*));
+        memcpy(out + (aend - a), b, (bend - b)*sizeof(void*));
+        _STATS_ONLY(atomic_fetch_add_explicit(job->cmps, _al_cmps - cmps,
+                                              memory_order_relaxed);)
+        return;
+    }
+    // Equal elements of a stay before those of b
+    size_t ma, mb;
+    if(na >= nb){
+        ma = na/2;
+        mb = _al_bound(b, nb, a[ma], false, job->cmp);
+    }
+    else{
+        mb = nb/2;
+        ma = _al_bound(a, na, b[mb], true, job->cmp);
+    }
+    _almerge_t left = {job->pool, a, ma, b, mb, job->out, job->cmp};
+    _almerge_t right = {job->pool, a + ma, na - ma, b + mb, nb - mb,
+                        job->out + ma + mb, job->cmp};
+    _STATS_ONLY(left.cmps = right.cmps = job->cmps;)
+    _STATS_ONLY(atomic_fetch_add_explicit(job->cmps, _al_cmps - cmps,
+                                          memory_order_relaxed);)
+    threadpool_task_t task;
+    threadpool_fork(job->pool, &task, _al_pmerge, &left);
+    _al_pmerge(&right);
+    threadpool_join(job->pool, &task);
+}
+
+/**
+ * Merge sort a range, sorting both halves in parallel and ping-ponging
+ * between the array and the scratch space so no level copies back
+ */
+static void _al_psort(void* arg){
+    _alsort_t* job = (_alsort_t*) arg;
+    if(job->n <= job->cutoff){
+        _STATS_ONLY(size_t cmps = _al_cmps;)
+        _al_sortarray(job->src, job->n, job->cmp);
+        _STATS_ONLY(atomic_fetch_add_explicit(job->cmps, _al_cmps - cmps,
+                                              memory_order_relaxed);)
+        if(job->totmp){
+            memcpy(job->tmp, job->src, job->n*sizeof(void*));
+        }
+        return;
+    }
+    size_t m = job->n/2;
+    _alsort_t left = *job;
+    _alsort_t right = *job;
+    left.n = m;
+    left.totmp = !job->totmp;
+    right.src += m;
+    right.tmp += m;
+    right.n -= m;
+    right.totmp = !job->totmp;
+    threadpool_task_t task;
+    threadpool_fork(job->pool, &task, _al_psort, &left);
+    _al_psort(&right);
+    threadpool_join(job->pool, &task);
+    void** from = job->totmp ? job->src : job->tmp;
+    _almerge_t merge = {job->pool, from, m, from + m, job->n - m,
+                        job->totmp ? job->tmp : job->src, job->cmp};
+    _STATS_ONLY(merge.cmps = job->cmps;)
+    _al_pmerge(&merge);
+}
+
+/**
+ * Sorts the elements of the list in ascending order of the comparator using
+ * the threads of a pool
+ * <p>
+ * Runs a parallel merge sort with parallel merges, sorting ranges small
+ * enough for one thread with introsort. Needs scratch space for length
+ * pointers and falls back to arraylist_sort if it cannot be allocated, if
+ * the pool has no workers or if the list is short. The sort is not stable
+ * @param lst   The arraylist to sort
+ * @param cmp   The compare function, called with two elements of the list
+ *              from several threads at once
+ * @param pool  The pool to run on, or NULL for threadpool_default()
+ */
+void arraylist_parallel_sort(arraylist_t* lst,
+                             int (*cmp)(const void*, const void*),
+                             threadpool_t* pool){
+    if(pool == NULL){
+        pool = threadpool_default();
+    }
+    size_t threads = pool != NULL ? threadpool_parallelism(pool) : 1;
+    void** tmp = NULL;
+    if(threads > 1 && lst->length > arraylist_sort_parallel_cutoff){
+        tmp = (void**) malloc(lst->length*sizeof(void*));
+    }
+    if(tmp == NULL){
+        arraylist_sort(lst, cmp);
+        return;
+    }
+    _al_movegap(lst, lst->length);
+    // Several leaves per thread let idle threads steal the remaining work
+    size_t cutoff = lst->length/(8*threads);
+    cutoff = cutoff > arraylist_sort_parallel_cutoff ?
+             cutoff : arraylist_sort_parallel_cutoff;
+    _alsort_t job = {pool, lst->list, tmp, lst->length, false, cutoff, cmp};
+    _STATS_ONLY(atomic_size_t sortcmps = 0; job.cmps = &sortcmps;)
+    _al_psort(&job);
+    _STATS_INC(lst, cmps, atomic_load(&sortcmps));
+    free(tmp);
+}
@@ -0,0 +1,367 @@
+/*
+ c vector of bits structure
+*/
+#include <string.h>
+#include "bitset.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _BS_X86
+#endif
+
+const size_t bitset_initwords = 1;
+const size_t bitset_resize_factor = 2;
+
+#define _BS_AND(x, y) ((x) & (y))
+#define _BS_OR(x, y) ((x) | (y))
+#define _BS_XOR(x, y) ((x) ^ (y))
+#define _BS_ANDNOT(x, y) ((x) & ~(y))
+#define _BS_AND256(x, y) _mm256_and_si256(x, y)
+#define _BS_OR256(x, y) _mm256_or_si256(x, y)
+#define _BS_XOR256(x, y) _mm256_xor_si256(x, y)
+#define _BS_ANDNOT256(x, y) _mm256_andnot_si256(y, x)
+
+/*
+ Defines _bs_name_scalar and, on x86, _bs_name_avx2, which combine n words of
+ b into a with op. The AVX2 kernel handles 16 words per iteration in four
+ independent registers, so it keeps enough loads in flight to run at memory
+ bandwidth
+*/
+#ifdef _BS_X86
+#define _BS_KERNELS(name, op, op256)                                          \
+static void _bs_##name##_scalar(uint64_t* a, const uint64_t* b, size_t n){   \
+    size_t i;                                                                \
+    for(i = 0; i < n; i++){                                                  \
+        a[i] = op(a[i], b[i]);                                               \
+    }                                                                        \
+}                                                                            \
+__attribute__((target("avx2")))                                              \
+static void _bs_##name##_avx2(uint64_t* a, const uint64_t* b, size_t n){     \
+    size_t i, j;                                                             \
+    for(i = 0; i + 16 <= n; i += 16){                                        \
+        __m256i* pa = (__m256i*) (a + i);                                    \
+        const __m256i* pb = (const __m256i*) (b + i);                        \
+        for(j = 0; j < 4; j++){                                              \
+            _mm256_storeu_si256(pa + j, op256(_mm256_loadu_si256(pa + j),    \
+                                              _mm256_loadu_si256(pb + j)));  \
+        }                                                                    \
+    }                                                                        \
+    _bs_##name##_scalar(a + i, b + i, n - i);                                \
+}
+#else
+#define _BS_KERNELS(name, op, op256)                                          \
+static void _bs_##name##_scalar(uint64_t* a, const uint64_t* b, size_t n){   \
+    size_t i;                                                                \
+    for(i = 0; i < n; i++){                                                  \
+        a[i] = op(a[i], b[i]);                                               \
+    }                                                                        \
+}
+#endif
+
+_BS_KERNELS(and, _BS_AND, _BS_AND256)
+_BS_KERNELS(or, _BS_OR, _BS_OR256)
+_BS_KERNELS(xor, _BS_XOR, _BS_XOR256)
+_BS_KERNELS(andnot, _BS_ANDNOT, _BS_ANDNOT256)
+
+#ifdef _BS_X86
+#define _BS_PICK(name) \
+    (__builtin_cpu_supports("avx2") ? _bs_##name##_avx2 : _bs_##name##_scalar)
+#else
+#define _BS_PICK(name) _bs_##name##_scalar
+#endif
+
+static size_t _bs_popcount_scalar(const uint64_t* a, size_t n){
+    size_t count = 0;
+    size_t i;
+    for(i = 0; i < n; i++){
+        count += (size_t) __builtin_popcountll(a[i]);
+    }
+    return count;
+}
+
+#ifdef _BS_X86
+/**
+ * Returns the number of set bits in a vector, as a count per byte
+ * <p>
+ * Each nibble is counted with a table lookup in vpshufb, so a byte counts at
+ * most 8
+ */
+__attribute__((target("avx2")))
+static inline __m256i _bs_popcount256(__m256i v){
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3,
+                                         2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+                                         1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(
+                                              _mm256_srli_epi16(v, 4), low));
+    return _mm256_add_epi8(lo, hi);
+}
+
+/**
+ * Returns the number of set bits in n words with AVX2
+ * <p>
+ * The byte counts of two vectors per iteration go to separate accumulators,
+ * so the additions do not wait on each other. A byte of an accumulator can
+ * take 31 counts without overflowing, after which they are summed into 64 bit
+ * lanes with vpsadbw
+ */
+__attribute__((target("avx2")))
+static size_t _bs_popcount_avx2(const uint64_t* a, size_t n){
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+    size_t i = 0;
+    while(i + 8 <= n){
+        size_t end = n - i < 8*31 ? n : i + 8*31;
+        __m256i acc0 = zero;
+        __m256i acc1 = zero;
+        for(; i + 8 <= end; i += 8){
+            const __m256i* p = (const __m256i*) (a + i);
+            acc0 = _mm256_add_epi8(acc0,
+                                   _bs_popcount256(_mm256_loadu_si256(p)));
+            acc1 = _mm256_add_epi8(acc1,
+                                   _bs_popcount256(_mm256_loadu_si256(p + 1)));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc0, zero));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc1, zero));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, total);
+    return (size_t) (lanes[0] + lanes[1] + lanes[2] + lanes[3]) +
+           _bs_popcount_scalar(a + i, n - i);
+}
+#endif
+
+/**
+ * Returns the number of words up to and including the last nonzero word
+ */
+static size_t _bs_wordsinuse(const bitset_t* bs){
+    size_t n = bs->nwords;
+    while(n > 0 && bs->words[n - 1] == 0){
+        n--;
+    }
+    return n;
+}
+
+/**
+ * Initialize an empty bitset with room for 64 bits
+ * @param bs  The pointer to initialize as a bitset
+ * @return  t/f depending on the successful allocation of the words
+ */
+bool bitset_init(bitset_t* bs){
+    bs->words = (uint64_t*) calloc(bitset_initwords, sizeof(uint64_t));
+    bs->nwords = bs->words != NULL ? bitset_initwords : 0;
+    return bs->words != NULL;
+}
+
+/**
+ * Frees the memory allocated for a bitset
+ * <p>
+ * This function should be called when the bitset is no longer needed and
+ * before freeing the pointer itself
+ * @param bs  The bitset to free
+ */
+void bitset_free(bitset_t* bs){
+    free(bs->words);
+    bs->words = NULL;
+    bs->nwords = 0;
+}
+
+/**
+ * Ensure that the bitset has the specified number of words allocated, growing
+ * by a factor of 2 and clearing the new words. The growth stops at the needed
+ * size where doubling would overflow, and word counts whose bytes cannot be
+ * counted in a size_t are refused
+ */
+static bool _bs_reservewords(bitset_t* bs, size_t needed){
+    const size_t maxwords = SIZE_MAX/sizeof(uint64_t);
+    if(bs->nwords >= needed){
+        return true;
+    }
+    if(needed > maxwords){
+        return false;
+    }
+    size_t nwords = bs->nwords > 0 ? bs->nwords : bitset_initwords;
+    while(nwords < needed){
+        if(nwords > maxwords/bitset_resize_factor){
+            nwords = needed;
+            break;
+        }
+        nwords *= bitset_resize_factor;
+    }
+    uint64_t* words = (uint64_t*) realloc(bs->words,
+                                          nwords*sizeof(uint64_t));
+    if(words == NULL){
+        return false;
+    }
+    memset(words + bs->nwords, 0, (nwords - bs->nwords)*sizeof(uint64_t));
+    bs->words = words;
+    bs->nwords = nwords;
+    return true;
+}
+
+/**
+ * Ensure that the bitset has words allocated for the specified number of bits
+ * <p>
+ * Grows by a factor of 2 if there is not enough space, and clears the new
+ * words
+ * @param bs     The bitset to resize
+ * @param nbits  The number of bits to reserve memory for
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool bitset_reserve(bitset_t* bs, size_t nbits){
+    return _bs_reservewords(bs, nbits/64 + (nbits % 64 != 0));
+}
+
+/**
+ * Set a bit, growing the bitset if it is past the allocated words
+ * @param bs   The bitset
+ * @param ind  The index of the bit
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool bitset_set(bitset_t* bs, size_t ind){
+    if(!_bs_reservewords(bs, ind/64 + 1)){
+        return false;
+    }
+    bs->words[ind/64] |= (uint64_t) 1 << (ind % 64);
+    return true;
+}
+
+/**
+ * Clear a bit
+ * @param bs   The bitset
+ * @param ind  The index of the bit
+ */
+void bitset_clear(bitset_t* bs, size_t ind){
+    if(ind/64 < bs->nwords){
+        bs->words[ind/64] &= ~((uint64_t) 1 << (ind % 64));
+    }
+}
+
+/**
+ * Clear every bit. Does not release any memory
+ * @param bs  The bitset to clear
+ */
+void bitset_clearall(bitset_t* bs){
+    memset(bs->words, 0, bs->nwords*sizeof(uint64_t));
+}
+
+/**
+ * Returns the value of a bit
+ * @param bs   The bitset
+ * @param ind  The index of the bit
+ * @return  t/f depending on the bit being set
+ */
+bool bitset_get(const bitset_t* bs, size_t ind){
+    return ind/64 < bs->nwords && (bs->words[ind/64] >> (ind % 64) & 1);
+}
+
+/**
+ * Returns the index of the first set bit at or after a given index. All set
+ * bits are visited in order with
+ * for(i = bitset_nextsetbit(bs, 0); i >= 0; i = bitset_nextsetbit(bs, i + 1))
+ * @param bs    The bitset to look in
+ * @param from  The index to start looking at
+ * @return  The index of the next set bit, or -1 if there is none
+ */
+ptrdiff_t bitset_nextsetbit(const bitset_t* bs, size_t from){
+    size_t i = from/64;
+    if(i >= bs->nwords){
+        return -1;
+    }
+    uint64_t word = bs->words[i] & (~(uint64_t) 0 << (from % 64));
+    while(word == 0){
+        if(++i == bs->nwords){
+            return -1;
+        }
+        word = bs->words[i];
+    }
+    return (ptrdiff_t) (i*64 + (size_t) __builtin_ctzll(word));
+}
+
+/**
+ * Returns the number of set bits, counted with AVX2 when the cpu supports it
+ * @param bs  The bitset
+ * @return  The number of set bits
+ */
+size_t bitset_cardinality(const bitset_t* bs){
+#ifdef _BS_X86
+    if(__builtin_cpu_supports("avx2")){
+        return _bs_popcount_avx2(bs->words, bs->nwords);
+    }
+#endif
+    return _bs_popcount_scalar(bs->words, bs->nwords);
+}
+
+/**
+ * Returns the logical length of the bitset, the index of its highest set bit
+ * plus one
+ * @param bs  The bitset
+ * @return  The length of the bitset, 0 if no bit is set
+ */
+size_t bitset_length(const bitset_t* bs){
+    size_t i = _bs_wordsinuse(bs);
+    return i > 0 ? i*64 - (size_t) __builtin_clzll(bs->words[i - 1]) : 0;
+}
+
+/**
+ * Returns the number of bits the bitset has memory for
+ * @param bs  The bitset
+ * @return  The number of allocated bits, a multiple of 64
+ */
+size_t bitset_size(const bitset_t* bs){
+    return bs->nwords*64;
+}
+
+/**
+ * Clear every bit of bs that is not set in other
+ * @param bs     The bitset to modify
+ * @param other  The bitset to intersect with
+ */
+void bitset_and(bitset_t* bs, const bitset_t* other){
+    size_t n = bs->nwords < other->nwords ? bs->nwords : other->nwords;
+    _BS_PICK(and)(bs->words, other->words, n);
+    memset(bs->words + n, 0, (bs->nwords - n)*sizeof(uint64_t));
+}
+
+/**
+ * Set every bit of bs that is set in other, growing bs if other has a higher
+ * set bit
+ * @param bs     The bitset to modify
+ * @param other  The bitset to take the union with
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool bitset_or(bitset_t* bs, const bitset_t* other){
+    size_t n = _bs_wordsinuse(other);
+    if(!_bs_reservewords(bs, n)){
+        return false;
+    }
+    _BS_PICK(or)(bs->words, other->words, n);
+    return true;
+}
+
+/**
+ * Flip every bit of bs that is set in other, growing bs if other has a higher
+ * set bit
+ * @param bs     The bitset to modify
+ * @param other  The bitset to take the symmetric difference with
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool bitset_xor(bitset_t* bs, const bitset_t* other){
+    size_t n = _bs_wordsinuse(other);
+    if(!_bs_reservewords(bs, n)){
+        return false;
+    }
+    _BS_PICK(xor)(bs->words, other->words, n);
+    return true;
+}
+
+/**
+ * Clear every bit of bs that is set in other
+ * @param bs     The bitset to modify
+ * @param other  The bitset whose bits are removed from bs
+ */
+void bitset_andnot(bitset_t* bs, const bitset_t* other){
+    size_t n = bs->nwords < other->nwords ? bs->nwords : other->nwords;
+    _BS_PICK(andnot)(bs->words, other->words, n);
+}
@@ -0,0 +1,204 @@
+/*
+ c thread safe priority queue made of locked min heap shards
+*/
+#include <stdint.h>
+#include "concurrentpriorityqueue.h"
+
+// A MultiQueue with c shards per thread keeps lock collisions rare while the
+// expected rank error of poll stays O(c*threads)
+const size_t concurrentpriorityqueue_shards_per_thread = 2;
+
+static _Thread_local uint64_t _cpq_seed = 0;
+
+/**
+ * Returns a random index below n from a per-thread xorshift generator
+ */
+static size_t _cpq_rand(size_t n){
+    if(_cpq_seed == 0){
+        // Every thread has its own seed variable, so its address differs
+        _cpq_seed = (uint64_t) (uintptr_t) &_cpq_seed | 1;
+    }
+    _cpq_seed ^= _cpq_seed << 13;
+    _cpq_seed ^= _cpq_seed >> 7;
+    _cpq_seed ^= _cpq_seed << 17;
+    return (size_t) (_cpq_seed % n);
+}
+
+/**
+ * Poll the smaller minimum of two locked shards
+ * @return  The polled element, or NULL if both shards are empty
+ */
+static void* _cpq_pollpair(concurrentpriorityqueue_t* cpq, _cpqshard_t* a,
+                           _cpqshard_t* b){
+    void* top_a = priorityqueue_peek(&a->pq);
+    void* top_b = priorityqueue_peek(&b->pq);
+    if(top_a == NULL && top_b == NULL){
+        return NULL;
+    }
+    if(top_a == NULL || (top_b != NULL && a->pq.cmp(top_b, top_a) < 0)){
+        a = b;
+    }
+    atomic_fetch_sub_explicit(&cpq->length, 1, memory_order_relaxed);
+    return priorityqueue_poll(&a->pq);
+}
+
+/**
+ * Poll the first non-empty shard, locking each in turn
+ * <p>
+ * Used once random sampling keeps finding empty shards, so that poll only
+ * returns NULL after seeing every shard empty
+ * @return  The polled element, or NULL if every shard was empty
+ */
+static void* _cpq_pollscan(concurrentpriorityqueue_t* cpq){
+    size_t start = _cpq_rand(cpq->nshards);
+    size_t i;
+    for(i = 0; i < cpq->nshards; i++){
+        _cpqshard_t* shard = &cpq->shards[(start + i) % cpq->nshards];
+        pthread_mutex_lock(&shard->lock);
+        void* elem = priorityqueue_poll(&shard->pq);
+        pthread_mutex_unlock(&shard->lock);
+        if(elem != NULL){
+            atomic_fetch_sub_explicit(&cpq->length, 1, memory_order_relaxed);
+            return elem;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Initialize a concurrent priority queue
+ * @param cpq       The queue pointer to initialize
+ * @param cmp       The compare function for the queue. Must take pointers to
+ *                  queue elements and return an integer
+ * @param nthreads  The number of threads expected to use the queue at once
+ * @param strict    Whether poll must always return the minimum element. A
+ *                  strict queue is a single locked heap and does not scale
+ * @return  t/f depending on the successful allocation of the queue
+ */
+bool concurrentpriorityqueue_init(concurrentpriorityqueue_t* cpq,
+                                  int (*cmp)(const void*, const void*),
+                                  size_t nthreads, bool strict){
+    size_t nshards = 1;
+    if(!strict){
+        nshards = concurrentpriorityqueue_shards_per_thread*
+                  (nthreads > 0 ? nthreads : 1);
+    }
+    cpq->shards = (_cpqshard_t*) aligned_alloc(_Alignof(_cpqshard_t),
+                                               nshards*sizeof(_cpqshard_t));
+    if(cpq->shards == NULL){
+        return false;
+    }
+    size_t i;
+    for(i = 0; i < nshards; i++){
+        if(!priorityqueue_init(&cpq->shards[i].pq, cmp)){
+            cpq->nshards = i;
+            concurrentpriorityqueue_free(cpq);
+            return false;
+        }
+        pthread_mutex_init(&cpq->shards[i].lock, NULL);
+    }
+    cpq->nshards = nshards;
+    atomic_init(&cpq->length, 0);
+    return true;
+}
+
+/**
+ * Free the memory held by a concurrent priority queue
+ * <p>
+ * Must only be called once no other thread uses the queue
+ * @param cpq  The pointer to the queue whose memory should be released
+ */
+void concurrentpriorityqueue_free(concurrentpriorityqueue_t* cpq){
+    size_t i;
+    for(i = 0; i < cpq->nshards; i++){
+        pthread_mutex_destroy(&cpq->shards[i].lock);
+        priorityqueue_free(&cpq->shards[i].pq);
+    }
+    free(cpq->shards);
+    cpq->shards = NULL;
+}
+
+/**
+ * Add an element to the queue. Safe to call from any thread
+ * @param cpq   The queue to add to
+ * @param elem  The pointer to the element to add
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool concurrentpriorityqueue_add(concurrentpriorityqueue_t* cpq, void* elem){
+    _cpqshard_t* shard = &cpq->shards[0];
+    if(cpq->nshards == 1){
+        pthread_mutex_lock(&shard->lock);
+    }
+    else{
+        // Skip shards other threads hold instead of waiting for them
+        do{
+            shard = &cpq->shards[_cpq_rand(cpq->nshards)];
+        } while(pthread_mutex_trylock(&shard->lock) != 0);
+    }
+    bool success = priorityqueue_add(&shard->pq, elem);
+    if(success){
+        atomic_fetch_add_explicit(&cpq->length, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return success;
+}
+
+/**
+ * Remove a small element from the queue and return it. Safe to call from any
+ * thread
+ * <p>
+ * A strict queue returns the minimum element. A relaxed queue returns the
+ * smaller of the minimums of two random shards
+ * @param cpq  The queue to pop from
+ * @return  The polled element, or NULL if the queue was found empty
+ */
+void* concurrentpriorityqueue_poll(concurrentpriorityqueue_t* cpq){
+    if(cpq->nshards == 1){
+        _cpqshard_t* shard = &cpq->shards[0];
+        pthread_mutex_lock(&shard->lock);
+        void* elem = priorityqueue_poll(&shard->pq);
+        if(elem != NULL){
+            atomic_fetch_sub_explicit(&cpq->length, 1, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&shard->lock);
+        return elem;
+    }
+
+    size_t attempts = 0;
+    while(atomic_load_explicit(&cpq->length, memory_order_relaxed) > 0 &&
+          attempts < cpq->nshards){
+        size_t i = _cpq_rand(cpq->nshards);
+        size_t j = _cpq_rand(cpq->nshards - 1);
+        j += j >= i;
+        _cpqshard_t* a = &cpq->shards[i];
+        _cpqshard_t* b = &cpq->shards[j];
+        if(pthread_mutex_trylock(&a->lock) != 0){
+            continue;
+        }
+        if(pthread_mutex_trylock(&b->lock) != 0){
+            pthread_mutex_unlock(&a->lock);
+            continue;
+        }
+        void* elem = _cpq_pollpair(cpq, a, b);
+        pthread_mutex_unlock(&b->lock);
+        pthread_mutex_unlock(&a->lock);
+        if(elem != NULL){
+            return elem;
+        }
+        attempts++;
+    }
+    if(atomic_load_explicit(&cpq->length, memory_order_relaxed) == 0){
+        return NULL;
+    }
+    return _cpq_pollscan(cpq);
+}
+
+/**
+ * Returns the number of elements in the queue. Only a snapshot while other
+ * threads modify the queue
+ * @param cpq  The queue
+ * @return  The number of elements in the queue
+ */
+size_t concurrentpriorityqueue_size(const concurrentpriorityqueue_t* cpq){
+    return atomic_load_explicit(&cpq->length, memory_order_relaxed);
+}
@@ -0,0 +1,358 @@
+/*
+ c bounded lock free single and multi producer/consumer queue structures
+*/
+#include <string.h>
+#include "concurrentqueue.h"
+
+/**
+ * Returns the number of slots for a requested capacity, the next power of 2
+ * that is at least 2
+ */
+static size_t _cq_slots(size_t capacity){
+    size_t slots = 2;
+    while(slots < capacity){
+        slots *= 2;
+    }
+    return slots;
+}
+
+/**
+ * Initialize an empty single producer, single consumer queue
+ * @param q         The pointer to initialize as an spscqueue
+ * @param capacity  The number of elements the queue must hold, rounded up to
+ *                  a power of 2
+ * @return  t/f depending on the successful allocation of the ring
+ */
+bool spscqueue_init(spscqueue_t* q, size_t capacity){
+    size_t slots = _cq_slots(capacity);
+    q->data = (void**) malloc(slots*sizeof(void*));
+    q->mask = slots - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->tailcache = 0;
+    q->headcache = 0;
+    return q->data != NULL;
+}
+
+/**
+ * Free the memory held by a queue. The elements still in it are not freed
+ * <p>
+ * Must only be called once neither thread uses the queue
+ * @param q  The queue to free
+ */
+void spscqueue_free(spscqueue_t* q){
+    free(q->data);
+    q->data = NULL;
+}
+
+/**
+ * Add an element to the back of the queue. Only the producer thread may call
+ * this
+ * @param q     The queue to add to
+ * @param elem  The element to add, not NULL
+ * @return  t/f depending on the queue having room for the element
+ */
+bool spscqueue_offer(spscqueue_t* q, void* elem){
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if(tail - q->headcache > q->mask){
+        q->headcache = atomic_load_explicit(&q->head, memory_order_acquire);
+        if(tail - q->headcache > q->mask){
+            return false;
+        }
+    }
+    q->data[tail & q->mask] = elem;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Add as many elements of an array as fit to the back of the queue, with at
+ * most two memcpys and one release of the tail. Only the producer thread may
+ * call this
+ * @param q    The queue to add to
+ * @param ary  The array of elements to add, none NULL
+ * @param len  The length of the array
+ * @return  The number of elements added from the front of the array
+ */
+size_t spscqueue_offerall(spscqueue_t* q, void** ary, const size_t len){
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t room = q->mask + 1 - (tail - q->headcache);
+    if(room < len){
+        q->headcache = atomic_load_explicit(&q->head, memory_order_acquire);
+        room = q->mask + 1 - (tail - q->headcache);
+    }
+    size_t n = len < room ? len : room;
+    size_t start = tail & q->mask;
+    size_t first = q->mask + 1 - start < n ? q->mask + 1 - start : n;
+    memcpy(q->data + start, ary, first*sizeof(void*));
+    memcpy(q->data, ary + first, (n - first)*sizeof(void*));
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+/**
+ * Remove and return the element at the front of the queue. Only the consumer
+ * thread may call this
+ * @param q  The queue to remove from
+ * @return  The first element, or NULL if the queue is empty
+ */
+void* spscqueue_poll(spscqueue_t* q){
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if(head == q->tailcache){
+        q->tailcache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if(head == q->tailcache){
+            return NULL;
+        }
+    }
+    void* elem = q->data[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return elem;
+}
+
+/**
+ * Remove up to max elements from the front of the queue into an array, in
+ * order, with at most two memcpys and one release of the head. Only the
+ * consumer thread may call this
+ * @param q    The queue to remove from
+ * @param ary  The array to copy the removed elements to
+ * @param max  The most elements to remove, at most the length of ary
+ * @return  The number of elements removed
+ */
+size_t spscqueue_drainto(spscqueue_t* q, void** ary, const size_t max){
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if(q->tailcache - head < max){
+        q->tailcache = atomic_load_explicit(&q->tail, memory_order_acquire);
+    }
+    size_t n = q->tailcache - head < max ? q->tailcache - head : max;
+    size_t start = head & q->mask;
+    size_t first = q->mask + 1 - start < n ? q->mask + 1 - start : n;
+    memcpy(ary, q->data + start, first*sizeof(void*));
+    memcpy(ary + first, q->data, (n - first)*sizeof(void*));
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
+
+/**
+ * Returns the number of elements in the queue. The count may already be out
+ * of date when another thread is using the queue
+ * @param q  The queue
+ * @return  The number of elements in the queue
+ */
+size_t spscqueue_size(const spscqueue_t* q){
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return tail - head > q->mask + 1 ? q->mask + 1 : tail - head;
+}
+
+/**
+ * Returns the number of elements the queue can hold
+ * @param q  The queue
+ * @return  The capacity of the queue
+ */
+size_t spscqueue_capacity(const spscqueue_t* q){
+    return q->mask + 1;
+}
+
+/**
+ * Returns the sequence number of the cell for a position
+ */
+static inline size_t _mpmc_seq(const mpmcqueue_t* q, size_t pos){
+    return atomic_load_explicit(&q->cells[pos & q->mask].seq,
+                                memory_order_acquire);
+}
+
+/**
+ * Initialize an empty multi producer, multi consumer queue
+ * @param q         The pointer to initialize as an mpmcqueue
+ * @param capacity  The number of elements the queue must hold, rounded up to
+ *                  a power of 2
+ * @return  t/f depending on the successful allocation of the ring
+ */
+bool mpmcqueue_init(mpmcqueue_t* q, size_t capacity){
+    size_t slots = _cq_slots(capacity);
+    q->cells = (_mpmccell_t*) malloc(slots*sizeof(_mpmccell_t));
+    q->mask = slots - 1;
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    if(q->cells == NULL){
+        return false;
+    }
+    size_t i;
+    for(i = 0; i < slots; i++){
+        atomic_init(&q->cells[i].seq, i);
+    }
+    return true;
+}
+
+/**
+ * Free the memory held by a queue. The elements still in it are not freed
+ * <p>
+ * Must only be called once no other thread uses the queue
+ * @param q  The queue to free
+ */
+void mpmcqueue_free(mpmcqueue_t* q){
+    free(q->cells);
+    q->cells = NULL;
+}
+
+/**
+ * Add an element to the back of the queue. Safe to call from any thread
+ * @param q     The queue to add to
+ * @param elem  The element to add, not NULL
+ * @return  t/f depending on the queue having room for the element
+ */
+bool mpmcqueue_offer(mpmcqueue_t* q, void* elem){
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    _mpmccell_t* cell;
+    for(;;){
+        cell = &q->cells[pos & q->mask];
+        ptrdiff_t diff = (ptrdiff_t) (_mpmc_seq(q, pos) - pos);
+        if(diff == 0){
+            if(atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                   memory_order_relaxed, memory_order_relaxed)){
+                break;
+            }
+        }
+        else if(diff < 0){
+            // The cell still holds the element from one lap ago
+            return false;
+        }
+        else{
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    cell->data = elem;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Add as many elements of an array as fit to the back of the queue, claiming
+ * their positions with a single compare and swap. Safe to call from any
+ * thread
+ * <p>
+ * The added elements are contiguous in the queue, so no other producer's
+ * elements are interleaved with them
+ * @param q    The queue to add to
+ * @param ary  The array of elements to add, none NULL
+ * @param len  The length of the array
+ * @return  The number of elements added from the front of the array
+ */
+size_t mpmcqueue_offerall(mpmcqueue_t* q, void** ary, const size_t len){
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t n, i;
+    for(;;){
+        // A cell's sequence cannot move past pos + i until its position is
+        // claimed, so the cells counted here stay writable until the swap
+        n = 0;
+        while(n < len && _mpmc_seq(q, pos + n) == pos + n){
+            n++;
+        }
+        if(n == 0){
+            if(len == 0 || (ptrdiff_t) (_mpmc_seq(q, pos) - pos) < 0){
+                return 0;
+            }
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+        else if(atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + n,
+                    memory_order_relaxed, memory_order_relaxed)){
+            break;
+        }
+    }
+    for(i = 0; i < n; i++){
+        _mpmccell_t* cell = &q->cells[(pos + i) & q->mask];
+        cell->data = ary[i];
+        atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+    }
+    return n;
+}
+
+/**
+ * Remove and return the element at the front of the queue. Safe to call from
+ * any thread
+ * @param q  The queue to remove from
+ * @return  The first element, or NULL if the queue is empty
+ */
+void* mpmcqueue_poll(mpmcqueue_t* q){
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    _mpmccell_t* cell;
+    for(;;){
+        cell = &q->cells[pos & q->mask];
+        ptrdiff_t diff = (ptrdiff_t) (_mpmc_seq(q, pos) - (pos + 1));
+        if(diff == 0){
+            if(atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                   memory_order_relaxed, memory_order_relaxed)){
+                break;
+            }
+        }
+        else if(diff < 0){
+            // No element has been written for this position yet
+            return NULL;
+        }
+        else{
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    void* elem = cell->data;
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return elem;
+}
+
+/**
+ * Remove up to max elements from the front of the queue into an array, in
+ * order, claiming their positions with a single compare and swap. Safe to call
+ * from any thread
+ * @param q    The queue to remove from
+ * @param ary  The array to copy the removed elements to
+ * @param max  The most elements to remove, at most the length of ary
+ * @return  The number of elements removed
+ */
+size_t mpmcqueue_drainto(mpmcqueue_t* q, void** ary, const size_t max){
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t n, i;
+    for(;;){
+        n = 0;
+        while(n < max && _mpmc_seq(q, pos + n) == pos + n + 1){
+            n++;
+        }
+        if(n == 0){
+            if(max == 0 || (ptrdiff_t) (_mpmc_seq(q, pos) - (pos + 1)) < 0){
+                return 0;
+            }
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+        else if(atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + n,
+                    memory_order_relaxed, memory_order_relaxed)){
+            break;
+        }
+    }
+    for(i = 0; i < n; i++){
+        _mpmccell_t* cell = &q->cells[(pos + i) & q->mask];
+        ary[i] = cell->data;
+        atomic_store_explicit(&cell->seq, pos + i + q->mask + 1,
+                              memory_order_release);
+    }
+    return n;
+}
+
+/**
+ * Returns the number of elements in the queue. The count may already be out
+ * of date when other threads are using the queue, and includes elements whose
+ * positions are claimed but not yet written or read
+ * @param q  The queue
+ * @return  The number of elements in the queue
+ */
+size_t mpmcqueue_size(const mpmcqueue_t* q){
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    return tail - head > q->mask + 1 ? q->mask + 1 : tail - head;
+}
+
+/**
+ * Returns the number of elements the queue can hold
+ * @param q  The queue
+ * @return  The capacity of the queue
+ */
+size_t mpmcqueue_capacity(const mpmcqueue_t* q){
+    return q->mask + 1;
+}
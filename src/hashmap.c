@@ -0,0 +1,325 @@
+/*
+ c open addressing hash map structure
+*/
+#include <string.h>
+#include "hashmap.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define _HM_SSE2
+#endif
+
+const size_t hashmap_initsize = 16;
+const size_t hashmap_resize_factor = 2;
+
+#define _HM_NOSLOT ((size_t) -1)
+
+/**
+ * Returns the hash of a key with its bits mixed, so that the group index from
+ * the high bits and the control byte from the low bits are both well spread
+ * even for weak user hashes such as the identity
+ */
+static inline size_t _hm_hash(const hashmap_t* map, const void* key){
+    uint64_t h = (uint64_t) map->hash(key)*0x9E3779B97F4A7C15ull;
+    return (size_t) (h ^ (h >> 32));
+}
+
+/**
+ * Returns the most entries a map of the given capacity holds, 7/8 of its slots
+ */
+static inline size_t _hm_maxload(size_t capacity){
+    return capacity - capacity/8;
+}
+
+#ifdef _HM_SSE2
+/**
+ * Returns a bit for every slot of a group whose control byte equals c
+ */
+static inline uint32_t _hm_match(const int8_t* group, int8_t c){
+    __m128i ctrl = _mm_load_si128((const __m128i*) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+}
+
+/**
+ * Returns a bit for every empty or deleted slot of a group
+ */
+static inline uint32_t _hm_matchfree(const int8_t* group){
+    return (uint32_t) _mm_movemask_epi8(
+        _mm_load_si128((const __m128i*) group));
+}
+#else
+/**
+ * Gathers the top bit of every byte of a word into the low byte
+ */
+static inline uint32_t _hm_compress(uint64_t m){
+    return (uint32_t) (((m >> 7)*0x0102040810204080ull) >> 56);
+}
+
+/**
+ * Returns a bit for every slot of a group whose control byte equals c,
+ * comparing a word of control bytes at a time. Assumes a little endian cpu
+ */
+static inline uint32_t _hm_match(const int8_t* group, int8_t c){
+    const uint64_t lo7 = 0x7F7F7F7F7F7F7F7Full;
+    uint64_t pattern = 0x0101010101010101ull*(uint8_t) c;
+    uint32_t mask = 0;
+    uint64_t w[2];
+    memcpy(w, group, sizeof(w));
+    size_t i;
+    for(i = 0; i < 2; i++){
+        uint64_t x = w[i] ^ pattern;
+        // The top bit of a byte is set exactly when the byte of x is 0
+        uint64_t zero = ~(((x & lo7) + lo7) | x | lo7);
+        mask |= _hm_compress(zero) << 8*i;
+    }
+    return mask;
+}
+
+/**
+ * Returns a bit for every empty or deleted slot of a group
+ */
+static inline uint32_t _hm_matchfree(const int8_t* group){
+    uint64_t w[2];
+    memcpy(w, group, sizeof(w));
+    return _hm_compress(w[0] & 0x8080808080808080ull) |
+           _hm_compress(w[1] & 0x8080808080808080ull) << 8;
+}
+#endif
+
+/**
+ * Returns the slot holding key, or _HM_NOSLOT if the map does not contain it
+ * <p>
+ * Groups are probed in triangular order, which visits every group of a power
+ * of 2 table. The search stops at the first group with an empty slot, since
+ * an insert would have used that slot before moving on
+ */
+static size_t _hm_find(const hashmap_t* map, const void* key, size_t h){
+    size_t mask = map->capacity/_HM_GROUP - 1;
+    size_t g = (h >> 7) & mask;
+    int8_t h2 = (int8_t) (h & 0x7F);
+    size_t step = 0;
+    for(;;){
+        const int8_t* group = map->ctrl + g*_HM_GROUP;
+        uint32_t m = _hm_match(group, h2);
+        while(m != 0){
+            size_t slot = g*_HM_GROUP + (size_t) __builtin_ctz(m);
+            if(map->cmp(key, map->entries[slot].key) == 0){
+                return slot;
+            }
+            m &= m - 1;
+        }
+        if(_hm_match(group, _HM_EMPTY) != 0){
+            return _HM_NOSLOT;
+        }
+        step++;
+        g = (g + step) & mask;
+    }
+}
+
+/**
+ * Returns the first empty or deleted slot in the probe sequence of a hash
+ */
+static size_t _hm_findfree(const hashmap_t* map, size_t h){
+    size_t mask = map->capacity/_HM_GROUP - 1;
+    size_t g = (h >> 7) & mask;
+    size_t step = 0;
+    for(;;){
+        uint32_t m = _hm_matchfree(map->ctrl + g*_HM_GROUP);
+        if(m != 0){
+            return g*_HM_GROUP + (size_t) __builtin_ctz(m);
+        }
+        step++;
+        g = (g + step) & mask;
+    }
+}
+
+/**
+ * Move the entries of the map into new arrays with the given capacity,
+ * dropping the deleted slots. Keys are not compared, since they are known to
+ * be distinct
+ */
+static bool _hm_rehash(hashmap_t* map, size_t capacity){
+    int8_t* ctrl = (int8_t*) aligned_alloc(_HM_GROUP, capacity);
+    _hmentry_t* entries = (_hmentry_t*) malloc(capacity*sizeof(_hmentry_t));
+    if(ctrl == NULL || entries == NULL){
+        free(ctrl);
+        free(entries);
+        return false;
+    }
+    memset(ctrl, _HM_EMPTY, capacity);
+    hashmap_t old = *map;
+    map->ctrl = ctrl;
+    map->entries = entries;
+    map->capacity = capacity;
+    size_t i;
+    for(i = 0; i < old.capacity; i++){
+        if(old.ctrl[i] >= 0){
+            size_t h = _hm_hash(map, old.entries[i].key);
+            size_t slot = _hm_findfree(map, h);
+            ctrl[slot] = (int8_t) (h & 0x7F);
+            entries[slot] = old.entries[i];
+        }
+    }
+    map->growthleft = _hm_maxload(capacity) - map->size;
+    free(old.ctrl);
+    free(old.entries);
+    return true;
+}
+
+/**
+ * Initialize an empty hash map with room for 14 keys
+ * @param map   The pointer to initialize as a hashmap
+ * @param hash  The hash function for keys. Equal keys must have equal hashes
+ * @param cmp   The compare function for keys, returning 0 for equal keys
+ * @return  t/f depending on the successful allocation of the map
+ */
+bool hashmap_init(hashmap_t* map, size_t (*hash)(const void*),
+                  int (*cmp)(const void*, const void*)){
+    map->ctrl = NULL;
+    map->entries = NULL;
+    map->capacity = 0;
+    map->size = 0;
+    map->hash = hash;
+    map->cmp = cmp;
+    return _hm_rehash(map, hashmap_initsize);
+}
+
+/**
+ * Free the memory held by a hash map. The keys and values are not freed
+ * <p>
+ * This function should be called when the map is no longer needed and before
+ * freeing the pointer itself
+ * @param map  The map to free
+ */
+void hashmap_free(hashmap_t* map){
+    free(map->ctrl);
+    free(map->entries);
+    map->ctrl = NULL;
+    map->entries = NULL;
+    map->capacity = 0;
+    map->size = 0;
+    map->growthleft = 0;
+}
+
+/**
+ * Ensure that the map can hold the specified number of keys without growing
+ * <p>
+ * The map is only resized by factors of 2 and keeps at least 1/8 of its slots
+ * empty, so the capacity will be the next power of 2 with enough room
+ * @param map   The map to allocate memory for
+ * @param size  The number of keys to make room for
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool hashmap_reserve(hashmap_t* map, size_t size){
+    if(_hm_maxload(map->capacity) >= size){
+        return true;
+    }
+    size_t capacity = map->capacity;
+    while(_hm_maxload(capacity) < size){
+        capacity *= hashmap_resize_factor;
+    }
+    return _hm_rehash(map, capacity);
+}
+
+/**
+ * Associate a value with a key, replacing the value of an equal key already in
+ * the map
+ * <p>
+ * A replaced key keeps the pointer it was first added with
+ * @param map    The map to add to
+ * @param key    The pointer to the key
+ * @param value  The pointer to the value
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool hashmap_put(hashmap_t* map, void* key, void* value){
+    size_t h = _hm_hash(map, key);
+    size_t slot = _hm_find(map, key, h);
+    if(slot != _HM_NOSLOT){
+        map->entries[slot].value = value;
+        return true;
+    }
+    slot = _hm_findfree(map, h);
+    if(map->ctrl[slot] == _HM_EMPTY && map->growthleft == 0){
+        // Rehashing in place is enough when deleted slots are using the room
+        size_t capacity = map->capacity;
+        if(map->size >= _hm_maxload(capacity)/2){
+            capacity *= hashmap_resize_factor;
+        }
+        if(!_hm_rehash(map, capacity)){
+            return false;
+        }
+        slot = _hm_findfree(map, h);
+    }
+    map->growthleft -= map->ctrl[slot] == _HM_EMPTY;
+    map->ctrl[slot] = (int8_t) (h & 0x7F);
+    map->entries[slot].key = key;
+    map->entries[slot].value = value;
+    map->size++;
+    return true;
+}
+
+/**
+ * Remove a key from the map
+ * @param map  The map to remove from
+ * @param key  The key to remove
+ * @return  The value the key was associated with, or NULL if it was not found
+ */
+void* hashmap_remove(hashmap_t* map, const void* key){
+    size_t slot = _hm_find(map, key, _hm_hash(map, key));
+    if(slot == _HM_NOSLOT){
+        return NULL;
+    }
+    // No probe passed a group with an empty slot, so the slot can become empty
+    // again instead of leaving a tombstone
+    const int8_t* group = map->ctrl + slot/_HM_GROUP*_HM_GROUP;
+    if(_hm_match(group, _HM_EMPTY) != 0){
+        map->ctrl[slot] = _HM_EMPTY;
+        map->growthleft++;
+    }
+    else{
+        map->ctrl[slot] = _HM_DELETED;
+    }
+    map->size--;
+    return map->entries[slot].value;
+}
+
+/**
+ * Delete all keys from the map. Does not release any memory
+ * @param map  The map to clear
+ */
+void hashmap_clear(hashmap_t* map){
+    memset(map->ctrl, _HM_EMPTY, map->capacity);
+    map->size = 0;
+    map->growthleft = _hm_maxload(map->capacity);
+}
+
+/**
+ * Returns the value associated with a key
+ * @param map  The map to look in
+ * @param key  The key to look for
+ * @return  The value of the key, or NULL if the map does not contain it
+ */
+void* hashmap_get(const hashmap_t* map, const void* key){
+    size_t slot = _hm_find(map, key, _hm_hash(map, key));
+    return slot != _HM_NOSLOT ? map->entries[slot].value : NULL;
+}
+
+/**
+ * Returns whether the map contains a key, which distinguishes keys with a NULL
+ * value from missing keys
+ * @param map  The map to look in
+ * @param key  The key to look for
+ * @return  t/f depending on the key being in the map
+ */
+bool hashmap_containskey(const hashmap_t* map, const void* key){
+    return _hm_find(map, key, _hm_hash(map, key)) != _HM_NOSLOT;
+}
+
+/**
+ * Returns the number of keys in the map
+ * @param map  The map
+ * @return  The number of keys in the map
+ */
+size_t hashmap_size(const hashmap_t* map){
+    return map->size;
+}
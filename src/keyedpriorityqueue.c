@@ -0,0 +1,327 @@
+/*
+ c priority queue of elements with inline numeric keys, based on an 8-ary
+ min heap
+*/
+#include "keyedpriorityqueue.h"
+#include "priorityqueue.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define _KPQ_X86
+#endif
+
+// 8 keys fill one cache line, so a sift down step reads exactly one line of
+// keys and the minimum of a full child group is found with two AVX2 loads
+#define _KPQ_ARITY 8
+
+const size_t keyedpriorityqueue_init_size = 16;
+const size_t keyedpriorityqueue_resize_factor = 2;
+const size_t keyedpriorityqueue_cacheline = 64;
+
+/**
+ * Allocate a cache line aligned array of size elements of elemsize bytes behind
+ * _KPQ_ARITY - 1 unused elements, so every child group starts on a cache line
+ * @return  A pointer to the first heap slot, or NULL if allocation failed
+ */
+static void* _kpq_alloc(size_t elemsize, size_t size){
+    size_t bytes = (_KPQ_ARITY - 1 + size)*elemsize;
+    bytes += keyedpriorityqueue_cacheline - 1;
+    bytes -= bytes % keyedpriorityqueue_cacheline;
+    char* base = (char*) aligned_alloc(keyedpriorityqueue_cacheline, bytes);
+    return base != NULL ? base + (_KPQ_ARITY - 1)*elemsize : NULL;
+}
+
+/**
+ * Release an array allocated by _kpq_alloc
+ */
+static void _kpq_dealloc(void* ary, size_t elemsize){
+    if(ary){
+        free((char*) ary - (_KPQ_ARITY - 1)*elemsize);
+    }
+}
+
+/**
+ * Returns the index within a full group of _KPQ_ARITY keys of the minimum key
+ */
+static inline size_t _kpq_minchild_scalar(const uint64_t* keys){
+    size_t min_ind = 0;
+    size_t i;
+    for(i = 1; i < _KPQ_ARITY; i++){
+        min_ind = keys[i] < keys[min_ind] ? i : min_ind;
+    }
+    return min_ind;
+}
+
+#ifdef _KPQ_X86
+/**
+ * Returns the index within a full, cache line aligned group of _KPQ_ARITY keys
+ * of the minimum key
+ * <p>
+ * AVX2 only has a signed 64 bit compare, so the sign bits are flipped first.
+ * The minimum is reduced across lanes and then located with a compare mask
+ */
+__attribute__((target("avx2")))
+static inline size_t _kpq_minchild_avx2(const uint64_t* keys){
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    __m256i a = _mm256_xor_si256(_mm256_load_si256((const __m256i*) keys),
+                                 sign);
+    __m256i b = _mm256_xor_si256(_mm256_load_si256((const __m256i*) (keys + 4)),
+                                 sign);
+    __m256i m = _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    __m256i s = _mm256_permute4x64_epi64(m, _MM_SHUFFLE(1, 0, 3, 2));
+    m = _mm256_blendv_epi8(m, s, _mm256_cmpgt_epi64(m, s));
+    s = _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2));
+    m = _mm256_blendv_epi8(m, s, _mm256_cmpgt_epi64(m, s));
+    unsigned mask = (unsigned) _mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(a, m)));
+    mask |= (unsigned) _mm256_movemask_pd(
+        _mm256_castsi256_pd(_mm256_cmpeq_epi64(b, m))) << 4;
+    return (size_t) __builtin_ctz(mask);
+}
+#endif
+
+/**
+ * Move the element at ind down the heap until none of its children are smaller
+ * <p>
+ * Always inlined into the scalar and AVX2 versions below so that minchild is
+ * inlined as well
+ * @param kpq       The queue to fix
+ * @param ind       The index of the element that may be larger than its
+ *                  children
+ * @param minchild  Finds the minimum of a full group of child keys
+ */
+static inline __attribute__((always_inline))
+void _kpq_siftdown_body(keyedpriorityqueue_t* kpq, size_t ind,
+                        size_t (*minchild)(const uint64_t*)){
+    uint64_t key = kpq->keys[ind];
+    void* elem = kpq->data[ind];
+    size_t child = _PQ_CHILD(ind, _KPQ_ARITY);
+    while(child < kpq->length){
+        size_t min_ind;
+        if(child + _KPQ_ARITY <= kpq->length){
+            min_ind = child + minchild(&kpq->keys[child]);
+        }
+        else{
+            size_t i;
+            min_ind = child;
+            for(i = child + 1; i < kpq->length; i++){
+                min_ind = kpq->keys[i] < kpq->keys[min_ind] ? i : min_ind;
+            }
+        }
+        if(kpq->keys[min_ind] < key){
+            kpq->keys[ind] = kpq->keys[min_ind];
+            kpq->data[ind] = kpq->data[min_ind];
+            ind = min_ind;
+            child = _PQ_CHILD(ind, _KPQ_ARITY);
+        }
+        else{
+            break;
+        }
+    }
+    kpq->keys[ind] = key;
+    kpq->data[ind] = elem;
+}
+
+static void _kpq_siftdown_scalar(keyedpriorityqueue_t* kpq, size_t ind){
+    _kpq_siftdown_body(kpq, ind, _kpq_minchild_scalar);
+}
+
+#ifdef _KPQ_X86
+__attribute__((target("avx2")))
+static void _kpq_siftdown_avx2(keyedpriorityqueue_t* kpq, size_t ind){
+    _kpq_siftdown_body(kpq, ind, _kpq_minchild_avx2);
+}
+#endif
+
+/**
+ * Sift down with the widest minimum search the cpu supports
+ */
+static void _kpq_siftdown(keyedpriorityqueue_t* kpq, size_t ind){
+#ifdef _KPQ_X86
+    if(__builtin_cpu_supports("avx2")){
+        _kpq_siftdown_avx2(kpq, ind);
+        return;
+    }
+#endif
+    _kpq_siftdown_scalar(kpq, ind);
+}
+
+/**
+ * Move the element at ind up the heap until its parent is not larger
+ * @param kpq  The queue to fix
+ * @param ind  The index of the element that may be smaller than its parent
+ */
+static void _kpq_siftup(keyedpriorityqueue_t* kpq, size_t ind){
+    uint64_t key = kpq->keys[ind];
+    void* elem = kpq->data[ind];
+    while(ind > 0){
+        size_t parent = _PQ_PARENT(ind, _KPQ_ARITY);
+        if(key < kpq->keys[parent]){
+            kpq->keys[ind] = kpq->keys[parent];
+            kpq->data[ind] = kpq->data[parent];
+            ind = parent;
+        }
+        else{
+            break;
+        }
+    }
+    kpq->keys[ind] = key;
+    kpq->data[ind] = elem;
+}
+
+/**
+ * Initialize a keyed priority queue
+ * @param kpq  The queue pointer to initialize
+ * @return  t/f depending on the successful allocation of the queue
+ */
+bool keyedpriorityqueue_init(keyedpriorityqueue_t* kpq){
+    kpq->keys = (uint64_t*) _kpq_alloc(sizeof(uint64_t),
+                                       keyedpriorityqueue_init_size);
+    kpq->data = (void**) _kpq_alloc(sizeof(void*),
+                                    keyedpriorityqueue_init_size);
+    kpq->length = 0;
+    kpq->size = keyedpriorityqueue_init_size;
+    if(kpq->keys == NULL || kpq->data == NULL){
+        keyedpriorityqueue_free(kpq);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Free the memory held by a keyed priority queue
+ * <p>
+ * This function should be called when the queue is no longer needed and before
+ * freeing the pointer itself
+ * @param kpq  The pointer to the queue whose memory should be released
+ */
+void keyedpriorityqueue_free(keyedpriorityqueue_t* kpq){
+    _kpq_dealloc(kpq->keys, sizeof(uint64_t));
+    _kpq_dealloc(kpq->data, sizeof(void*));
+    kpq->keys = NULL;
+    kpq->data = NULL;
+}
+
+/**
+ * Ensure that sufficient memory is allocated for the queue to hold the
+ * specified number of elements
+ * <p>
+ * The queue is only resized by factors of two
+ * @param kpq   The queue to allocate memory for
+ * @param size  The number of elements to ensure space is allocated for
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool keyedpriorityqueue_reserve(keyedpriorityqueue_t* kpq, size_t size){
+    if(kpq->size < size){
+        size_t newsize = kpq->size;
+        while(newsize < size){
+            newsize *= keyedpriorityqueue_resize_factor;
+        }
+        uint64_t* keys = (uint64_t*) _kpq_alloc(sizeof(uint64_t), newsize);
+        void** data = (void**) _kpq_alloc(sizeof(void*), newsize);
+        if(keys == NULL || data == NULL){
+            _kpq_dealloc(keys, sizeof(uint64_t));
+            _kpq_dealloc(data, sizeof(void*));
+            return false;
+        }
+        memcpy(keys, kpq->keys, kpq->length*sizeof(uint64_t));
+        memcpy(data, kpq->data, kpq->length*sizeof(void*));
+        keyedpriorityqueue_free(kpq);
+        kpq->keys = keys;
+        kpq->data = data;
+        kpq->size = newsize;
+    }
+    return true;
+}
+
+/**
+ * Add an element to the queue with the given priority
+ * @param kpq   The queue to add to
+ * @param key   The priority of the element, smaller keys are polled first
+ * @param elem  The pointer to the element to add
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool keyedpriorityqueue_add(keyedpriorityqueue_t* kpq, uint64_t key,
+                            void* elem){
+    bool success = keyedpriorityqueue_reserve(kpq, kpq->length + 1);
+    if(success){
+        kpq->keys[kpq->length] = key;
+        kpq->data[kpq->length] = elem;
+        kpq->length++;
+        _kpq_siftup(kpq, kpq->length - 1);
+    }
+    return success;
+}
+
+/**
+ * Delete all elements from the queue
+ * @param kpq  The queue to clear
+ */
+void keyedpriorityqueue_clear(keyedpriorityqueue_t* kpq){
+    kpq->length = 0;
+}
+
+/**
+ * Remove the element with the minimum key from the queue and return it
+ * @param kpq  The queue to pop from
+ * @param key  Set to the key of the removed element if not NULL
+ * @return  The pointer to the minimum element, or NULL if the queue is empty
+ */
+void* keyedpriorityqueue_poll(keyedpriorityqueue_t* kpq, uint64_t* key){
+    if(kpq->length == 0){
+        return NULL;
+    }
+    void* elem = kpq->data[0];
+    if(key){
+        *key = kpq->keys[0];
+    }
+
+    // Grab last element and shrink list
+    kpq->length--;
+    kpq->keys[0] = kpq->keys[kpq->length];
+    kpq->data[0] = kpq->data[kpq->length];
+    if(kpq->length > 0){
+        _kpq_siftdown(kpq, 0);
+    }
+    return elem;
+}
+
+/**
+ * Returns the number of elements in the heap
+ * @param kpq  The queue
+ * @return  The number of elements in the heap
+ */
+size_t keyedpriorityqueue_size(const keyedpriorityqueue_t* kpq){
+    return kpq->length;
+}
+
+/**
+ * Returns the element with the minimum key without removing it
+ * @param kpq  The queue to look in
+ * @param key  Set to the key of the minimum element if not NULL
+ * @return  The pointer to the minimum element, or NULL if the queue is empty
+ */
+void* keyedpriorityqueue_peek(const keyedpriorityqueue_t* kpq, uint64_t* key){
+    if(kpq->length == 0){
+        return NULL;
+    }
+    if(key){
+        *key = kpq->keys[0];
+    }
+    return kpq->data[0];
+}
+
+/**
+ * Verifies that a keyed heap is properly ordered
+ * @param kpq  The queue to be checked
+ * @return  t/f indicating if the heap condition is satisfied
+ */
+bool validate_keyedheap(const keyedpriorityqueue_t* kpq){
+    size_t i;
+    for(i = 1; i < kpq->length; i++){
+        if(kpq->keys[i] < kpq->keys[_PQ_PARENT(i, _KPQ_ARITY)]){
+            return false;
+        }
+    }
+    return true;
+}
@@ -1,174 +1,734 @@
 /*
  c linked list structure
 */
+#include <stdatomic.h>
 #include "linkedlist.h"
 
+const size_t linkedlist_pool_slabnodes = 1024;
+const size_t linkedlist_pool_cachebatch = 32;
+
+static atomic_ulong _llpool_nextid = 1;
+
+// Per thread cache of nodes from one threadsafe pool. Nodes move between the
+// cache and the pool in batches, so most allocs and frees take no lock
+typedef struct _lltlcache_t _lltlcache_t;
+struct _lltlcache_t{
+    linkedlist_pool_t* pool; // Pool the cached nodes belong to
+    unsigned long id;        // Id of that pool when the cache was filled
+    _llnode_t* nodes;        // Cached free nodes, linked through next
+    size_t count;            // # of nodes in the cache
+    size_t allocs;           // Allocs not yet added to the pool's counters
+    size_t frees;            // Frees not yet added to the pool's counters
+    size_t hits;             // Allocs that took no lock, not yet added
+};
+
+static _Thread_local _lltlcache_t _ll_tlcache = {NULL, 0, NULL, 0, 0, 0, 0};
+
+/**
+ * Take a node from the free list or the newest slab of a pool, allocating a new
+ * slab if both are exhausted. The caller must hold the lock of a threadsafe
+ * pool
+ */
+static _llnode_t* _llpool_take(linkedlist_pool_t* pool){
+    _llnode_t* node = pool->freelist;
+    if(node != NULL){
+        pool->freelist = node->next;
+        return node;
+    }
+    if(pool->bump == pool->bumpend){
+        size_t header = sizeof(void*);
+        char* slab = (char*) malloc(header +
+                                    linkedlist_pool_slabnodes*pool->nodesize);
+        if(slab == NULL){
+            return NULL;
+        }
+        *((void**) slab) = pool->slabs;
+        pool->slabs = slab;
+        pool->bump = slab + header;
+        pool->bumpend = pool->bump + linkedlist_pool_slabnodes*pool->nodesize;
+        pool->slabcount++;
+    }
+    node = (_llnode_t*) pool->bump;
+    pool->bump += pool->nodesize;
+    return node;
+}
+
+/**
+ * Give the nodes and counters in this thread's cache back to the pool they
+ * came from, which must still be live, and detach the cache from that pool
+ */
+static void _llpool_flush(_lltlcache_t* cache){
+    linkedlist_pool_t* pool = cache->pool;
+    pthread_mutex_lock(&pool->lock);
+    while(cache->nodes != NULL){
+        _llnode_t* node = cache->nodes;
+        cache->nodes = node->next;
+        node->next = pool->freelist;
+        pool->freelist = node;
+    }
+    pool->allocs += cache->allocs;
+    pool->frees += cache->frees;
+    pool->cachehits += cache->hits;
+    pthread_mutex_unlock(&pool->lock);
+    cache->pool = NULL;
+    cache->nodes = NULL;
+    cache->count = 0;
+    cache->allocs = 0;
+    cache->frees = 0;
+    cache->hits = 0;
+}
+
+/**
+ * Point this thread's cache at a pool, first flushing nodes cached for any
+ * other pool. A thread alternating between pools would otherwise strand a
+ * batch of nodes in the old pool on every switch
+ * <p>
+ * A cache still attached to another pool means that pool is live, since a
+ * pool is only freed after the threads using it flushed their caches, and
+ * freeing it detaches the cache of the freeing thread. The old pool is never
+ * read otherwise, as it may have been freed by another thread
+ */
+static _lltlcache_t* _llpool_cache(linkedlist_pool_t* pool){
+    _lltlcache_t* cache = &_ll_tlcache;
+    if(cache->pool != pool || cache->id != pool->id){
+        // A cache for an earlier pool at this address holds freed nodes
+        if(cache->pool != NULL && cache->pool != pool){
+            _llpool_flush(cache);
+        }
+        cache->pool = pool;
+        cache->id = pool->id;
+        cache->nodes = NULL;
+        cache->count = 0;
+        cache->allocs = 0;
+        cache->frees = 0;
+        cache->hits = 0;
+    }
+    return cache;
+}
+
+/**
+ * Allocate one node from a pool
+ */
+static _llnode_t* _llpool_alloc(linkedlist_pool_t* pool){
+    if(!pool->threadsafe){
+        _llnode_t* node = _llpool_take(pool);
+        pool->allocs += node != NULL;
+        return node;
+    }
+    _lltlcache_t* cache = _llpool_cache(pool);
+    if(cache->count > 0){
+        cache->hits++;
+    }
+    else{
+        pthread_mutex_lock(&pool->lock);
+        while(cache->count < linkedlist_pool_cachebatch){
+            _llnode_t* node = _llpool_take(pool);
+            if(node == NULL){
+                break;
+            }
+            node->next = cache->nodes;
+            cache->nodes = node;
+            cache->count++;
+        }
+        pool->allocs += cache->allocs;
+        pool->frees += cache->frees;
+        pool->cachehits += cache->hits;
+        cache->allocs = 0;
+        cache->frees = 0;
+        cache->hits = 0;
+        pthread_mutex_unlock(&pool->lock);
+        if(cache->count == 0){
+            return NULL;
+        }
+    }
+    _llnode_t* node = cache->nodes;
+    cache->nodes = node->next;
+    cache->count--;
+    cache->allocs++;
+    return node;
+}
+
+/**
+ * Give a chain of count nodes, linked through next from first to last, back to
+ * a pool in O(1)
+ */
+static void _llpool_release(linkedlist_pool_t* pool, _llnode_t* first,
+                            _llnode_t* last, size_t count){
+    if(pool->threadsafe){
+        pthread_mutex_lock(&pool->lock);
+    }
+    last->next = pool->freelist;
+    pool->freelist = first;
+    pool->frees += count;
+    if(pool->threadsafe){
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+/**
+ * Give one node back to a pool
+ */
+static void _llpool_dealloc(linkedlist_pool_t* pool, _llnode_t* node){
+    if(!pool->threadsafe){
+        node->next = pool->freelist;
+        pool->freelist = node;
+        pool->frees++;
+        return;
+    }
+    _lltlcache_t* cache = _llpool_cache(pool);
+    node->next = cache->nodes;
+    cache->nodes = node;
+    cache->count++;
+    cache->frees++;
+    if(cache->count >= 2*linkedlist_pool_cachebatch){
+        linkedlist_pool_flushcache(pool);
+    }
+}
+
+/**
+ * Initialize an empty node pool that can be shared by any number of lists
+ * <p>
+ * Nodes are carved from slabs of many nodes and recycled through a free list,
+ * so lists using the pool rarely call malloc or free. Nodes are sized for deque
+ * mode so that lists of both kinds can share the pool
+ * @param pool        The pool to initialize
+ * @param threadsafe  Whether lists in different threads will use the pool.
+ *                    Threadsafe pools keep a small cache of nodes per thread
+ * @return  t/f depending on the successful initialization of the pool lock
+ */
+bool linkedlist_pool_init(linkedlist_pool_t* pool, bool threadsafe){
+    pool->nodesize = sizeof(_lldnode_t);
+    pool->slabs = NULL;
+    pool->bump = NULL;
+    pool->bumpend = NULL;
+    pool->freelist = NULL;
+    pool->threadsafe = threadsafe;
+    pool->id = atomic_fetch_add(&_llpool_nextid, 1);
+    pool->allocs = 0;
+    pool->frees = 0;
+    pool->slabcount = 0;
+    pool->cachehits = 0;
+    return !threadsafe || pthread_mutex_init(&pool->lock, NULL) == 0;
+}
+
+/**
+ * Free every slab of a pool at once
+ * <p>
+ * Must only be called once no list uses the pool any more. Nodes still in lists
+ * using the pool are released with it. Other threads that used a threadsafe
+ * pool must have flushed their caches before it is freed
+ * @param pool  The pool to free
+ */
+void linkedlist_pool_free(linkedlist_pool_t* pool){
+    void* slab = pool->slabs;
+    while(slab != NULL){
+        void* next = *((void**) slab);
+        free(slab);
+        slab = next;
+    }
+    pool->slabs = NULL;
+    pool->bump = NULL;
+    pool->bumpend = NULL;
+    pool->freelist = NULL;
+    if(pool->threadsafe){
+        pthread_mutex_destroy(&pool->lock);
+    }
+    if(_ll_tlcache.pool == pool){
+        _ll_tlcache.pool = NULL;
+    }
+    // A later pool at the same address must not pick up stale caches
+    pool->id = 0;
+}
+
+/**
+ * Return the nodes cached by the calling thread to a threadsafe pool and
+ * publish its counters
+ * <p>
+ * Threads should call this before they exit or stop using a pool, otherwise up
+ * to two batches of nodes stay unused until the pool is freed. It must be
+ * called before another thread frees the pool. Switching to another pool
+ * flushes the cache automatically
+ * @param pool  The pool whose cache should be flushed
+ */
+void linkedlist_pool_flushcache(linkedlist_pool_t* pool){
+    _lltlcache_t* cache = &_ll_tlcache;
+    if(!pool->threadsafe || cache->pool != pool || cache->id != pool->id){
+        return;
+    }
+    _llpool_flush(cache);
+}
+
+/**
+ * Returns the fraction of node allocations that were served by the pool
+ * without calling malloc
+ * <p>
+ * Counters of threadsafe pools include other threads' cached allocations only
+ * once their caches are refilled or flushed
+ * @param pool  The pool
+ * @return  The hit rate between 0 and 1, or 0 if nothing was allocated
+ */
+double linkedlist_pool_hitrate(const linkedlist_pool_t* pool){
+    if(pool->allocs == 0){
+        return 0;
+    }
+    double misses = (double) pool->slabcount;
+    return misses >= pool->allocs ? 0 : 1 - misses/pool->allocs;
+}
+
+/**
+ * Allocate a node of the size used by the list
+ */
+static _llnode_t* _ll_newnode(linkedlist_t* lst, void* data){
+    _llnode_t* node;
+    if(lst->pool != NULL){
+        node = _llpool_alloc(lst->pool);
+    }
+    else{
+        size_t size = lst->deque ? sizeof(_lldnode_t) : sizeof(_llnode_t);
+        node = (_llnode_t*) allocator_alloc(lst->alloc, size, sizeof(void*));
+        _STATS_INC(lst, nodes, 1);
+        _STATS_INC(lst, bytes, size);
+    }
+    if(node != NULL){
+        node->data = data;
+    }
+    return node;
+}
+
 /**
- *
+ * Release a node allocated by _ll_newnode
+ */
+static void _ll_freenode(linkedlist_t* lst, _llnode_t* node){
+    if(lst->pool != NULL){
+        _llpool_dealloc(lst->pool, node);
+    }
+    else{
+        allocator_free(lst->alloc, node, lst->deque ? sizeof(_lldnode_t)
+                                                    : sizeof(_llnode_t));
+    }
+}
+
+/**
+ * Returns the back link of a node in a deque mode list
+ */
+static inline _llnode_t* _ll_prev(const _llnode_t* node){
+    return ((const _lldnode_t*) node)->prev;
+}
+
+/**
+ * Link a node into the list after prev, or at the front if prev is NULL
+ */
+static void _ll_link(linkedlist_t* lst, _llnode_t* prev, _llnode_t* node){
+    _llnode_t* next = prev != NULL ? prev->next : lst->start;
+    node->next = next;
+    if(prev != NULL){
+        prev->next = node;
+    }
+    else{
+        lst->start = node;
+    }
+    if(next == NULL){
+        lst->end = node;
+    }
+    if(lst->deque){
+        ((_lldnode_t*) node)->prev = prev;
+        if(next != NULL){
+            ((_lldnode_t*) next)->prev = node;
+        }
+    }
+    lst->length++;
+    lst->modcount++;
+    _STATS_MAX(lst, highwater, lst->length);
+}
+
+/**
+ * Unlink and release the node after prev, or the first node if prev is NULL
+ * @return  The data held by the removed node
+ */
+static void* _ll_unlink(linkedlist_t* lst, _llnode_t* prev){
+    _llnode_t* node = prev != NULL ? prev->next : lst->start;
+    _llnode_t* next = node->next;
+    if(prev != NULL){
+        prev->next = next;
+    }
+    else{
+        lst->start = next;
+    }
+    if(next == NULL){
+        lst->end = prev;
+    }
+    else if(lst->deque){
+        ((_lldnode_t*) next)->prev = prev;
+    }
+    lst->length--;
+    lst->modcount++;
+    void* data = node->data;
+    _ll_freenode(lst, node);
+    return data;
+}
+
+/**
+ * Returns the node at an index less than the length of the list
+ * <p>
+ * The last node is found in O(1), and deque mode lists walk back from the end
+ * for indices in the second half of the list
+ */
+static _llnode_t* _ll_node(const linkedlist_t* lst, size_t ind){
+    _llnode_t* current;
+    if(ind == lst->length - 1){
+        return lst->end;
+    }
+    if(lst->deque && ind > lst->length/2){
+        current = lst->end;
+        size_t i;
+        for(i = lst->length - 1; i > ind; i--){
+            current = _ll_prev(current);
+        }
+        _STATS_INC(lst, steps, lst->length - 1 - ind);
+        return current;
+    }
+    _STATS_INC(lst, steps, ind);
+    current = lst->start;
+    while(ind > 0){
+        current = current->next;
+        ind--;
+    }
+    return current;
+}
+
+/**
+ * Initialize an empty singly linked list
+ * @param lst  The pointer to intialize as a linkedlist
  */
 void linkedlist_init(linkedlist_t* lst){
     lst->length = 0;
     lst->start = NULL;
+    lst->end = NULL;
+    lst->deque = false;
+    lst->pool = NULL;
+    lst->ownpool = false;
+    lst->alloc = NULL;
+    lst->modcount = 0;
+    _STATS_RESET(lst);
 }
 
 /**
- *
+ * Initialize an empty doubly linked list
+ * <p>
+ * Nodes carry a back link, which makes polllast and removelast O(1) and lets
+ * positional access start from the nearer end of the list
+ * @param lst  The pointer to intialize as a linkedlist
  */
-void linkedlist_free(linkedlist_t* lst){
-    _llnode_t* current = lst->start;
-    _llnode_t* next;
-    while(current != NULL){
-        next = current->next;
-        free(current);
-        current = next;
+void linkedlist_init_deque(linkedlist_t* lst){
+    linkedlist_init(lst);
+    lst->deque = true;
+}
+
+/**
+ * Read the instrumentation counters of a list
+ * <p>
+ * The counters are only kept when the library is built with JAVAUTIL_STATS,
+ * otherwise they all read as 0. Nodes taken from a pool are not counted as
+ * mallocs, see linkedlist_pool_t for the pool's own counters
+ * @param lst    The linkedlist to read the counters of
+ * @param stats  Set to the counters accumulated since the list was initialized
+ *               or the counters were last reset
+ */
+void linkedlist_stats(const linkedlist_t* lst, javautil_stats_t* stats){
+    _STATS_READ(lst, stats);
+}
+
+/**
+ * Zero the instrumentation counters of a list. The high water mark restarts
+ * from the current length
+ * @param lst  The linkedlist to reset the counters of
+ */
+void linkedlist_resetstats(linkedlist_t* lst){
+    _STATS_RESET(lst);
+    _STATS_MAX(lst, highwater, lst->length);
+}
+
+/**
+ * Make an empty list allocate its nodes from a pool
+ * <p>
+ * With a NULL pool the list creates a private pool with nodes of its own size,
+ * which linkedlist_free releases in bulk without visiting the nodes
+ * @param lst   The empty linkedlist
+ * @param pool  The shared pool to use, or NULL for a private pool
+ * @return  t/f depending on the list being empty and the successful allocation
+ *          of a private pool
+ */
+bool linkedlist_setpool(linkedlist_t* lst, linkedlist_pool_t* pool){
+    if(lst->length != 0){
+        return false;
+    }
+    bool own = pool == NULL;
+    if(own){
+        pool = (linkedlist_pool_t*) malloc(sizeof(linkedlist_pool_t));
+        if(pool == NULL){
+            return false;
+        }
+        linkedlist_pool_init(pool, false);
+        pool->nodesize = lst->deque ? sizeof(_lldnode_t) : sizeof(_llnode_t);
     }
+    if(lst->ownpool){
+        linkedlist_pool_free(lst->pool);
+        free(lst->pool);
+    }
+    lst->pool = pool;
+    lst->ownpool = own;
+    lst->alloc = NULL;
+    return true;
 }
 
 /**
- *
+ * Make an empty list allocate its nodes from an allocator instead of malloc
+ * <p>
+ * Replaces any pool set with linkedlist_setpool. A list whose nodes come from
+ * an arena need not be freed, since resetting the arena releases them, and a
+ * poolallocator_t sized for the nodes recycles them without calling malloc
+ * @param lst    The empty linkedlist
+ * @param alloc  The allocator for nodes, or NULL for malloc
+ * @return  t/f depending on the list being empty
  */
-bool linkedlist_append(linkedlist_t* lst, void* data){
-    _llnode_t* node = (_llnode_t*) malloc(sizeof(_llnode_t));
-    if(node == NULL){
+bool linkedlist_setallocator(linkedlist_t* lst, allocator_t* alloc){
+    if(lst->length != 0){
         return false;
     }
-    node->next = NULL;
-    node->data = data;
+    if(lst->ownpool){
+        linkedlist_pool_free(lst->pool);
+        free(lst->pool);
+    }
+    lst->pool = NULL;
+    lst->ownpool = false;
+    lst->alloc = alloc;
+    return true;
+}
 
-    _llnode_t* n = lst->start;
-    if(n == NULL){
-        lst->start = node;
-        lst->length++;
-        return true;
+/**
+ * Frees the nodes of a linkedlist, leaving it empty
+ * <p>
+ * This function should be called when the linkedlist is no longer needed and
+ * before freeing the pointer itself. Nodes from a pool are released in bulk
+ * @param lst  The linkedlist to free
+ */
+void linkedlist_free(linkedlist_t* lst){
+    if(lst->ownpool){
+        linkedlist_pool_free(lst->pool);
+        free(lst->pool);
+        lst->pool = NULL;
+        lst->ownpool = false;
+    }
+    else if(lst->pool != NULL){
+        if(lst->start != NULL){
+            _llpool_release(lst->pool, lst->start, lst->end, lst->length);
+        }
     }
-    while(n->next != NULL){
-        n = n->next;
+    else{
+        _llnode_t* current = lst->start;
+        _llnode_t* next;
+        while(current != NULL){
+            next = current->next;
+            _ll_freenode(lst, current);
+            current = next;
+        }
     }
+    lst->length = 0;
+    lst->start = NULL;
+    lst->end = NULL;
+    lst->modcount++;
+}
 
-    n->next = node;
-    lst->length++;
-    return true;
+/**
+ * Append the given item to the end of the list in O(1)
+ * @param lst   The linkedlist to append to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of a node
+ */
+bool linkedlist_append(linkedlist_t* lst, void* data){
+    return linkedlist_addlast(lst, data);
 }
 
 /**
- *
+ * Add the given item to the list at the specified index
+ * @param lst   The linkedlist to add to
+ * @param ind   The index at which to add the data, at most the list length
+ * @param data  The data to add
+ * @return  t/f depending on the validity of the index and the successful
+ *          allocation of a node
  */
 bool linkedlist_add(linkedlist_t* lst, const size_t ind, void* data){
-    _llnode_t* node = (_llnode_t*) malloc(sizeof(_llnode_t));
+    if(ind > lst->length){
+        return false;
+    }
+    _llnode_t* node = _ll_newnode(lst, data);
     if(node == NULL){
         return false;
     }
-    node->next = NULL;
-    node->data = data;
+    _ll_link(lst, ind > 0 ? _ll_node(lst, ind - 1) : NULL, node);
+    return true;
+}
 
-    if(ind == 0){
-        _llnode_t* tmp = lst->start;
-        lst->start = node;
-        node->next = tmp;
-        lst->length++;
-        return true;
+/**
+ * Removes the data at the specified index from the list and returns the removed
+ * data pointer
+ * @param lst  The linkedlist to remove from
+ * @param ind  The index of the element to remove
+ * @return  The removed element, or NULL if the index is out of range
+ */
+void* linkedlist_remove(linkedlist_t* lst, const size_t ind){
+    if(ind >= lst->length){
+        return NULL;
     }
+    return _ll_unlink(lst, ind > 0 ? _ll_node(lst, ind - 1) : NULL);
+}
 
-    _llnode_t* n = lst->start;
-    if(n == NULL){
-        // List is empty, while loop condition will cause null pointer exception
+/**
+ * Insert the given item at the front of the list in O(1)
+ * @param lst   The linkedlist to add to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of a node
+ */
+bool linkedlist_addfirst(linkedlist_t* lst, void* data){
+    _llnode_t* node = _ll_newnode(lst, data);
+    if(node == NULL){
         return false;
     }
-    size_t i = 0;
-    while(i < ind-1 && n->next != NULL){
-        n = n->next;
-        i++;
-    }
+    _ll_link(lst, NULL, node);
+    return true;
+}
 
-    // Add the element if we reached the correct element without a null pointer
-    if(i == ind-1){
-        _llnode_t* tmp = n->next;
-        n->next = node;
-        node->next = tmp;
-        lst->length++;
-        return true;
+/**
+ * Insert the given item at the end of the list in O(1)
+ * @param lst   The linkedlist to add to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of a node
+ */
+bool linkedlist_addlast(linkedlist_t* lst, void* data){
+    _llnode_t* node = _ll_newnode(lst, data);
+    if(node == NULL){
+        return false;
     }
-    return false;
+    _ll_link(lst, lst->end, node);
+    return true;
 }
 
-void* linkedlist_remove(linkedlist_t* lst, const size_t ind){
-    _llnode_t* n = lst->start;
-    if(n == NULL){
-        // List is empty, while loop condition will cause null pointer exception
+/**
+ * Removes the first element of the list in O(1) and returns it
+ * @param lst  The linkedlist to remove from
+ * @return  The removed element, or NULL if the list is empty
+ */
+void* linkedlist_pollfirst(linkedlist_t* lst){
+    if(lst->length == 0){
         return NULL;
     }
+    return _ll_unlink(lst, NULL);
+}
 
-    if(ind == 0){
-        _llnode_t* tmp = lst->start;
-        void* data = tmp->data;
-        lst->start = tmp->next;
-        free(tmp);
-        tmp = NULL;
-        lst->length--;
-        return data;
+/**
+ * Removes the last element of the list and returns it
+ * <p>
+ * O(1) in deque mode. A singly linked list has to walk to the second to last
+ * node
+ * @param lst  The linkedlist to remove from
+ * @return  The removed element, or NULL if the list is empty
+ */
+void* linkedlist_polllast(linkedlist_t* lst){
+    if(lst->length == 0){
+        return NULL;
     }
-
-    size_t i = 0;
-    while(i < ind-1 && n != NULL){
-        n = n->next;
-        i++;
+    if(lst->deque){
+        return _ll_unlink(lst, _ll_prev(lst->end));
     }
+    return _ll_unlink(lst, lst->length > 1 ? _ll_node(lst, lst->length - 2)
+                                           : NULL);
+}
 
-    // Add the element if we reached the correct element without a null pointer
-    if(i == ind - 1){
-        _llnode_t* tmp = n->next;
-        void* data = tmp->data;
-        n->next = tmp->next;
-        free(tmp);
-        tmp = NULL;
-        lst->length--;
-        return data;
-    }
-    return NULL;
+/**
+ * Removes the first element of the list and returns it. Same as pollfirst
+ * @param lst  The linkedlist to remove from
+ * @return  The removed element, or NULL if the list is empty
+ */
+void* linkedlist_removefirst(linkedlist_t* lst){
+    return linkedlist_pollfirst(lst);
+}
+
+/**
+ * Removes the last element of the list and returns it. Same as polllast
+ * @param lst  The linkedlist to remove from
+ * @return  The removed element, or NULL if the list is empty
+ */
+void* linkedlist_removelast(linkedlist_t* lst){
+    return linkedlist_polllast(lst);
+}
+
+/**
+ * Returns the first element of the list without removing it
+ * @param lst  The linkedlist to look in
+ * @return  The first element, or NULL if the list is empty
+ */
+void* linkedlist_peekfirst(const linkedlist_t* lst){
+    return lst->start != NULL ? lst->start->data : NULL;
+}
+
+/**
+ * Returns the last element of the list without removing it
+ * @param lst  The linkedlist to look in
+ * @return  The last element, or NULL if the list is empty
+ */
+void* linkedlist_peeklast(const linkedlist_t* lst){
+    return lst->end != NULL ? lst->end->data : NULL;
 }
 
 /**
- *
+ * Returns the number of items in the linkedlist
+ * @param lst  The linkedlist
+ * @return  The length of the given linkedlist
  */
 size_t linkedlist_length(const linkedlist_t* lst){
     return lst->length;
 }
 
 /**
- *
+ * Copies the elements of the list into a newly allocated array, which the
+ * caller must free
+ * @param lst  The linkedlist
+ * @return  The array of elements in list order, or NULL if allocation failed
  */
 void** linkedlist_toarray(const linkedlist_t* lst){
     void** ary = (void**) malloc(lst->length*sizeof(void*));
+    if(ary == NULL){
+        return NULL;
+    }
     _llnode_t* current = lst->start;
     size_t i = 0;
     while(current != NULL){
         ary[i] = current->data;
+        current = current->next;
         i++;
     }
     return ary;
 }
 
 /**
- *
+ * Returns the item at the specified index of the linkedlist
+ * @param lst  The linkedlist to look in
+ * @param ind  The index of the element to get
+ * @return  The element at the specified index, or NULL if it is out of range
  */
 void* linkedlist_get(const linkedlist_t* lst, const size_t ind){
-    _llnode_t* current = lst->start;
-    size_t i = 0;
-    while(i < ind && current != NULL){
-        current = current->next;
-        i++;
-    }
-
-    if(i == ind){
-        return current->data;
+    if(ind >= lst->length){
+        return NULL;
     }
-    return NULL;
+    return _ll_node(lst, ind)->data;
 }
 
 /**
- *
+ * Searches the linkedlist for the specified item using the given comparator
+ * function to check for equality. Returns the index at which the item was found
+ * or -1 if it was not found
  */
-ptrdiff_t linkedlist_indexof(const linkedlist_t* lst, const void* data, 
+ptrdiff_t linkedlist_indexof(const linkedlist_t* lst, const void* data,
                        int (*cmp) (const void*, const void*)){
     size_t i = 0;
     _llnode_t* current = lst->start;
@@ -176,5 +736,182 @@ ptrdiff_t linkedlist_indexof(const linkedlist_t* lst, const void* data,
         current = current->next;
         i++;
     }
+    _STATS_INC(lst, cmps, current != NULL ? i + 1 : i);
+    _STATS_INC(lst, steps, i);
     return i < lst->length ? i : -1;
 }
+
+/**
+ * Initialize an iterator positioned before the first element of a list
+ * <p>
+ * Like java.util.ListIterator, the cursor sits between elements, and remove,
+ * add and set work at the cursor in O(1), so a traversal that edits the list
+ * as it goes is linear instead of quadratic with get and remove by index. The
+ * iterator is fail-fast: once the list is changed other than through the
+ * iterator, hasnext returns false and the other operations fail
+ * @param lst  The linkedlist to iterate over
+ * @param it   The pointer to initialize as an iterator
+ */
+void linkedlist_iterator(linkedlist_t* lst, linkedlist_iterator_t* it){
+    it->lst = lst;
+    it->prev = NULL;
+    it->prevprev = NULL;
+    it->returned = false;
+    it->index = 0;
+    it->modcount = lst->modcount;
+}
+
+/**
+ * Returns whether the list was changed only through this iterator since it
+ * was initialized
+ * @param it  The iterator
+ * @return  t/f depending on whether the iterator can still be used
+ */
+bool linkedlist_iterator_isvalid(const linkedlist_iterator_t* it){
+    return it->modcount == it->lst->modcount;
+}
+
+/**
+ * Returns whether there is an element after the cursor
+ * @param it  The iterator
+ * @return  t/f depending on whether next returns an element, false if the
+ *          list was changed other than through the iterator
+ */
+bool linkedlist_iterator_hasnext(const linkedlist_iterator_t* it){
+    if(!linkedlist_iterator_isvalid(it)){
+        return false;
+    }
+    return (it->prev != NULL ? it->prev->next : it->lst->start) != NULL;
+}
+
+/**
+ * Returns the element after the cursor and advances past it
+ * @param it  The iterator
+ * @return  The next element, or NULL if there is none or the list was
+ *          changed other than through the iterator
+ */
+void* linkedlist_iterator_next(linkedlist_iterator_t* it){
+    if(!linkedlist_iterator_hasnext(it)){
+        return NULL;
+    }
+    _llnode_t* node = it->prev != NULL ? it->prev->next : it->lst->start;
+    _STATS_INC(it->lst, steps, 1);
+    it->prevprev = it->prev;
+    it->prev = node;
+    it->returned = true;
+    it->index++;
+    return node->data;
+}
+
+/**
+ * Removes the element last returned by next from the list in O(1)
+ * <p>
+ * May be called once per call to next, and not after add
+ * @param it  The iterator
+ * @return  t/f depending on whether there was an element to remove and the
+ *          list was changed only through the iterator
+ */
+bool linkedlist_iterator_remove(linkedlist_iterator_t* it){
+    if(!it->returned || !linkedlist_iterator_isvalid(it)){
+        return false;
+    }
+    _ll_unlink(it->lst, it->prevprev);
+    it->prev = it->prevprev;
+    it->returned = false;
+    it->index--;
+    it->modcount = it->lst->modcount;
+    return true;
+}
+
+/**
+ * Inserts the given item into the list at the cursor in O(1)
+ * <p>
+ * The item goes before the element next would return, so next is unaffected
+ * and the item is not visited by this iterator
+ * @param it    The iterator
+ * @param data  The data to add
+ * @return  t/f depending on whether the list was changed only through the
+ *          iterator and the successful allocation of a node
+ */
+bool linkedlist_iterator_add(linkedlist_iterator_t* it, void* data){
+    if(!linkedlist_iterator_isvalid(it)){
+        return false;
+    }
+    _llnode_t* node = _ll_newnode(it->lst, data);
+    if(node == NULL){
+        return false;
+    }
+    _ll_link(it->lst, it->prev, node);
+    it->prevprev = it->prev;
+    it->prev = node;
+    it->returned = false;
+    it->index++;
+    it->modcount = it->lst->modcount;
+    return true;
+}
+
+/**
+ * Replaces the element last returned by next with the given item
+ * <p>
+ * Not allowed after remove or add, since there is no element to replace
+ * @param it    The iterator
+ * @param data  The data to store
+ * @return  t/f depending on whether there was an element to replace and the
+ *          list was changed only through the iterator
+ */
+bool linkedlist_iterator_set(linkedlist_iterator_t* it, void* data){
+    if(!it->returned || !linkedlist_iterator_isvalid(it)){
+        return false;
+    }
+    it->prev->data = data;
+    return true;
+}
+
+/**
+ * Returns the index of the element next would return
+ * @param it  The iterator
+ * @return  The index after the cursor, the list length once it is exhausted
+ */
+size_t linkedlist_iterator_nextindex(const linkedlist_iterator_t* it){
+    return it->index;
+}
+
+/**
+ * Calls the given function on each element of the list in order
+ * <p>
+ * The function must not add to or remove from the list; use an iterator or
+ * linkedlist_removeif for that
+ * @param lst  The linkedlist to traverse
+ * @param fn   The function to call with each element and arg
+ * @param arg  Passed through to every call of fn
+ */
+void linkedlist_foreach(const linkedlist_t* lst, void (*fn)(void*, void*),
+                        void* arg){
+    _llnode_t* current = lst->start;
+    while(current != NULL){
+        (*fn)(current->data, arg);
+        current = current->next;
+    }
+}
+
+/**
+ * Removes every element for which the given predicate holds in one pass
+ * @param lst   The linkedlist to remove from
+ * @param pred  Returns true for the elements to remove, given each element
+ *              and arg
+ * @param arg   Passed through to every call of pred
+ * @return  The number of elements removed
+ */
+size_t linkedlist_removeif(linkedlist_t* lst,
+                           bool (*pred)(const void*, void*), void* arg){
+    linkedlist_iterator_t it;
+    size_t removed = 0;
+    linkedlist_iterator(lst, &it);
+    while(linkedlist_iterator_hasnext(&it)){
+        if((*pred)(linkedlist_iterator_next(&it), arg)){
+            linkedlist_iterator_remove(&it);
+            removed++;
+        }
+    }
+    return removed;
+}
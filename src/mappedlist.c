@@ -0,0 +1,312 @@
+/*
+ c memory mapped list of fixed size records
+*/
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mappedlist.h"
+
+const size_t mappedlist_initsize = 64;
+const size_t mappedlist_resize_factor = 2;
+
+/**
+ * Map the first bytes of the backing file, replacing any previous mapping
+ */
+static bool _ml_map(mappedlist_t* ml, size_t bytes){
+    if(ml->header != NULL){
+        munmap(ml->header, sizeof(_mlheader_t) + ml->size*ml->recsize);
+        ml->header = NULL;
+    }
+    int prot = ml->readonly ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* map = mmap(NULL, bytes, prot, MAP_SHARED, ml->fd, 0);
+    if(map == MAP_FAILED){
+        return false;
+    }
+    ml->header = (_mlheader_t*) map;
+    ml->records = (char*) map + sizeof(_mlheader_t);
+    return true;
+}
+
+/**
+ * Returns the number of records a list can access, mapping more of the file
+ * first if a read only list is behind a writer that grew it
+ * <p>
+ * The writer grows the file before it publishes a longer length, so a reader
+ * that sees a length past its mapping finds a file large enough to map
+ */
+static size_t _ml_length(mappedlist_t* ml){
+    size_t length = (size_t) ml->header->length;
+    if(length <= ml->size){
+        return length;
+    }
+    struct stat st;
+    if(fstat(ml->fd, &st) == 0 &&
+       (size_t) st.st_size > sizeof(_mlheader_t) + ml->size*ml->recsize){
+        size_t size = ((size_t) st.st_size - sizeof(_mlheader_t))/ml->recsize;
+        if(_ml_map(ml, sizeof(_mlheader_t) + size*ml->recsize)){
+            ml->size = size;
+        }
+        else{
+            // Map the old records again so the list stays usable
+            _ml_map(ml, sizeof(_mlheader_t) + ml->size*ml->recsize);
+        }
+    }
+    return length < ml->size ? length : ml->size;
+}
+
+/**
+ * Open a list stored in a file, creating the file if it does not exist
+ * <p>
+ * An existing file is mapped as it is, so opening takes the same time however
+ * many records it holds and records are read from disk only when first
+ * touched. Read only lists can be opened by many processes at once, and all of
+ * them see the changes of a process that has the file open for writing,
+ * mapping more of the file when the writer grows it
+ * @param ml        The list to open
+ * @param path      The path of the backing file
+ * @param recsize   The bytes per record. Must match the file if it exists, or
+ *                  be 0 to take the size from an existing file
+ * @param readonly  Whether to open an existing file without write access
+ * @return  t/f depending on the file being opened and mapped, and an existing
+ *          file being a list of records of the given size
+ */
+bool mappedlist_open(mappedlist_t* ml, const char* path, size_t recsize,
+                     bool readonly){
+    ml->fd = open(path, readonly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+    if(ml->fd < 0){
+        return false;
+    }
+    ml->header = NULL;
+    ml->readonly = readonly;
+    // Every list holding the file takes a shared lock, so close can tell
+    // whether it is the only one left before it truncates the file
+    struct stat st;
+    if(flock(ml->fd, LOCK_SH) != 0 || fstat(ml->fd, &st) != 0){
+        close(ml->fd);
+        return false;
+    }
+    size_t bytes = (size_t) st.st_size;
+    if(bytes == 0 && !readonly && recsize > 0){
+        // A new file gets a header and room for the first records
+        bytes = sizeof(_mlheader_t) + mappedlist_initsize*recsize;
+        if(ftruncate(ml->fd, (off_t) bytes) != 0){
+            close(ml->fd);
+            return false;
+        }
+        ml->recsize = recsize;
+        ml->size = 0;
+        if(!_ml_map(ml, bytes)){
+            close(ml->fd);
+            return false;
+        }
+        ml->header->magic = _ML_MAGIC;
+        ml->header->recsize = recsize;
+        ml->header->length = 0;
+        ml->size = mappedlist_initsize;
+        return true;
+    }
+    _mlheader_t header;
+    if(bytes < sizeof(_mlheader_t) ||
+       pread(ml->fd, &header, sizeof(header), 0) != sizeof(header) ||
+       header.magic != _ML_MAGIC || header.recsize == 0 ||
+       (recsize != 0 && header.recsize != recsize) ||
+       header.length > (bytes - sizeof(_mlheader_t))/header.recsize){
+        close(ml->fd);
+        return false;
+    }
+    ml->recsize = (size_t) header.recsize;
+    ml->size = 0;
+    if(!_ml_map(ml, bytes)){
+        close(ml->fd);
+        return false;
+    }
+    ml->size = (bytes - sizeof(_mlheader_t))/ml->recsize;
+    return true;
+}
+
+/**
+ * Unmap a list and close its file
+ * <p>
+ * A writable file is first truncated to the records in use, unless other
+ * lists still have it open, since shrinking the file under their mappings
+ * would fault their reads. The changes reach the file without a flush, which
+ * only forces them to disk
+ * @param ml  The list to close
+ * @return  t/f depending on the successful truncation and closing of the file
+ */
+bool mappedlist_close(mappedlist_t* ml){
+    bool success = true;
+    size_t length = (size_t) ml->header->length;
+    munmap(ml->header, sizeof(_mlheader_t) + ml->size*ml->recsize);
+    ml->header = NULL;
+    ml->records = NULL;
+    if(!ml->readonly && flock(ml->fd, LOCK_EX | LOCK_NB) == 0){
+        success = ftruncate(ml->fd, (off_t) (sizeof(_mlheader_t) +
+                                             length*ml->recsize)) == 0;
+    }
+    return close(ml->fd) == 0 && success;
+}
+
+/**
+ * Write the changes to a list through to disk, waiting until they are stored
+ * @param ml  The list to flush
+ * @return  t/f depending on the success of msync
+ */
+bool mappedlist_flush(mappedlist_t* ml){
+    return msync(ml->header, sizeof(_mlheader_t) + ml->size*ml->recsize,
+                 MS_SYNC) == 0;
+}
+
+/**
+ * Ensure the file has room for the specified number of records, growing it by
+ * a factor of 2 if it does not
+ * <p>
+ * Growing remaps the file, so pointers to records are invalidated. The file
+ * never shrinks here: if another writer has already grown it further, the
+ * list maps the whole file instead
+ * @param ml    The list to grow
+ * @param size  The number of records to make room for
+ * @return  t/f depending on the list being writable and the file and mapping
+ *          growing successfully
+ */
+bool mappedlist_reserve(mappedlist_t* ml, const size_t size){
+    if(ml->size >= size){
+        return true;
+    }
+    if(ml->readonly){
+        return false;
+    }
+    size_t newsize = ml->size > 0 ? ml->size : mappedlist_initsize;
+    while(newsize < size){
+        newsize *= mappedlist_resize_factor;
+    }
+    struct stat st;
+    if(fstat(ml->fd, &st) != 0){
+        return false;
+    }
+    size_t filesize = (size_t) st.st_size > sizeof(_mlheader_t) ?
+        ((size_t) st.st_size - sizeof(_mlheader_t))/ml->recsize : 0;
+    if(filesize > newsize){
+        newsize = filesize;
+    }
+    size_t bytes = sizeof(_mlheader_t) + newsize*ml->recsize;
+    if(newsize > filesize && ftruncate(ml->fd, (off_t) bytes) != 0){
+        return false;
+    }
+    if(!_ml_map(ml, bytes)){
+        // Map the old records again so the list stays usable
+        _ml_map(ml, sizeof(_mlheader_t) + ml->size*ml->recsize);
+        return false;
+    }
+    ml->size = newsize;
+    return true;
+}
+
+/**
+ * Copy a record to the end of the list
+ * @param ml   The list to append to
+ * @param rec  The recsize bytes of the record
+ * @return  t/f depending on the list being writable and having room
+ */
+bool mappedlist_append(mappedlist_t* ml, const void* rec){
+    if(ml->readonly || !mappedlist_reserve(ml, ml->header->length + 1)){
+        return false;
+    }
+    memcpy(ml->records + ml->header->length*ml->recsize, rec, ml->recsize);
+    ml->header->length++;
+    return true;
+}
+
+/**
+ * Overwrite the record at the specified index
+ * @param ml   The list to change
+ * @param ind  The index of the record
+ * @param rec  The recsize bytes of the new record
+ * @return  t/f depending on the list being writable and the index being valid
+ */
+bool mappedlist_set(mappedlist_t* ml, const size_t ind, const void* rec){
+    if(ml->readonly || ind >= ml->header->length){
+        return false;
+    }
+    memcpy(ml->records + ind*ml->recsize, rec, ml->recsize);
+    return true;
+}
+
+/**
+ * Remove the last record from the list
+ * @param ml   The list to remove from
+ * @param rec  Receives the recsize bytes of the removed record if not NULL
+ * @return  t/f depending on the list being writable and not empty
+ */
+bool mappedlist_removelast(mappedlist_t* ml, void* rec){
+    if(ml->readonly || ml->header->length == 0){
+        return false;
+    }
+    ml->header->length--;
+    if(rec != NULL){
+        memcpy(rec, ml->records + ml->header->length*ml->recsize, ml->recsize);
+    }
+    return true;
+}
+
+/**
+ * Delete all records. The file keeps its size until the list is closed
+ * @param ml  The list to clear
+ * @return  t/f depending on the list being writable
+ */
+bool mappedlist_clear(mappedlist_t* ml){
+    if(ml->readonly){
+        return false;
+    }
+    ml->header->length = 0;
+    return true;
+}
+
+/**
+ * Returns the number of records in the list
+ * @param ml  The list
+ * @return  The length of the list
+ */
+size_t mappedlist_length(mappedlist_t* ml){
+    return _ml_length(ml);
+}
+
+/**
+ * Returns the number of bytes in each record of the list
+ * @param ml  The list
+ * @return  The record size of the list
+ */
+size_t mappedlist_recsize(const mappedlist_t* ml){
+    return ml->recsize;
+}
+
+/**
+ * Returns a pointer to the record at the specified index, which stays valid
+ * until the list grows or is closed, or a read only list maps more of the
+ * file. Writing through it is only allowed if the
+ * list is writable
+ * @param ml   The list to look in
+ * @param ind  The index of the record
+ * @return  The record, or NULL if the index is out of range
+ */
+void* mappedlist_get(mappedlist_t* ml, const size_t ind){
+    if(ind >= _ml_length(ml)){
+        return NULL;
+    }
+    return ml->records + ind*ml->recsize;
+}
+
+/**
+ * Returns the records of the list as one array in the mapping, without
+ * copying them. The array stays valid until the list grows or is closed, and
+ * for a read only list until a later call maps more of the file
+ * @param ml  The list
+ * @return  The array of length records of recsize bytes
+ */
+void* mappedlist_toarray(mappedlist_t* ml){
+    _ml_length(ml);
+    return ml->records;
+}
@@ -1,10 +1,252 @@
 /*
  c priority queue data structure based on a min heap
 */
+#include <string.h>
+#include <stdint.h>
 #include "priorityqueue.h"
 
-const size_t priorityqueue_init_size = 16;  
-const size_t priorityqueue_resize_factor = 2; 
+const size_t priorityqueue_init_size = 16;
+const size_t priorityqueue_resize_factor = 2;
+const size_t priorityqueue_default_arity = 2;
+const size_t priorityqueue_cacheline = 64;
+const size_t priorityqueue_max_arity = 1024;
+const size_t priorityqueue_heapify_ratio = 4;
+
+#define _PQ_NOPOS ((size_t) -1)
+#define _PQ_SNAPMAGIC 0x31504e5351504a4cull // "LJPQSNP1" little endian
+
+// Header of a snapshot, followed by count encoded elements in heap order
+typedef struct _pqsnapshot_t _pqsnapshot_t;
+struct _pqsnapshot_t{
+    uint64_t magic;    // _PQ_SNAPMAGIC
+    uint64_t arity;    // Children per node of the saved heap
+    uint64_t count;    // # of elements
+    uint64_t elemsize; // Bytes per encoded element
+};
+
+/**
+ * Returns the bytes of a heap array with room for size elements behind pad
+ * unused slots, rounded up to whole cache lines
+ */
+static inline size_t _pq_bytes(size_t pad, size_t size){
+    size_t bytes = (pad + size)*sizeof(void*);
+    bytes += priorityqueue_cacheline - 1;
+    return bytes - bytes % priorityqueue_cacheline;
+}
+
+/**
+ * Allocate a cache line aligned heap array with room for size elements behind
+ * pad unused slots
+ * <p>
+ * With pad = arity - 1 the children of every node start on a multiple of arity
+ * slots from the aligned base, so the children of a node share a cache line
+ * whenever arity*sizeof(void*) fits in one
+ * @param alloc  The allocator to take the array from, or NULL for malloc
+ * @param pad    The number of slots to leave in front of the heap
+ * @param size   The number of elements to make room for
+ * @return  A pointer to the first heap slot, or NULL if allocation failed
+ */
+static void** _pq_alloc(allocator_t* alloc, size_t pad, size_t size){
+    void** base = (void**) allocator_alloc(alloc, _pq_bytes(pad, size),
+                                           priorityqueue_cacheline);
+    return base != NULL ? base + pad : NULL;
+}
+
+/**
+ * Call the comparator of the queue, counting the call in a stats build
+ */
+static inline int _pq_cmp(const priorityqueue_t* pq, const void* a,
+                          const void* b){
+    _STATS_INC(pq, cmps, 1);
+    return pq->cmp(a, b);
+}
+
+/**
+ * Count a sift that moved an element the given number of levels
+ */
+static inline void _pq_countsift(priorityqueue_t* pq, size_t levels){
+    _STATS_INC(pq, sifts, 1);
+    _STATS_INC(pq, siftlevels, levels);
+    _STATS_INC(pq, moves, levels);
+    _STATS_MAX(pq, maxsift, levels);
+}
+
+/**
+ * Records that the element with the given handle is at ind in an indexed queue
+ */
+static inline void _pq_sethandle(priorityqueue_t* pq, size_t ind,
+                                 size_t handle){
+    if(pq->hnd){
+        pq->hnd[ind] = handle;
+        pq->pos[handle] = ind;
+    }
+}
+
+/**
+ * Moves the handle of the element at from to to in an indexed queue
+ */
+static inline void _pq_movehandle(priorityqueue_t* pq, size_t to, size_t from){
+    if(pq->hnd){
+        _pq_sethandle(pq, to, pq->hnd[from]);
+    }
+}
+
+/**
+ * Gives the element just appended at ind a handle in an indexed queue
+ * <p>
+ * hnd holds the handles of the elements in the heap followed by the handles
+ * that have been released, so a released handle is already waiting at ind
+ * whenever any exist
+ */
+static inline void _pq_newhandle(priorityqueue_t* pq, size_t ind){
+    if(pq->hnd){
+        if(ind >= pq->handles){
+            pq->hnd[ind] = pq->handles;
+            pq->handles++;
+        }
+        pq->pos[pq->hnd[ind]] = ind;
+    }
+}
+
+/**
+ * Move the element at ind up the heap until its parent is not larger
+ * @param pq   The queue to fix
+ * @param ind  The index of the element that may be smaller than its parent
+ */
+static void _pq_siftup(priorityqueue_t* pq, size_t ind){
+    void* elem = pq->data[ind];
+    size_t handle = pq->hnd ? pq->hnd[ind] : 0;
+    size_t levels = 0;
+    while(ind > 0){
+        size_t parent = _PQ_PARENT(ind, pq->arity);
+        if(_pq_cmp(pq, elem, pq->data[parent]) < 0){
+            pq->data[ind] = pq->data[parent];
+            _pq_movehandle(pq, ind, parent);
+            ind = parent;
+            levels++;
+        }
+        else{
+            break;
+        }
+    }
+    _pq_countsift(pq, levels);
+    pq->data[ind] = elem;
+    _pq_sethandle(pq, ind, handle);
+}
+
+/**
+ * Move the element at ind down the heap until none of its children are smaller
+ * @param pq   The queue to fix
+ * @param ind  The index of the element that may be larger than its children
+ */
+static void _pq_siftdown(priorityqueue_t* pq, size_t ind){
+    void* elem = pq->data[ind];
+    size_t handle = pq->hnd ? pq->hnd[ind] : 0;
+    size_t child = _PQ_CHILD(ind, pq->arity);
+    size_t levels = 0;
+    while(child < pq->length){
+        size_t last = child + pq->arity;
+        if(last > pq->length){
+            last = pq->length;
+        }
+        size_t min_ind = child;
+        size_t i;
+        for(i = child + 1; i < last; i++){
+            if(_pq_cmp(pq, pq->data[i], pq->data[min_ind]) < 0){
+                min_ind = i;
+            }
+        }
+        if(_pq_cmp(pq, pq->data[min_ind], elem) < 0){
+            pq->data[ind] = pq->data[min_ind];
+            _pq_movehandle(pq, ind, min_ind);
+            ind = min_ind;
+            child = _PQ_CHILD(ind, pq->arity);
+            levels++;
+        }
+        else{
+            break;
+        }
+    }
+    _pq_countsift(pq, levels);
+    pq->data[ind] = elem;
+    _pq_sethandle(pq, ind, handle);
+}
+
+/**
+ * Move the element at ind up or down the heap, whichever restores the heap
+ * condition after it was replaced
+ * @param pq   The queue to fix
+ * @param ind  The index of the replaced element
+ */
+static void _pq_sift(priorityqueue_t* pq, size_t ind){
+    if(ind > 0 &&
+       _pq_cmp(pq, pq->data[ind], pq->data[_PQ_PARENT(ind, pq->arity)]) < 0){
+        _pq_siftup(pq, ind);
+    }
+    else{
+        _pq_siftdown(pq, ind);
+    }
+}
+
+/**
+ * Remove the element at ind from the heap, filling its place with the last
+ * element. Releases the handle of the removed element in an indexed queue
+ * @param pq   The queue to remove from
+ * @param ind  The index of the element to remove, less than pq->length
+ * @return  The removed element
+ */
+static void* _pq_removeat(priorityqueue_t* pq, size_t ind){
+    void* elem = pq->data[ind];
+    size_t handle = pq->hnd ? pq->hnd[ind] : 0;
+
+    // Grab last element and shrink list
+    pq->length--;
+    pq->data[ind] = pq->data[pq->length];
+    pq->data[pq->length] = NULL;
+    if(pq->hnd){
+        _pq_movehandle(pq, ind, pq->length);
+        // The freed handle is kept just past the end of the heap for reuse
+        pq->hnd[pq->length] = handle;
+        pq->pos[handle] = _PQ_NOPOS;
+    }
+
+    if(ind < pq->length){
+        _pq_sift(pq, ind);
+    }
+    return elem;
+}
+
+/**
+ * Restore the heap condition after the elements in [from, pq->length) were
+ * appended without sifting, using Floyd's bottom-up construction
+ * <p>
+ * Only the ancestors of the appended range can violate the heap condition, and
+ * the ancestors of a contiguous range at each level are again contiguous, so
+ * the nodes are sifted down level by level from the bottom. Rebuilding a whole
+ * heap this way is O(n)
+ * @param pq    The queue to fix
+ * @param from  The index of the first appended element
+ */
+static void _pq_heapify(priorityqueue_t* pq, size_t from){
+    if(pq->length < 2 || from >= pq->length){
+        return;
+    }
+    size_t lo = from > 0 ? from : 1;
+    size_t hi = pq->length - 1;
+    size_t done = pq->length; // Nodes >= done have already been sifted
+    while(lo > 0){
+        lo = _PQ_PARENT(lo, pq->arity);
+        hi = _PQ_PARENT(hi, pq->arity);
+        if(hi >= done){
+            hi = done - 1;
+        }
+        size_t i;
+        for(i = hi + 1; i > lo; i--){
+            _pq_siftdown(pq, i - 1);
+        }
+        done = lo;
+    }
+}
 
 /**
  * Initialize a priority queue with a given comparator function for its elements
@@ -14,10 +256,127 @@ const size_t priorityqueue_resize_factor = 2;
  */
 bool priorityqueue_init(priorityqueue_t* pq,
                         int (*cmp)(const void*, const void*)){
-    pq->data = (void**) malloc(priorityqueue_init_size*sizeof(void*));
+    return priorityqueue_init_arity(pq, cmp, priorityqueue_default_arity);
+}
+
+/**
+ * Initialize a priority queue backed by a heap in which every node has the
+ * given number of children
+ * <p>
+ * Wider heaps are shallower, so a poll visits fewer levels at the cost of more
+ * comparisons per level. Child groups are cache line aligned, so an arity of 4
+ * or 8 lets every level of a sift down touch a single cache line
+ * @param pq     The priority queue pointer to initialize
+ * @param cmp    The compare function for the queue. Must take pointers to queue
+ *               elements and return an integer
+ * @param arity  The number of children of each heap node, at least 2 and at
+ *               most priorityqueue_max_arity
+ * @return  t/f depending on the validity of the arity and the successful
+ *          allocation of the queue
+ */
+bool priorityqueue_init_arity(priorityqueue_t* pq,
+                              int (*cmp)(const void*, const void*),
+                              size_t arity){
+    return priorityqueue_init_allocator(pq, cmp, arity, NULL);
+}
+
+/**
+ * Initialize a priority queue that takes its memory from an allocator
+ * <p>
+ * A queue in an arena need not be freed, since resetting the arena releases
+ * it. The heap array is cache line aligned, which pool allocators cannot serve
+ * @param pq     The priority queue pointer to initialize
+ * @param cmp    The compare function for the queue. Must take pointers to queue
+ *               elements and return an integer
+ * @param arity  The number of children of each heap node, at least 2 and at
+ *               most priorityqueue_max_arity
+ * @param alloc  The allocator for the heap array, or NULL for malloc
+ * @return  t/f depending on the validity of the arity and the successful
+ *          allocation of the queue
+ */
+bool priorityqueue_init_allocator(priorityqueue_t* pq,
+                                  int (*cmp)(const void*, const void*),
+                                  size_t arity, allocator_t* alloc){
+    if(arity < 2 || arity > priorityqueue_max_arity){
+        return false;
+    }
+    pq->alloc = alloc;
+    pq->data = _pq_alloc(alloc, arity - 1, priorityqueue_init_size);
     pq->length = 0;
     pq->size = priorityqueue_init_size;
+    pq->arity = arity;
+    pq->pad = arity - 1;
     pq->cmp = cmp;
+    pq->pos = NULL;
+    pq->hnd = NULL;
+    pq->handles = 0;
+    _STATS_RESET(pq);
+    _STATS_INC(pq, bytes, (pq->pad + pq->size)*sizeof(void*));
+    return pq->data != NULL;
+}
+
+/**
+ * Initialize an indexed priority queue, which gives every added element a
+ * handle
+ * <p>
+ * A handle stays valid while its element is in the queue and allows the element
+ * to be found in O(1) and removed or reprioritized in O(log n) instead of
+ * searching the heap. Handles of removed elements are reused by later adds
+ * @param pq     The priority queue pointer to initialize
+ * @param cmp    The compare function for the queue. Must take pointers to queue
+ *               elements and return an integer
+ * @param arity  The number of children of each heap node, at least 2 and at
+ *               most priorityqueue_max_arity
+ * @return  t/f depending on the validity of the arity and the successful
+ *          allocation of the queue
+ */
+bool priorityqueue_init_indexed(priorityqueue_t* pq,
+                                int (*cmp)(const void*, const void*),
+                                size_t arity){
+    if(!priorityqueue_init_arity(pq, cmp, arity)){
+        return false;
+    }
+    pq->pos = (size_t*) allocator_alloc(pq->alloc, pq->size*sizeof(size_t),
+                                        sizeof(size_t));
+    pq->hnd = (size_t*) allocator_alloc(pq->alloc, pq->size*sizeof(size_t),
+                                        sizeof(size_t));
+    _STATS_INC(pq, bytes, 2*pq->size*sizeof(size_t));
+    if(pq->pos == NULL || pq->hnd == NULL){
+        priorityqueue_free(pq);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Initialize a priority queue from an existing array of elements
+ * <p>
+ * The queue takes ownership of the array without copying it and arranges the
+ * elements into a binary heap in O(n). The array must have been allocated with
+ * malloc and must not be used or freed by the caller afterwards
+ * @param pq    The priority queue pointer to initialize
+ * @param cmp   The compare function for the queue. Must take pointers to queue
+ *              elements and return an integer
+ * @param ary   The malloc'd array of pointers to the elements of the queue
+ * @param len   The number of elements in ary
+ * @return  t/f depending on the validity of the given array
+ */
+bool priorityqueue_init_from_array(priorityqueue_t* pq,
+                                   int (*cmp)(const void*, const void*),
+                                   void** ary, const size_t len){
+    pq->data = ary;
+    pq->length = len;
+    pq->size = len;
+    pq->arity = priorityqueue_default_arity;
+    pq->pad = 0;
+    pq->cmp = cmp;
+    pq->pos = NULL;
+    pq->hnd = NULL;
+    pq->handles = 0;
+    pq->alloc = NULL;
+    _STATS_RESET(pq);
+    _STATS_MAX(pq, highwater, len);
+    _pq_heapify(pq, 0);
     return pq->data != NULL;
 }
 
@@ -30,7 +389,17 @@ bool priorityqueue_init(priorityqueue_t* pq,
  */
 void priorityqueue_free(priorityqueue_t* pq){
     if(pq->data){
-        free(pq->data);
+        allocator_free(pq->alloc, pq->data - pq->pad,
+                       _pq_bytes(pq->pad, pq->size));
+        pq->data = NULL;
+    }
+    if(pq->pos){
+        allocator_free(pq->alloc, pq->pos, pq->size*sizeof(size_t));
+        pq->pos = NULL;
+    }
+    if(pq->hnd){
+        allocator_free(pq->alloc, pq->hnd, pq->size*sizeof(size_t));
+        pq->hnd = NULL;
     }
 }
 
@@ -38,7 +407,7 @@ void priorityqueue_free(priorityqueue_t* pq){
  * Ensure that sufficient memory is allocated for the queue to hold the
  * specified amount of memory
  * <p>
- * The queue is only resized by factors of two, so the actual size of the array 
+ * The queue is only resized by factors of two, so the actual size of the array
  * will be the next largest power of two after size
  * @param pq    The priority queue to allocate memory for
  * @param size  The number of elements to ensure space is allocated for
@@ -46,13 +415,66 @@ void priorityqueue_free(priorityqueue_t* pq){
  */
 bool priorityqueue_reserve(priorityqueue_t* pq, size_t size){
     if(pq->size < size){
-        while(pq->size < size){
-            pq->size *= priorityqueue_resize_factor;
+        size_t newsize = pq->size > 0 ? pq->size : priorityqueue_init_size;
+        while(newsize < size){
+            newsize *= priorityqueue_resize_factor;
+        }
+        if(pq->hnd){
+            size_t* pos = (size_t*) allocator_resize(pq->alloc, pq->pos,
+                                                     pq->size*sizeof(size_t),
+                                                     newsize*sizeof(size_t));
+            if(pos == NULL){
+                return false;
+            }
+            pq->pos = pos;
+            size_t* hnd = (size_t*) allocator_resize(pq->alloc, pq->hnd,
+                                                     pq->size*sizeof(size_t),
+                                                     newsize*sizeof(size_t));
+            if(hnd == NULL){
+                return false;
+            }
+            pq->hnd = hnd;
+            _STATS_INC(pq, bytes, 2*newsize*sizeof(size_t));
         }
-        pq->data = (void**) realloc(pq->data, pq->size*sizeof(void*));
+        void** data = _pq_alloc(pq->alloc, pq->arity - 1, newsize);
+        if(data == NULL){
+            return false;
+        }
+        memcpy(data, pq->data, pq->length*sizeof(void*));
+        _STATS_INC(pq, reallocs, 1);
+        _STATS_INC(pq, bytes, (pq->arity - 1 + newsize)*sizeof(void*));
+        _STATS_INC(pq, moves, pq->length);
+        allocator_free(pq->alloc, pq->data - pq->pad,
+                       _pq_bytes(pq->pad, pq->size));
+        pq->data = data;
+        pq->size = newsize;
+        pq->pad = pq->arity - 1;
     }
     return pq->data != NULL;
-}   
+}
+
+/**
+ * Read the instrumentation counters of a queue
+ * <p>
+ * The counters are only kept when the library is built with JAVAUTIL_STATS,
+ * otherwise they all read as 0
+ * @param pq     The queue to read the counters of
+ * @param stats  Set to the counters accumulated since the queue was
+ *               initialized or the counters were last reset
+ */
+void priorityqueue_stats(const priorityqueue_t* pq, javautil_stats_t* stats){
+    _STATS_READ(pq, stats);
+}
+
+/**
+ * Zero the instrumentation counters of a queue. The high water mark restarts
+ * from the current size
+ * @param pq  The queue to reset the counters of
+ */
+void priorityqueue_resetstats(priorityqueue_t* pq){
+    _STATS_RESET(pq);
+    _STATS_MAX(pq, highwater, pq->length);
+}
 
 /**
  * Add an element to the queue with natural priority (from comparator)
@@ -63,26 +485,43 @@ bool priorityqueue_reserve(priorityqueue_t* pq, size_t size){
 bool priorityqueue_add(priorityqueue_t* pq, void* elem){
     bool success = priorityqueue_reserve(pq, pq->length + 1);
     if(success){
-        size_t ind = pq->length;
-        pq->data[ind] = elem;
+        pq->data[pq->length] = elem;
+        _pq_newhandle(pq, pq->length);
         pq->length++;
-        while(ind > 0){
-            if(pq->cmp(pq->data[ind], pq->data[_PQ_PARENT(ind)]) < 0){
-                // Swap
-                pq->data[ind] = pq->data[_PQ_PARENT(ind)];
-                pq->data[_PQ_PARENT(ind)] = elem;
-                ind = _PQ_PARENT(ind);
-            }
-            else{
-                break;
-            }
-        }
+        _STATS_MAX(pq, highwater, pq->length);
+        _pq_siftup(pq, pq->length - 1);
     }
     return success;
 }
 
+/**
+ * Add an element to an indexed queue and return the handle it was given
+ * @param pq      The indexed queue to add to
+ * @param elem    The pointer to the element to add
+ * @param handle  Set to the handle of the added element
+ * @return  t/f depending on the successful addition of the element. Always
+ *          false if the queue is not indexed
+ */
+bool priorityqueue_add_handle(priorityqueue_t* pq, void* elem,
+                              priorityqueue_handle_t* handle){
+    if(pq->hnd == NULL || !priorityqueue_reserve(pq, pq->length + 1)){
+        return false;
+    }
+    pq->data[pq->length] = elem;
+    _pq_newhandle(pq, pq->length);
+    *handle = pq->hnd[pq->length];
+    pq->length++;
+    _STATS_MAX(pq, highwater, pq->length);
+    _pq_siftup(pq, pq->length - 1);
+    return true;
+}
+
 /**
  * Add an array of elements to the queue with natural priority (from comparator)
+ * <p>
+ * Small batches are sifted up one element at a time. Batches that are large
+ * relative to the queue are appended and heapified bottom-up, which takes a
+ * linear number of comparisons instead of O(len log n)
  * @param pq     The queue to add to
  * @param elems  The array of pointers to the elements to add
  * @param size   The number of elements in the elems
@@ -91,21 +530,24 @@ bool priorityqueue_add(priorityqueue_t* pq, void* elem){
 bool priorityqueue_addall(priorityqueue_t* pq, void** elems, size_t len){
     bool success = priorityqueue_reserve(pq, pq->length + len);
     if(success){
-        size_t i, ind;
-        for(i = 0; i < len; i++){
-            ind = pq->length;
-            pq->data[ind] = elems[i];
-            pq->length++;
-            while(ind > 0){
-                if(pq->cmp(pq->data[ind], pq->data[_PQ_PARENT(ind)]) < 0){
-                    // Swap
-                    pq->data[ind] = pq->data[_PQ_PARENT(ind)];
-                    pq->data[_PQ_PARENT(ind)] = elems[i];
-                    ind = _PQ_PARENT(ind);
-                }
-                else{
-                    break;
-                }
+        size_t i;
+        if(len*priorityqueue_heapify_ratio >= pq->length){
+            size_t from = pq->length;
+            memcpy(&pq->data[from], elems, len*sizeof(void*));
+            for(i = from; i < from + len; i++){
+                _pq_newhandle(pq, i);
+            }
+            pq->length += len;
+            _STATS_MAX(pq, highwater, pq->length);
+            _pq_heapify(pq, from);
+        }
+        else{
+            for(i = 0; i < len; i++){
+                pq->data[pq->length] = elems[i];
+                _pq_newhandle(pq, pq->length);
+                pq->length++;
+                _STATS_MAX(pq, highwater, pq->length);
+                _pq_siftup(pq, pq->length - 1);
             }
         }
     }
@@ -120,40 +562,65 @@ bool priorityqueue_addall(priorityqueue_t* pq, void** elems, size_t len){
  */
 bool priorityqueue_remove(priorityqueue_t* pq, const void* elem){
     size_t ind = 0;
-    while(ind < pq->length && pq->cmp(pq->data[ind], elem) != 0){
+    while(ind < pq->length && _pq_cmp(pq, pq->data[ind], elem) != 0){
         ind++;
     }
     if(ind == pq->length){
         return false;
     }
-    
-    // Grab last element and shrink list
-    pq->data[ind] = pq->data[pq->length - 1];
-    pq->data[pq->length - 1] = NULL;
-    pq->length--;
-    
-    size_t min_ind = ind;
-    bool swap = true;
-    while(swap && ind < pq->length){
-        swap = false;
-        min_ind = ind;
-        if(_PQ_LEFT(ind) < pq->length &&
-           pq->cmp(pq->data[_PQ_LEFT(ind)], pq->data[min_ind]) < 0){
-            min_ind = _PQ_LEFT(ind);
-        }
-        if(_PQ_RIGHT(ind) < pq->length &&
-           pq->cmp(pq->data[_PQ_RIGHT(ind)], pq->data[min_ind]) < 0){
-            min_ind = _PQ_RIGHT(ind);
-        }
-        
-        if(min_ind != ind){
-            void* tmp = pq->data[ind];
-            pq->data[ind] = pq->data[min_ind];
-            pq->data[min_ind] = tmp;
-            swap = true;
-        }
-        ind = min_ind;
+    _pq_removeat(pq, ind);
+    return true;
+}
+
+/**
+ * Remove the element with the given handle from an indexed queue in O(log n)
+ * @param pq      The indexed queue to remove from
+ * @param handle  The handle of the element to remove
+ * @return  The removed element, or NULL if the handle is not in the queue
+ */
+void* priorityqueue_remove_handle(priorityqueue_t* pq,
+                                  priorityqueue_handle_t handle){
+    if(!priorityqueue_contains_handle(pq, handle)){
+        return NULL;
+    }
+    return _pq_removeat(pq, pq->pos[handle]);
+}
+
+/**
+ * Replace the element with the given handle by one with a smaller or equal
+ * priority, which may be the same pointer after its key was lowered in place
+ * @param pq      The indexed queue to update
+ * @param handle  The handle of the element to update
+ * @param elem    The element to store under the handle
+ * @return  Whether or not the handle was found in the queue
+ */
+bool priorityqueue_decrease_key(priorityqueue_t* pq,
+                                priorityqueue_handle_t handle, void* elem){
+    if(!priorityqueue_contains_handle(pq, handle)){
+        return false;
+    }
+    size_t ind = pq->pos[handle];
+    pq->data[ind] = elem;
+    _pq_siftup(pq, ind);
+    return true;
+}
+
+/**
+ * Replace the element with the given handle by one with any priority, which
+ * may be the same pointer after its key was changed in place
+ * @param pq      The indexed queue to update
+ * @param handle  The handle of the element to update
+ * @param elem    The element to store under the handle
+ * @return  Whether or not the handle was found in the queue
+ */
+bool priorityqueue_update_key(priorityqueue_t* pq,
+                              priorityqueue_handle_t handle, void* elem){
+    if(!priorityqueue_contains_handle(pq, handle)){
+        return false;
     }
+    size_t ind = pq->pos[handle];
+    pq->data[ind] = elem;
+    _pq_sift(pq, ind);
     return true;
 }
 
@@ -166,6 +633,9 @@ void priorityqueue_clear(priorityqueue_t* pq){
     for(i = 0; i < pq->size; i++){
         pq->data[i] = NULL;
     }
+    for(i = 0; i < pq->length && pq->hnd; i++){
+        pq->pos[pq->hnd[i]] = _PQ_NOPOS;
+    }
     pq->length = 0;
 }
 
@@ -179,36 +649,7 @@ void* priorityqueue_poll(priorityqueue_t* pq){
         return NULL;
     }
 
-    // Grab last element and shrink list
-    void* elem = pq->data[0];
-    pq->data[0] = pq->data[pq->length - 1];
-    pq->data[pq->length - 1] = NULL;
-    pq->length--;
-    
-    size_t ind = 0;
-    size_t min_ind = ind;
-    bool swap = true;
-    while(swap && ind < pq->length){
-        swap = false;
-        min_ind = ind;
-        if(_PQ_LEFT(ind) < pq->length &&
-           pq->cmp(pq->data[_PQ_LEFT(ind)], pq->data[min_ind]) < 0){
-            min_ind = _PQ_LEFT(ind);
-        }
-        if(_PQ_RIGHT(ind) < pq->length &&
-           pq->cmp(pq->data[_PQ_RIGHT(ind)], pq->data[min_ind]) < 0){
-            min_ind = _PQ_RIGHT(ind);
-        }
-        
-        if(min_ind != ind){
-            void* tmp = pq->data[ind];
-            pq->data[ind] = pq->data[min_ind];
-            pq->data[min_ind] = tmp;
-            swap = true;
-        }
-        ind = min_ind;
-    }
-    return elem;
+    return _pq_removeat(pq, 0);
 }
 
 /**
@@ -220,13 +661,40 @@ void* priorityqueue_poll(priorityqueue_t* pq){
 bool priorityqueue_contains(const priorityqueue_t* pq, const void* elem){
     size_t i;
     for(i = 0; i < pq->length; i++){
-        if(pq->data[i] != NULL && pq->cmp(elem, pq->data[i]) == 0){
+        if(pq->data[i] != NULL && _pq_cmp(pq, elem, pq->data[i]) == 0){
             return true;
         }
     }
     return false;
 }
 
+/**
+ * Checks in O(1) whether the element with the given handle is in an indexed
+ * queue
+ * @param pq      The queue to look in
+ * @param handle  The handle of the element
+ * @return  whether or not the handle belongs to an element in the heap
+ */
+bool priorityqueue_contains_handle(const priorityqueue_t* pq,
+                                   priorityqueue_handle_t handle){
+    return pq->hnd != NULL && handle < pq->handles &&
+           pq->pos[handle] != _PQ_NOPOS;
+}
+
+/**
+ * Returns the element with the given handle in an indexed queue
+ * @param pq      The queue to look in
+ * @param handle  The handle of the element
+ * @return  The element, or NULL if the handle is not in the queue
+ */
+void* priorityqueue_get_handle(const priorityqueue_t* pq,
+                               priorityqueue_handle_t handle){
+    if(!priorityqueue_contains_handle(pq, handle)){
+        return NULL;
+    }
+    return pq->data[pq->pos[handle]];
+}
+
 /**
  * Returns the number of elements in the heap
  * @param pq  The queue
@@ -250,7 +718,98 @@ void** priorityqueue_toarray(const priorityqueue_t* pq){
  * @return  The pointer to the minimum element in the heap
  */
 void* priorityqueue_peek(const priorityqueue_t* pq){
-    return pq->data[0];
+    return pq->length > 0 ? pq->data[0] : NULL;
+}
+
+/**
+ * Write the elements of a queue to a stream in heap order, so that
+ * priorityqueue_restore can rebuild the queue without comparing any elements
+ * <p>
+ * Each element is serialized into elemsize bytes by encode, and all of them go
+ * out in a single write after a header. Snapshots use the byte order of the
+ * machine. Handles of an indexed queue are not saved
+ * @param pq        The queue to save
+ * @param f         The stream to write to
+ * @param elemsize  The number of bytes encode writes for every element
+ * @param encode    Serializes an element into a buffer of elemsize bytes
+ * @return  t/f depending on the successful allocation of the buffer and
+ *          writing of the snapshot
+ */
+bool priorityqueue_snapshot(const priorityqueue_t* pq, FILE* f,
+                            size_t elemsize,
+                            void (*encode)(const void* elem, void* buf)){
+    _pqsnapshot_t header = {_PQ_SNAPMAGIC, pq->arity, pq->length, elemsize};
+    char* buf = (char*) malloc(pq->length*elemsize + 1);
+    if(buf == NULL){
+        return false;
+    }
+    size_t i;
+    for(i = 0; i < pq->length; i++){
+        encode(pq->data[i], buf + i*elemsize);
+    }
+    bool success = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                   fwrite(buf, 1, pq->length*elemsize, f) ==
+                   pq->length*elemsize;
+    free(buf);
+    return success;
+}
+
+/**
+ * Initialize a queue from a snapshot written by priorityqueue_snapshot
+ * <p>
+ * The elements are read in a single read and decoded straight into the heap
+ * array, which is already in heap order, so no element is sifted or compared.
+ * Debug builds check the heap condition with validate_heap to catch a
+ * comparator that does not match the one of the saved queue. If the check
+ * fails the queue is freed, but the decoded elements are not
+ * @param pq      The priority queue pointer to initialize
+ * @param cmp     The compare function for the queue, ordering elements the
+ *                same way as the comparator of the saved queue
+ * @param f       The stream to read from, positioned at the snapshot
+ * @param decode  Rebuilds an element from the elemsize bytes it was encoded to
+ * @return  t/f depending on the stream holding a complete snapshot and the
+ *          successful allocation of the queue
+ */
+bool priorityqueue_restore(priorityqueue_t* pq,
+                           int (*cmp)(const void*, const void*), FILE* f,
+                           void* (*decode)(const void* buf)){
+    _pqsnapshot_t header;
+    if(fread(&header, sizeof(header), 1, f) != 1 ||
+       header.magic != _PQ_SNAPMAGIC || header.arity < 2 ||
+       header.arity > priorityqueue_max_arity ||
+       (header.elemsize > 0 && header.count > SIZE_MAX/header.elemsize)){
+        return false;
+    }
+    size_t count = (size_t) header.count;
+    size_t bytes = count*(size_t) header.elemsize;
+    char* buf = (char*) malloc(bytes + 1);
+    if(buf == NULL){
+        return false;
+    }
+    if(fread(buf, 1, bytes, f) != bytes ||
+       !priorityqueue_init_arity(pq, cmp, (size_t) header.arity)){
+        free(buf);
+        return false;
+    }
+    if(!priorityqueue_reserve(pq, count)){
+        priorityqueue_free(pq);
+        free(buf);
+        return false;
+    }
+    size_t i;
+    for(i = 0; i < count; i++){
+        pq->data[i] = decode(buf + i*header.elemsize);
+    }
+    pq->length = count;
+    _STATS_MAX(pq, highwater, count);
+    free(buf);
+#ifndef NDEBUG
+    if(!validate_heap(pq)){
+        priorityqueue_free(pq);
+        return false;
+    }
+#endif
+    return true;
 }
 
 /**
@@ -260,8 +819,8 @@ void* priorityqueue_peek(const priorityqueue_t* pq){
  */
 bool validate_heap(const priorityqueue_t* pq){
     size_t i;
-    for(i = pq->length-1; i > 0; i--){
-        if(pq->cmp(pq->data[i], pq->data[_PQ_PARENT(i)]) < 0){
+    for(i = 1; i < pq->length; i++){
+        if(pq->cmp(pq->data[i], pq->data[_PQ_PARENT(i, pq->arity)]) < 0){
             return false;
         }
     }
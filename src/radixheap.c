@@ -0,0 +1,182 @@
+/*
+ c monotone priority queue based on a radix heap
+*/
+#include "radixheap.h"
+
+static inline int _rh_cmp(const _rhentry_t* a, const _rhentry_t* b){
+    return (a->key > b->key) - (a->key < b->key);
+}
+
+ARRAYLIST_DEFINE(_rhbucket, _rhentry_t, _rh_cmp)
+
+/**
+ * Returns the bucket for key relative to the last polled key: 0 if they are
+ * equal, otherwise one more than the highest bit in which they differ
+ */
+static inline size_t _rh_bucket(uint64_t key, uint64_t last){
+    uint64_t diff = key ^ last;
+    return diff == 0 ? 0 : (size_t) (64 - __builtin_clzll(diff));
+}
+
+/**
+ * Make sure bucket 0 holds the minimum keys if the heap is not empty
+ * <p>
+ * The first non-empty bucket contains the minimum. Making it the new last key
+ * moves every entry of that bucket into a strictly lower bucket, so each entry
+ * is moved at most 64 times over its lifetime
+ * @param rh  The heap to normalize
+ * @return  Whether or not the heap has any elements and the lower buckets
+ *          could be grown to receive the moved entries
+ */
+static bool _rh_normalize(radixheap_t* rh){
+    if(rh->length == 0){
+        return false;
+    }
+    if(_rhbucket_length(&rh->buckets[0]) > 0){
+        return true;
+    }
+    size_t b = 1;
+    while(_rhbucket_length(&rh->buckets[b]) == 0){
+        b++;
+    }
+    _rhbucket_t* bucket = &rh->buckets[b];
+    size_t len = _rhbucket_length(bucket);
+    _rhentry_t* entries = _rhbucket_toarray(bucket);
+    uint64_t min = entries[0].key;
+    size_t i;
+    for(i = 1; i < len; i++){
+        min = entries[i].key < min ? entries[i].key : min;
+    }
+    // The lower buckets are all empty, so none receives more than len entries
+    for(i = 0; i < b; i++){
+        if(!_rhbucket_reserve(&rh->buckets[i], len)){
+            return false;
+        }
+    }
+    rh->last = min;
+    for(i = 0; i < len; i++){
+        _rhbucket_append(&rh->buckets[_rh_bucket(entries[i].key, min)],
+                         entries[i]);
+    }
+    _rhbucket_clear(bucket);
+    return true;
+}
+
+/**
+ * Initialize an empty radix heap
+ * @param rh  The heap pointer to initialize
+ * @return  t/f depending on the successful allocation of the buckets
+ */
+bool radixheap_init(radixheap_t* rh){
+    size_t i;
+    for(i = 0; i < _RH_BUCKETS; i++){
+        if(!_rhbucket_init(&rh->buckets[i])){
+            while(i > 0){
+                i--;
+                _rhbucket_free(&rh->buckets[i]);
+            }
+            return false;
+        }
+    }
+    rh->last = 0;
+    rh->length = 0;
+    return true;
+}
+
+/**
+ * Free the memory held by a radix heap
+ * <p>
+ * This function should be called when the heap is no longer needed and before
+ * freeing the pointer itself
+ * @param rh  The pointer to the heap whose memory should be released
+ */
+void radixheap_free(radixheap_t* rh){
+    size_t i;
+    for(i = 0; i < _RH_BUCKETS; i++){
+        _rhbucket_free(&rh->buckets[i]);
+    }
+}
+
+/**
+ * Add an element to the heap with the given key
+ * @param rh    The heap to add to
+ * @param key   The priority of the element. Must not be smaller than the last
+ *              key polled from the heap
+ * @param elem  The pointer to the element to add
+ * @return  t/f depending on the validity of the key and the successful
+ *          allocation of the requested space
+ */
+bool radixheap_add(radixheap_t* rh, uint64_t key, void* elem){
+    if(key < rh->last){
+        return false;
+    }
+    _rhentry_t entry = {key, elem};
+    if(!_rhbucket_append(&rh->buckets[_rh_bucket(key, rh->last)], entry)){
+        return false;
+    }
+    rh->length++;
+    return true;
+}
+
+/**
+ * Delete all elements from the heap and allow any key to be added again
+ * @param rh  The heap to clear
+ */
+void radixheap_clear(radixheap_t* rh){
+    size_t i;
+    for(i = 0; i < _RH_BUCKETS; i++){
+        _rhbucket_clear(&rh->buckets[i]);
+    }
+    rh->last = 0;
+    rh->length = 0;
+}
+
+/**
+ * Remove an element with the minimum key from the heap and return it
+ * @param rh   The heap to pop from
+ * @param key  Set to the key of the removed element if not NULL
+ * @return  The pointer to the minimum element, or NULL if the heap is empty or
+ *          memory to redistribute a bucket could not be allocated
+ */
+void* radixheap_poll(radixheap_t* rh, uint64_t* key){
+    if(!_rh_normalize(rh)){
+        return NULL;
+    }
+    _rhentry_t entry = _rhbucket_remove(&rh->buckets[0],
+                                        _rhbucket_length(&rh->buckets[0]) - 1);
+    rh->length--;
+    if(key){
+        *key = entry.key;
+    }
+    return entry.data;
+}
+
+/**
+ * Returns the number of elements in the heap
+ * @param rh  The heap
+ * @return  The number of elements in the heap
+ */
+size_t radixheap_size(const radixheap_t* rh){
+    return rh->length;
+}
+
+/**
+ * Returns an element with the minimum key without removing it
+ * <p>
+ * Not const, since finding the minimum redistributes a bucket. The work is not
+ * repeated by the next peek or poll
+ * @param rh   The heap to look in
+ * @param key  Set to the key of the minimum element if not NULL
+ * @return  The pointer to the minimum element, or NULL if the heap is empty
+ */
+void* radixheap_peek(radixheap_t* rh, uint64_t* key){
+    if(!_rh_normalize(rh)){
+        return NULL;
+    }
+    _rhentry_t* entry = _rhbucket_get(&rh->buckets[0],
+                                      _rhbucket_length(&rh->buckets[0]) - 1);
+    if(key){
+        *key = entry->key;
+    }
+    return entry->data;
+}
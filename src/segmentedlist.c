@@ -0,0 +1,161 @@
+/*
+ c segmented dynamic array structure
+*/
+#include <string.h>
+#include "segmentedlist.h"
+
+/**
+ * Initialize an empty segmentedlist. No memory is allocated until the first
+ * element is added
+ * @param lst  The pointer to intialize as a segmentedlist
+ */
+void segmentedlist_init(segmentedlist_t* lst){
+    memset(lst->segments, 0, sizeof(lst->segments));
+    lst->nsegments = 0;
+    lst->length = 0;
+    lst->size = 0;
+}
+
+/**
+ * Frees the segments of a segmentedlist, leaving it empty
+ * <p>
+ * This function should be called when the segmentedlist is no longer needed
+ * and before freeing the pointer itself
+ * @param lst  The segmentedlist to free
+ */
+void segmentedlist_free(segmentedlist_t* lst){
+    size_t i;
+    for(i = 0; i < lst->nsegments; i++){
+        free(lst->segments[i]);
+    }
+    segmentedlist_init(lst);
+}
+
+/**
+ * Ensure that sufficient space has been allocated to the list to store the
+ * specified number of items
+ * <p>
+ * Allocates the missing segments. Existing elements are never moved
+ * @param lst      The segmentedlist to grow
+ * @param newsize  The number of elements to reserve memory for
+ * @return  t/f depending on the successful allocation of memory
+ */
+bool segmentedlist_reserve(segmentedlist_t* lst, const size_t newsize){
+    while(lst->size < newsize){
+        if(lst->nsegments == _SL_MAXSEGS){
+            return false;
+        }
+        size_t len = (size_t) _SL_FIRSTSEG << lst->nsegments;
+        void** seg = (void**) malloc(len*sizeof(void*));
+        if(seg == NULL){
+            return false;
+        }
+        lst->segments[lst->nsegments++] = seg;
+        lst->size += len;
+    }
+    return true;
+}
+
+/**
+ * Append the given item to the segmentedlist
+ * <p>
+ * Takes O(1) time in the worst case, since a full list only allocates one new
+ * segment
+ * @param lst   The segmentedlist to append to
+ * @param data  The data to add
+ * @return  t/f depending on the successful addition of the item to the list
+ */
+bool segmentedlist_append(segmentedlist_t* lst, void* data){
+    if(!segmentedlist_reserve(lst, lst->length + 1)){
+        return false;
+    }
+    *segmentedlist_ref(lst, lst->length) = data;
+    lst->length++;
+    return true;
+}
+
+/**
+ * Removes the last element of the list and returns it. Does not release any
+ * memory
+ * @param lst  The segmentedlist to remove from
+ * @return  The removed element, or NULL if the list is empty
+ */
+void* segmentedlist_removelast(segmentedlist_t* lst){
+    if(lst->length == 0){
+        return NULL;
+    }
+    lst->length--;
+    return *segmentedlist_ref(lst, lst->length);
+}
+
+/**
+ * Replace the element at the specified index
+ * @param lst   The segmentedlist to modify
+ * @param ind   The index of the element to replace, less than the list length
+ * @param data  The new element
+ */
+void segmentedlist_set(segmentedlist_t* lst, const size_t ind, void* data){
+    *segmentedlist_ref(lst, ind) = data;
+}
+
+/**
+ * Delete all elements in the list. Does not release any memory
+ * @param lst  The segmentedlist to clear
+ */
+void segmentedlist_clear(segmentedlist_t* lst){
+    lst->length = 0;
+}
+
+/**
+ * Returns the number of items in the segmentedlist
+ * @param lst  The segmentedlist
+ * @return  The length of the given segmentedlist
+ */
+size_t segmentedlist_length(const segmentedlist_t* lst){
+    return lst->length;
+}
+
+/**
+ * Copies the elements of the list into a newly allocated array, which the
+ * caller must free
+ * @param lst  The segmentedlist
+ * @return  The array of elements in list order, or NULL if allocation failed
+ */
+void** segmentedlist_toarray(const segmentedlist_t* lst){
+    void** ary = (void**) malloc(lst->length*sizeof(void*));
+    if(ary == NULL){
+        return NULL;
+    }
+    size_t done = 0;
+    size_t seg;
+    for(seg = 0; done < lst->length; seg++){
+        size_t len = (size_t) _SL_FIRSTSEG << seg;
+        len = len < lst->length - done ? len : lst->length - done;
+        memcpy(ary + done, lst->segments[seg], len*sizeof(void*));
+        done += len;
+    }
+    return ary;
+}
+
+/**
+ * Searches the segmentedlist for the specified item using the given comparator
+ * function to check for equality. Returns the index at which the item was found
+ * or -1 if it was not found
+ */
+ptrdiff_t segmentedlist_indexof(const segmentedlist_t* lst, const void* data,
+                                int (*cmp)(const void*, const void*)){
+    size_t done = 0;
+    size_t seg;
+    for(seg = 0; done < lst->length; seg++){
+        size_t len = (size_t) _SL_FIRSTSEG << seg;
+        len = len < lst->length - done ? len : lst->length - done;
+        size_t i;
+        for(i = 0; i < len; i++){
+            if((*cmp)(data, lst->segments[seg][i]) == 0){
+                return (ptrdiff_t) (done + i);
+            }
+        }
+        done += len;
+    }
+    return -1;
+}
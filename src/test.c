@@ -1,15 +1,133 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "allocator.h"
+#include "threadpool.h"
 #include "arraylist.h"
+#include "arraylist_template.h"
+#include "arraydeque.h"
+#include "hashmap.h"
+#include "treemap.h"
+#include "bitset.h"
+#include "segmentedlist.h"
 #include "linkedlist.h"
+#include "mappedlist.h"
+#include "unrolledlist.h"
 #include "priorityqueue.h"
+#include "keyedpriorityqueue.h"
+#include "concurrentpriorityqueue.h"
+#include "concurrentqueue.h"
+#include "radixheap.h"
 
 int cmp_str(const void* a, const void* b){
     return strcmp(*((char**) a), *((char**) b));
 }
 
+int cmp_int(const void* a, const void* b){
+    int x = *((const int*) a);
+    int y = *((const int*) b);
+    return (x > y) - (x < y);
+}
+
+size_t cmp_count = 0;
+
+int cmp_int_counted(const void* a, const void* b){
+    cmp_count++;
+    return cmp_int(a, b);
+}
+
+void test_allocator(){
+    size_t i;
+    // test arena allocations are aligned and the newest one grows in place
+    arena_t arena;
+    assert(arena_init(&arena, 1024));
+    allocator_t* a = &arena.allocator;
+    char* p = (char*) allocator_alloc(a, 3, 1);
+    char* q = (char*) allocator_alloc(a, 40, 64);
+    assert(((uintptr_t) p % allocator_default_align) == 0);
+    assert(((uintptr_t) q % 64) == 0);
+    memset(q, 7, 40);
+    assert(allocator_resize(a, q, 40, 200) == q);
+    assert(arena_allocated(&arena) == 203);
+    allocator_free(a, q, 200);
+    assert(arena_allocated(&arena) == 3);
+    assert(allocator_alloc(a, 8, 8) == q);
+
+    // test resizing an older allocation copies it
+    char* r = (char*) allocator_alloc(a, 16, 8);
+    memset(r, 5, 16);
+    allocator_alloc(a, 8, 8);
+    char* moved = (char*) allocator_resize(a, r, 16, 32);
+    assert(moved != r && moved[0] == 5 && moved[15] == 5);
+
+    // test allocations larger than a block get their own
+    char* big = (char*) allocator_alloc(a, 10000, 8);
+    assert(big != NULL);
+    memset(big, 1, 10000);
+    arena_reset(&arena);
+    assert(arena_allocated(&arena) == 0);
+
+    // test containers in an arena are released by the reset alone
+    int vals[1000];
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) ((i*7919) % 1000);
+    }
+    arraylist_t lst;
+    assert(arraylist_init_allocator(&lst, a));
+    priorityqueue_t pq;
+    assert(priorityqueue_init_allocator(&pq, cmp_int, 4, a));
+    linkedlist_t ll;
+    linkedlist_init_deque(&ll);
+    assert(linkedlist_setallocator(&ll, a));
+    for(i = 0; i < 1000; i++){
+        assert(arraylist_append(&lst, &vals[i]));
+        assert(priorityqueue_add(&pq, &vals[i]));
+        assert(linkedlist_addfirst(&ll, &vals[i]));
+    }
+    assert(validate_heap(&pq));
+    for(i = 0; i < 1000; i++){
+        assert(*((int*) priorityqueue_poll(&pq)) == (int) i);
+        assert(arraylist_get(&lst, i) == &vals[i]);
+    }
+    assert(linkedlist_polllast(&ll) == &vals[0]);
+    assert(linkedlist_length(&ll) == 999);
+    assert(arena_allocated(&arena) > 1000*sizeof(void*));
+    arena_reset(&arena);
+    arena_free(&arena);
+
+    // test the pool allocator recycles objects and refuses larger ones
+    poolallocator_t pa;
+    assert(!poolallocator_init(&pa, 0));
+    assert(poolallocator_init(&pa, sizeof(_lldnode_t)));
+    a = &pa.allocator;
+    assert(allocator_alloc(a, sizeof(_lldnode_t) + 1, 8) == NULL);
+    p = (char*) allocator_alloc(a, sizeof(_lldnode_t), 8);
+    allocator_free(a, p, sizeof(_lldnode_t));
+    assert(allocator_alloc(a, sizeof(_lldnode_t), 8) == p);
+
+    // test lists can take their nodes from a pool allocator
+    linkedlist_t l1, l2;
+    linkedlist_init(&l1);
+    linkedlist_init_deque(&l2);
+    assert(linkedlist_setallocator(&l1, a));
+    assert(linkedlist_setallocator(&l2, a));
+    for(i = 0; i < 1000; i++){
+        assert(linkedlist_append(i % 2 ? &l1 : &l2, &vals[i]));
+    }
+    assert(linkedlist_get(&l1, 10) == &vals[21]);
+    assert(linkedlist_get(&l2, 499) == &vals[998]);
+    linkedlist_free(&l1);
+    linkedlist_free(&l2);
+    poolallocator_free(&pa);
+}
+
 void test_arraylist(){
     // test init and length
     arraylist_t* lst = (arraylist_t*) malloc(sizeof(arraylist_t));
@@ -34,7 +152,9 @@ void test_arraylist(){
 
     // test remove
     arraylist_remove(lst, 0);
+    assert(arraylist_length(lst) == 1);
     assert(arraylist_indexof(lst, (void*) &elem2, cmp_str) == 0);
+    assert(arraylist_remove(lst, 1) == NULL);
 
     // test resize
     arraylist_resize(lst, 16);
@@ -51,6 +171,970 @@ void test_arraylist(){
     free(lst);
 }
 
+void test_arraylist_gapbuffer(){
+    int vals[64];
+    void* ref[4096];
+    size_t i, reflen;
+    bool gapbuffer;
+    for(i = 0; i < 64; i++){
+        vals[i] = (int) i;
+    }
+    for(gapbuffer = false; ; gapbuffer = true){
+        arraylist_t lst;
+        arraylist_init(&lst);
+        arraylist_setgapbuffer(&lst, gapbuffer);
+        reflen = 0;
+
+        // test bursts of edits at a moving cursor against a plain array
+        uint64_t seed = 88172645463325252ull;
+        size_t cursor = 0;
+        for(i = 0; i < 20000; i++){
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            if(seed % 16 == 0){
+                cursor = reflen > 0 ? (seed >> 8) % (reflen + 1) : 0;
+            }
+            void* elem = &vals[(seed >> 20) % 64];
+            size_t op = (seed >> 4) % 8;
+            if(op < 4 && reflen < 4000){
+                assert(arraylist_add(&lst, cursor, elem));
+                memmove(ref + cursor + 1, ref + cursor,
+                        (reflen - cursor)*sizeof(void*));
+                ref[cursor++] = elem;
+                reflen++;
+            }
+            else if(op < 5 && reflen < 4000 - 3){
+                void* three[3] = {elem, &vals[0], elem};
+                assert(arraylist_addall(&lst, cursor, 3, three));
+                memmove(ref + cursor + 3, ref + cursor,
+                        (reflen - cursor)*sizeof(void*));
+                memcpy(ref + cursor, three, sizeof(three));
+                reflen += 3;
+            }
+            else if(op < 7 && cursor > 0){
+                cursor--;
+                assert(arraylist_remove(&lst, cursor) == ref[cursor]);
+                memmove(ref + cursor, ref + cursor + 1,
+                        (reflen - cursor - 1)*sizeof(void*));
+                reflen--;
+            }
+            else{
+                assert(arraylist_append(&lst, elem));
+                ref[reflen++] = elem;
+            }
+            assert(arraylist_length(&lst) == reflen);
+            assert(gapbuffer || lst.gap == lst.length);
+            if(i % 1000 == 0){
+                size_t j;
+                for(j = 0; j < reflen; j++){
+                    assert(arraylist_get(&lst, j) == ref[j]);
+                }
+            }
+        }
+        assert(!arraylist_add(&lst, reflen + 1, &vals[0]));
+
+        // test indexof looks on both sides of the gap
+        int missing = 64;
+        assert(arraylist_indexof(&lst, &missing, cmp_int) == -1);
+        size_t first = 0;
+        while(ref[first] != ref[reflen - 1]){
+            first++;
+        }
+        assert(arraylist_indexof(&lst, ref[reflen - 1], cmp_int) ==
+               (ptrdiff_t) first);
+
+        // test toarray closes the gap and matches
+        void** ary = arraylist_toarray(&lst);
+        assert(memcmp(ary, ref, reflen*sizeof(void*)) == 0);
+        assert(lst.gap == lst.length);
+
+        // test turning the mode off keeps the contents
+        arraylist_add(&lst, 1, &vals[1]);
+        arraylist_setgapbuffer(&lst, false);
+        assert(lst.gap == lst.length);
+        assert(arraylist_get(&lst, 1) == &vals[1]);
+        assert(arraylist_get(&lst, lst.length - 1) == ref[reflen - 1]);
+
+        arraylist_clear(&lst);
+        assert(arraylist_length(&lst) == 0);
+        arraylist_free(&lst);
+        if(gapbuffer){
+            break;
+        }
+    }
+}
+
+typedef struct sum_job_t{
+    threadpool_t* pool;
+    const int* vals;
+    size_t n;
+    long sum;
+} sum_job_t;
+
+static void sum_job(void* arg){
+    sum_job_t* job = (sum_job_t*) arg;
+    if(job->n <= 64){
+        size_t i;
+        job->sum = 0;
+        for(i = 0; i < job->n; i++){
+            job->sum += job->vals[i];
+        }
+        return;
+    }
+    sum_job_t left = {job->pool, job->vals, job->n/2, 0};
+    sum_job_t right = {job->pool, job->vals + job->n/2, job->n - job->n/2, 0};
+    threadpool_task_t task;
+    threadpool_fork(job->pool, &task, sum_job, &left);
+    sum_job(&right);
+    threadpool_join(job->pool, &task);
+    job->sum = left.sum + right.sum;
+}
+
+void test_threadpool(){
+    static int vals[100000];
+    size_t i;
+    for(i = 0; i < 100000; i++){
+        vals[i] = (int) i;
+    }
+
+    // test nested fork/join on pools with and without workers
+    size_t nthreads;
+    for(nthreads = 0; nthreads <= 4; nthreads += 4){
+        threadpool_t pool;
+        assert(threadpool_init(&pool, nthreads));
+        assert(threadpool_parallelism(&pool) == nthreads + 1);
+        int round;
+        for(round = 0; round < 10; round++){
+            sum_job_t job = {&pool, vals, 100000, 0};
+            sum_job(&job);
+            assert(job.sum == 100000L*99999/2);
+        }
+        assert(atomic_load(&pool.pending) == 0);
+        threadpool_free(&pool);
+    }
+    assert(threadpool_default() != NULL);
+    assert(threadpool_default() == threadpool_default());
+}
+
+void test_arraylist_sort(){
+    size_t n = 100000;
+    int* vals = (int*) malloc(n*sizeof(int));
+    size_t i, pattern;
+    threadpool_t pool;
+    assert(threadpool_init(&pool, 3));
+    for(pattern = 0; pattern < 5; pattern++){
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for(i = 0; i < n; i++){
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            switch(pattern){
+                case 0: vals[i] = (int) (seed % n); break;     // random
+                case 1: vals[i] = (int) i; break;              // sorted
+                case 2: vals[i] = (int) (n - i); break;        // reversed
+                case 3: vals[i] = 7; break;                    // all equal
+                default: vals[i] = (int) (seed % 4); break;    // few values
+            }
+        }
+        bool parallel;
+        for(parallel = false; ; parallel = true){
+            arraylist_t lst;
+            arraylist_init(&lst);
+            arraylist_setgapbuffer(&lst, true);
+            for(i = 0; i < n; i++){
+                arraylist_add(&lst, i/2, &vals[i]);
+            }
+            long sum = 0;
+            for(i = 0; i < n; i++){
+                sum += vals[i];
+            }
+
+            // test the result is ordered and a permutation of the input
+            if(parallel){
+                arraylist_parallel_sort(&lst, cmp_int, &pool);
+            }
+            else{
+                cmp_count = 0;
+                arraylist_sort(&lst, cmp_int_counted);
+                assert(cmp_count < 2*n*17);
+            }
+            assert(arraylist_length(&lst) == n && lst.gap == n);
+            long sorted = 0;
+            for(i = 0; i < n; i++){
+                int* elem = (int*) arraylist_get(&lst, i);
+                assert(elem >= vals && elem < vals + n);
+                assert(i == 0 || *((int*) arraylist_get(&lst, i - 1)) <= *elem);
+                sorted += *elem;
+            }
+            assert(sorted == sum);
+            arraylist_free(&lst);
+            if(parallel){
+                break;
+            }
+        }
+    }
+
+    // test short lists and lists below the parallel cutoff
+    arraylist_t lst;
+    arraylist_init(&lst);
+    arraylist_sort(&lst, cmp_int);
+    arraylist_parallel_sort(&lst, cmp_int, &pool);
+    for(i = 0; i < 100; i++){
+        arraylist_append(&lst, &vals[99 - i]);
+    }
+    arraylist_parallel_sort(&lst, cmp_int, NULL);
+    for(i = 1; i < 100; i++){
+        assert(*((int*) arraylist_get(&lst, i - 1)) <=
+               *((int*) arraylist_get(&lst, i)));
+    }
+    arraylist_free(&lst);
+    threadpool_free(&pool);
+    free(vals);
+}
+
+void test_arraylist_search(){
+    int vals[1000];
+    size_t order[1000];
+    size_t i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) (i/2)*2; // pairs of equal even values
+        order[(i*389) % 1000] = i; // the step at which each is added
+    }
+    bool gapbuffer;
+    for(gapbuffer = false; ; gapbuffer = true){
+        arraylist_t lst;
+        arraylist_init(&lst);
+        arraylist_setgapbuffer(&lst, gapbuffer);
+        int key = 5;
+        assert(arraylist_binarysearch(&lst, &key, cmp_int) == -1);
+
+        // test add_sorted keeps the list sorted and equal elements in order
+        for(i = 0; i < 1000; i++){
+            size_t j = (i*389) % 1000; // visits every index once
+            assert(arraylist_add_sorted(&lst, &vals[j], cmp_int));
+        }
+        for(i = 1; i < 1000; i++){
+            int* prev = (int*) arraylist_get(&lst, i - 1);
+            int* cur = (int*) arraylist_get(&lst, i);
+            assert(*prev <= *cur);
+            assert(*prev < *cur || order[prev - vals] < order[cur - vals]);
+        }
+
+        // test binarysearch finds the first equal element or the insertion
+        // point
+        key = 500;
+        assert(arraylist_binarysearch(&lst, &key, cmp_int) == 500);
+        key = 501;
+        assert(arraylist_binarysearch(&lst, &key, cmp_int) == -503);
+        key = -1;
+        assert(arraylist_binarysearch(&lst, &key, cmp_int) == -1);
+        key = 1000;
+        assert(arraylist_binarysearch(&lst, &key, cmp_int) == -1001);
+
+        // test identity search finds the pointer, not an equal element, on
+        // both sides of the gap
+        for(i = 0; i < 1000; i++){
+            ptrdiff_t ind = arraylist_indexof_identity(&lst, &vals[i]);
+            assert(ind >= 0 && arraylist_get(&lst, ind) == &vals[i]);
+        }
+        key = 0;
+        assert(arraylist_indexof_identity(&lst, &key) == -1);
+        assert(arraylist_indexof_identity(&lst, NULL) == -1);
+        arraylist_remove(&lst, arraylist_indexof_identity(&lst, &vals[999]));
+        assert(arraylist_indexof_identity(&lst, &vals[999]) == -1);
+        assert(arraylist_indexof_identity(&lst, &vals[998]) >= 0);
+        arraylist_free(&lst);
+        if(gapbuffer){
+            break;
+        }
+    }
+}
+
+typedef struct point_t{
+    int x;
+    int y;
+} point_t;
+
+static inline int cmp_point(const point_t* a, const point_t* b){
+    return a->x != b->x ? a->x - b->x : a->y - b->y;
+}
+
+ARRAYLIST_DECLARE(pointlist, point_t)
+ARRAYLIST_DEFINE(pointlist, point_t, cmp_point)
+
+void test_arraylist_template(){
+    // test init and length
+    pointlist_t* lst = (pointlist_t*) malloc(sizeof(pointlist_t));
+    pointlist_init(lst);
+    assert(pointlist_length(lst) == 0);
+    assert(lst->size == 8);
+
+    // test append & get
+    point_t p1 = {1, 2};
+    pointlist_append(lst, p1);
+    assert(pointlist_get(lst, 0)->x == 1 && pointlist_get(lst, 0)->y == 2);
+
+    // test add
+    point_t p0 = {0, 0};
+    pointlist_add(lst, 0, p0);
+    assert(pointlist_length(lst) == 2);
+    assert(pointlist_get(lst, 0)->x == 0);
+    assert(pointlist_get(lst, 1)->x == 1);
+
+    // test addall and growth
+    point_t pts[10];
+    int i;
+    for(i = 0; i < 10; i++){
+        pts[i].x = 10 + i;
+        pts[i].y = 0;
+    }
+    pointlist_addall(lst, 1, 10, pts);
+    assert(pointlist_length(lst) == 12);
+    assert(lst->size == 16);
+    assert(pointlist_get(lst, 0)->x == 0);
+    assert(pointlist_get(lst, 1)->x == 10);
+    assert(pointlist_get(lst, 10)->x == 19);
+    assert(pointlist_get(lst, 11)->x == 1);
+
+    // test indexof
+    assert(pointlist_indexof(lst, &p1) == 11);
+    assert(pointlist_indexof(lst, &pts[3]) == 4);
+    point_t missing = {-1, -1};
+    assert(pointlist_indexof(lst, &missing) == -1);
+
+    // test remove
+    point_t removed = pointlist_remove(lst, 0);
+    assert(removed.x == 0 && removed.y == 0);
+    assert(pointlist_length(lst) == 11);
+    assert(pointlist_indexof(lst, &p1) == 10);
+
+    // test clear
+    pointlist_clear(lst);
+    assert(pointlist_length(lst) == 0);
+
+    // test free
+    pointlist_free(lst);
+    free(lst);
+}
+
+void test_arraydeque(){
+    int vals[100];
+    void* out[100];
+    size_t i;
+    for(i = 0; i < 100; i++){
+        vals[i] = (int) i;
+    }
+    arraydeque_t dq;
+    assert(arraydeque_init(&dq));
+    assert(arraydeque_pollfirst(&dq) == NULL);
+    assert(arraydeque_polllast(&dq) == NULL);
+    assert(arraydeque_peekfirst(&dq) == NULL);
+
+    // test both ends, wrapping around the start of the buffer
+    for(i = 0; i < 5; i++){
+        assert(arraydeque_addfirst(&dq, &vals[i]));
+        assert(arraydeque_addlast(&dq, &vals[10 + i]));
+    }
+    assert(dq.size == 16);
+    assert(arraydeque_length(&dq) == 10);
+    assert(arraydeque_peekfirst(&dq) == &vals[4]);
+    assert(arraydeque_peeklast(&dq) == &vals[14]);
+    assert(arraydeque_get(&dq, 4) == &vals[0]);
+    assert(arraydeque_get(&dq, 5) == &vals[10]);
+    assert(arraydeque_get(&dq, 10) == NULL);
+
+    // test growing keeps the order when either run is the shorter one
+    for(i = 5; i < 30; i++){
+        assert(arraydeque_addfirst(&dq, &vals[i]));
+    }
+    for(i = 0; i < 35; i++){
+        assert(*((int*) arraydeque_get(&dq, i)) ==
+               (i < 30 ? 29 - (int) i : 10 + (int) i - 30));
+    }
+    arraydeque_clear(&dq);
+    for(i = 0; i < 60; i++){
+        arraydeque_addlast(&dq, &vals[i]);
+        if(i % 2 == 0){
+            arraydeque_pollfirst(&dq);
+        }
+    }
+    for(i = 0; i < 70; i++){
+        assert(arraydeque_addlast(&dq, &vals[i % 100]));
+    }
+    assert(arraydeque_length(&dq) == 100);
+    for(i = 0; i < 30; i++){
+        assert(arraydeque_get(&dq, i) == &vals[30 + i]);
+    }
+    for(i = 0; i < 70; i++){
+        assert(arraydeque_get(&dq, 30 + i) == &vals[i]);
+    }
+
+    // test bulk add and drain across the end of the buffer
+    arraydeque_clear(&dq);
+    void* ptrs[100];
+    for(i = 0; i < 100; i++){
+        ptrs[i] = &vals[i];
+    }
+    assert(arraydeque_addall(&dq, ptrs, 100));
+    assert(arraydeque_drainto(&dq, out, 90) == 90);
+    assert(out[0] == &vals[0] && out[89] == &vals[89]);
+    assert(arraydeque_addall(&dq, ptrs, 60));
+    assert(dq.head + dq.length > dq.size);
+    assert(arraydeque_length(&dq) == 70);
+    assert(arraydeque_drainto(&dq, out, 100) == 70);
+    for(i = 0; i < 10; i++){
+        assert(out[i] == &vals[90 + i]);
+    }
+    for(i = 0; i < 60; i++){
+        assert(out[10 + i] == &vals[i]);
+    }
+    assert(arraydeque_length(&dq) == 0);
+    assert(arraydeque_drainto(&dq, out, 100) == 0);
+
+    // test the deque works as a stack from the back
+    arraydeque_addlast(&dq, &vals[1]);
+    arraydeque_addlast(&dq, &vals[2]);
+    assert(arraydeque_polllast(&dq) == &vals[2]);
+    assert(arraydeque_polllast(&dq) == &vals[1]);
+    assert(arraydeque_polllast(&dq) == NULL);
+    arraydeque_free(&dq);
+}
+
+void test_segmentedlist(){
+    int vals[10000];
+    size_t i;
+    for(i = 0; i < 10000; i++){
+        vals[i] = (int) i;
+    }
+    segmentedlist_t lst;
+    segmentedlist_init(&lst);
+    assert(segmentedlist_length(&lst) == 0);
+    assert(segmentedlist_get(&lst, 0) == NULL);
+    assert(segmentedlist_removelast(&lst) == NULL);
+
+    // test indices map to consecutive slots across segment boundaries
+    assert(_SL_SEGMENT(0) == 0 && _SL_OFFSET(0, 0) == 0);
+    assert(_SL_SEGMENT(7) == 0 && _SL_OFFSET(7, 0) == 7);
+    assert(_SL_SEGMENT(8) == 1 && _SL_OFFSET(8, 1) == 0);
+    assert(_SL_SEGMENT(23) == 1 && _SL_OFFSET(23, 1) == 15);
+    assert(_SL_SEGMENT(24) == 2 && _SL_OFFSET(24, 2) == 0);
+
+    // test append & get, and that addresses never move
+    assert(segmentedlist_append(&lst, &vals[0]));
+    void** first = segmentedlist_ref(&lst, 0);
+    for(i = 1; i < 10000; i++){
+        assert(segmentedlist_append(&lst, &vals[i]));
+    }
+    assert(segmentedlist_ref(&lst, 0) == first && *first == &vals[0]);
+    assert(segmentedlist_length(&lst) == 10000);
+    assert(lst.size >= 10000 && lst.size < 2*10000 + _SL_FIRSTSEG);
+    for(i = 0; i < 10000; i++){
+        assert(segmentedlist_get(&lst, i) == &vals[i]);
+    }
+    assert(segmentedlist_get(&lst, 10000) == NULL);
+
+    // test set, indexof and toarray
+    segmentedlist_set(&lst, 5000, &vals[1]);
+    assert(segmentedlist_indexof(&lst, &vals[1], cmp_int) == 1);
+    assert(segmentedlist_indexof(&lst, &vals[9999], cmp_int) == 9999);
+    int missing = 5000;
+    assert(segmentedlist_indexof(&lst, &missing, cmp_int) == -1);
+    void** ary = segmentedlist_toarray(&lst);
+    for(i = 0; i < 10000; i++){
+        assert(ary[i] == (i == 5000 ? &vals[1] : &vals[i]));
+    }
+    free(ary);
+
+    // test removelast, clear and reserve keep the segments
+    assert(segmentedlist_removelast(&lst) == &vals[9999]);
+    assert(segmentedlist_length(&lst) == 9999);
+    size_t nsegments = lst.nsegments;
+    segmentedlist_clear(&lst);
+    assert(segmentedlist_length(&lst) == 0 && lst.nsegments == nsegments);
+    assert(segmentedlist_reserve(&lst, 100000));
+    assert(lst.size >= 100000 && segmentedlist_ref(&lst, 0) == first);
+
+    segmentedlist_free(&lst);
+    assert(lst.nsegments == 0 && lst.size == 0);
+}
+
+typedef struct mlrec_t{
+    uint64_t id;
+    double val;
+    char name[16];
+} mlrec_t;
+
+void test_mappedlist(){
+    char path[] = "/tmp/javautil_mappedlist_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    mappedlist_t ml;
+    mlrec_t rec;
+    size_t i;
+
+    // test a new file grows as records are appended
+    assert(mappedlist_open(&ml, path, sizeof(mlrec_t), false));
+    assert(mappedlist_length(&ml) == 0);
+    assert(mappedlist_get(&ml, 0) == NULL);
+    for(i = 0; i < 1000; i++){
+        rec.id = i;
+        rec.val = i/2.0;
+        snprintf(rec.name, sizeof(rec.name), "rec%zu", i);
+        assert(mappedlist_append(&ml, &rec));
+    }
+    assert(mappedlist_length(&ml) == 1000);
+    assert(((mlrec_t*) mappedlist_get(&ml, 999))->id == 999);
+    assert(mappedlist_removelast(&ml, &rec));
+    assert(rec.id == 999);
+    rec.id = 12345;
+    assert(mappedlist_set(&ml, 5, &rec));
+    assert(!mappedlist_set(&ml, 999, &rec));
+    assert(mappedlist_flush(&ml));
+    assert(mappedlist_close(&ml));
+
+    // test the file is truncated to its records
+    struct stat st;
+    assert(stat(path, &st) == 0);
+    assert((size_t) st.st_size == sizeof(_mlheader_t) + 999*sizeof(mlrec_t));
+
+    // test reopening maps the records without copying and refuses writes
+    assert(!mappedlist_open(&ml, path, sizeof(mlrec_t) + 8, true));
+    assert(mappedlist_open(&ml, path, 0, true));
+    assert(mappedlist_recsize(&ml) == sizeof(mlrec_t));
+    assert(mappedlist_length(&ml) == 999);
+    mlrec_t* recs = (mlrec_t*) mappedlist_toarray(&ml);
+    for(i = 0; i < 999; i++){
+        assert(recs[i].id == (i == 5 ? 12345 : i));
+        assert(recs[i].val == (i == 5 ? 999/2.0 : i/2.0));
+    }
+    assert(strcmp(recs[998].name, "rec998") == 0);
+    assert(!mappedlist_append(&ml, &rec));
+    assert(!mappedlist_removelast(&ml, NULL));
+    assert(!mappedlist_clear(&ml));
+
+    // test a writer's changes are seen through a shared read only mapping
+    mappedlist_t writer;
+    assert(mappedlist_open(&writer, path, sizeof(mlrec_t), false));
+    rec.id = 777;
+    assert(mappedlist_set(&writer, 0, &rec));
+    assert(recs[0].id == 777);
+    assert(mappedlist_clear(&writer));
+    assert(mappedlist_length(&ml) == 0);
+
+    // test a reader maps more of the file when a writer grows it past the
+    // reader's mapping, and closing the writer leaves the file whole
+    for(i = 0; i < 100000; i++){
+        rec.id = i;
+        assert(mappedlist_append(&writer, &rec));
+    }
+    assert(mappedlist_get(&ml, 100000) == NULL);
+    assert(((mlrec_t*) mappedlist_get(&ml, 90000))->id == 90000);
+    assert(mappedlist_length(&ml) == 100000);
+    assert(mappedlist_removelast(&writer, NULL));
+    assert(mappedlist_close(&writer));
+    assert(mappedlist_length(&ml) == 99999);
+    recs = (mlrec_t*) mappedlist_toarray(&ml);
+    assert(recs[99998].id == 99998);
+    assert(mappedlist_close(&ml));
+
+    // test the last list to close truncates the file
+    assert(mappedlist_open(&writer, path, sizeof(mlrec_t), false));
+    assert(mappedlist_close(&writer));
+    assert(stat(path, &st) == 0);
+    assert((size_t) st.st_size == sizeof(_mlheader_t) + 99999*sizeof(mlrec_t));
+
+    // test a writer with a smaller mapping never shrinks the file under
+    // another writer that grew it
+    mappedlist_t other;
+    unlink(path);
+    assert(mappedlist_open(&other, path, sizeof(mlrec_t), false));
+    assert(mappedlist_open(&writer, path, sizeof(mlrec_t), false));
+    for(i = 0; i < 1024; i++){
+        rec.id = i;
+        assert(mappedlist_append(&writer, &rec));
+    }
+    while(mappedlist_length(&writer) > 100){
+        assert(mappedlist_removelast(&writer, NULL));
+    }
+    assert(mappedlist_append(&other, &rec));
+    assert(stat(path, &st) == 0);
+    assert((size_t) st.st_size == sizeof(_mlheader_t) + 1024*sizeof(mlrec_t));
+    for(i = 101; i < 1000; i++){
+        rec.id = i;
+        assert(mappedlist_append(&writer, &rec));
+    }
+    assert(((mlrec_t*) mappedlist_get(&writer, 999))->id == 999);
+    assert(mappedlist_close(&other));
+    assert(mappedlist_close(&writer));
+
+    // test files that are not lists are refused
+    fd = open(path, O_WRONLY | O_TRUNC);
+    assert(write(fd, "not a list", 10) == 10);
+    close(fd);
+    assert(!mappedlist_open(&ml, path, sizeof(mlrec_t), false));
+    unlink(path);
+}
+
+size_t hash_int(const void* a){
+    return (size_t) *((const int*) a);
+}
+
+size_t hash_collide(const void* a){
+    return (size_t) (*((const int*) a) % 3);
+}
+
+#define HM_N 10000
+
+void test_hashmap(){
+    int* keys = (int*) malloc(HM_N*sizeof(int));
+    int* other = (int*) malloc(HM_N*sizeof(int));
+    size_t i;
+    for(i = 0; i < HM_N; i++){
+        keys[i] = (int) (i*7919);
+        other[i] = keys[i];
+    }
+
+    // test put and get across many resizes
+    hashmap_t map;
+    assert(hashmap_init(&map, hash_int, cmp_int));
+    assert(hashmap_size(&map) == 0);
+    assert(hashmap_get(&map, &keys[0]) == NULL);
+    for(i = 0; i < HM_N; i++){
+        assert(hashmap_put(&map, &keys[i], &keys[i]));
+    }
+    assert(hashmap_size(&map) == HM_N);
+    assert(map.capacity == 16384);
+    for(i = 0; i < HM_N; i++){
+        assert(hashmap_get(&map, &other[i]) == &keys[i]);
+    }
+    int missing = -1;
+    assert(!hashmap_containskey(&map, &missing));
+
+    // test put replaces the value of an equal key
+    assert(hashmap_put(&map, &other[5], &missing));
+    assert(hashmap_size(&map) == HM_N);
+    assert(hashmap_get(&map, &keys[5]) == &missing);
+
+    // test NULL values are told apart from missing keys
+    assert(hashmap_put(&map, &keys[6], NULL));
+    assert(hashmap_get(&map, &keys[6]) == NULL);
+    assert(hashmap_containskey(&map, &keys[6]));
+
+    // test remove
+    for(i = 0; i < HM_N; i += 2){
+        assert(hashmap_remove(&map, &other[i]) == (i == 6 ? NULL : i == 5 ?
+               (void*) &missing : (void*) &keys[i]));
+    }
+    assert(hashmap_remove(&map, &other[0]) == NULL);
+    assert(hashmap_size(&map) == HM_N/2);
+    for(i = 0; i < HM_N; i++){
+        assert(hashmap_containskey(&map, &keys[i]) == (i % 2 == 1));
+    }
+
+    // test churn reuses deleted slots without growing
+    size_t capacity = map.capacity;
+    size_t round;
+    for(round = 0; round < 20; round++){
+        for(i = 0; i < HM_N; i += 2){
+            assert(hashmap_put(&map, &keys[i], &keys[i]));
+        }
+        for(i = 0; i < HM_N; i += 2){
+            assert(hashmap_remove(&map, &keys[i]) == &keys[i]);
+        }
+    }
+    assert(map.capacity == capacity);
+    assert(hashmap_size(&map) == HM_N/2);
+
+    // test clear and reserve
+    hashmap_clear(&map);
+    assert(hashmap_size(&map) == 0);
+    assert(!hashmap_containskey(&map, &keys[1]));
+    assert(hashmap_reserve(&map, 100000));
+    assert(map.capacity == 131072);
+    hashmap_free(&map);
+
+    // test keys whose hashes collide
+    assert(hashmap_init(&map, hash_collide, cmp_int));
+    for(i = 0; i < 500; i++){
+        assert(hashmap_put(&map, &keys[i], &other[i]));
+    }
+    for(i = 0; i < 500; i++){
+        assert(hashmap_get(&map, &keys[i]) == &other[i]);
+    }
+    assert(hashmap_remove(&map, &keys[250]) == &other[250]);
+    assert(!hashmap_containskey(&map, &keys[250]));
+    assert(hashmap_get(&map, &keys[499]) == &other[499]);
+    hashmap_free(&map);
+    free(other);
+    free(keys);
+}
+
+#define TM_N 5000
+
+void test_treemap(){
+    // Keys are the even numbers 0 to 2*(TM_N - 1), so odd numbers fall
+    // between them
+    int* keys = (int*) malloc(TM_N*sizeof(int));
+    int* probes = (int*) malloc(2*TM_N*sizeof(int));
+    char* present = (char*) calloc(TM_N, 1);
+    size_t i, j;
+    for(i = 0; i < TM_N; i++){
+        keys[i] = (int) (2*i);
+    }
+    for(i = 0; i < 2*TM_N; i++){
+        probes[i] = (int) i - 1;
+    }
+
+    // test an empty map
+    treemap_t map;
+    treemap_iterator_t it;
+    assert(treemap_init(&map, cmp_int));
+    assert(treemap_size(&map) == 0);
+    assert(treemap_get(&map, &keys[0]) == NULL);
+    assert(treemap_firstkey(&map) == NULL && treemap_lastkey(&map) == NULL);
+    assert(treemap_floorkey(&map, &keys[0]) == NULL);
+    assert(treemap_ceilingkey(&map, &keys[0]) == NULL);
+    treemap_iterator(&map, &it, NULL, NULL);
+    assert(!treemap_iterator_hasnext(&it));
+    assert(treemap_iterator_next(&it, NULL) == NULL);
+
+    // test puts in a scrambled order build a valid tree of many levels
+    for(i = 0; i < TM_N; i++){
+        j = (i*7919) % TM_N;
+        assert(treemap_put(&map, &keys[j], &keys[j]));
+        present[j] = 1;
+    }
+    assert(treemap_size(&map) == TM_N);
+    assert(validate_treemap(&map));
+    assert(!map.root->leaf && !((_tminner_t*) map.root)->children[0]->leaf);
+    for(i = 0; i < TM_N; i++){
+        assert(treemap_get(&map, &keys[i]) == &keys[i]);
+        assert(!treemap_containskey(&map, &probes[2*i]));
+    }
+    assert(treemap_firstkey(&map) == &keys[0]);
+    assert(treemap_lastkey(&map) == &keys[TM_N - 1]);
+
+    // test put replaces the value of an equal key
+    int dup = 10;
+    assert(treemap_put(&map, &dup, &keys[0]));
+    assert(treemap_size(&map) == TM_N);
+    assert(treemap_get(&map, &dup) == &keys[0]);
+    assert(treemap_put(&map, &dup, &keys[5]));
+
+    // test removing every third key, with rebalancing down to many leaves
+    for(i = 0; i < TM_N; i += 3){
+        assert(treemap_remove(&map, &keys[i]) == &keys[i]);
+        present[i] = 0;
+    }
+    assert(treemap_remove(&map, &keys[0]) == NULL);
+    assert(treemap_remove(&map, &probes[2]) == NULL);
+    assert(validate_treemap(&map));
+    assert(treemap_size(&map) == TM_N - (TM_N + 2)/3);
+
+    // test floor and ceiling of every key and every gap against a scan
+    for(i = 0; i < 2*TM_N; i++){
+        int* floor = NULL;
+        int* ceiling = NULL;
+        for(j = 0; j < TM_N; j++){
+            if(present[j] && keys[j] <= probes[i]){
+                floor = &keys[j];
+            }
+            if(present[j] && keys[j] >= probes[i] && ceiling == NULL){
+                ceiling = &keys[j];
+            }
+        }
+        assert(treemap_floorkey(&map, &probes[i]) == floor);
+        assert(treemap_ceilingkey(&map, &probes[i]) == ceiling);
+    }
+
+    // test range iterators visit exactly the keys in [lo, hi) in order
+    size_t ranges[][2] = {{0, 2*TM_N - 1}, {1, 2}, {3, 4}, {101, 1999},
+                          {2000, 2000}, {3000, 2500}, {2*TM_N - 3, 2*TM_N - 1}};
+    for(i = 0; i < sizeof(ranges)/sizeof(ranges[0]); i++){
+        const int* lo = &probes[ranges[i][0]];
+        const int* hi = &probes[ranges[i][1]];
+        treemap_iterator(&map, &it, lo, hi);
+        for(j = 0; j < TM_N; j++){
+            if(present[j] && keys[j] >= *lo && keys[j] < *hi){
+                void* key;
+                assert(treemap_iterator_hasnext(&it));
+                assert(treemap_iterator_next(&it, &key) == &keys[j]);
+                assert(key == &keys[j]);
+            }
+        }
+        assert(!treemap_iterator_hasnext(&it));
+    }
+    size_t count = 0;
+    treemap_iterator(&map, &it, NULL, NULL);
+    while(treemap_iterator_hasnext(&it)){
+        treemap_iterator_next(&it, NULL);
+        count++;
+    }
+    assert(count == treemap_size(&map));
+
+    // test removing every key in a scrambled order collapses the tree
+    for(i = 0; i < TM_N; i++){
+        j = (i*4099) % TM_N;
+        assert(treemap_remove(&map, &keys[j]) == (present[j] ? &keys[j] :
+                                                  NULL));
+        present[j] = 0;
+        if(i % 500 == 0){
+            assert(validate_treemap(&map));
+        }
+    }
+    assert(treemap_size(&map) == 0);
+    assert(map.root->leaf);
+    assert(validate_treemap(&map));
+
+    // test clear keeps the map usable
+    for(i = 0; i < TM_N; i++){
+        assert(treemap_put(&map, &keys[i], &keys[i]));
+    }
+    treemap_clear(&map);
+    assert(treemap_size(&map) == 0);
+    assert(validate_treemap(&map));
+    assert(treemap_put(&map, &keys[1], &keys[1]));
+    assert(treemap_firstkey(&map) == &keys[1]);
+    treemap_free(&map);
+
+    // test keys can be freed as soon as they are removed, since no removed key
+    // is left behind as a separator
+    int* owned[TM_N/10];
+    treemap_init(&map, cmp_int);
+    for(i = 0; i < TM_N/10; i++){
+        owned[i] = malloc(sizeof(int));
+        *owned[i] = (int) i;
+        assert(treemap_put(&map, owned[i], owned[i]));
+    }
+    for(i = 0; i < TM_N/10; i += 2){
+        assert(treemap_remove(&map, owned[i]) == owned[i]);
+        free(owned[i]);
+        assert(validate_treemap(&map));
+    }
+    for(i = 1; i < TM_N/10; i += 2){
+        int probe = (int) i;
+        assert(treemap_get(&map, &probe) == owned[i]);
+        assert(treemap_remove(&map, owned[i]) == owned[i]);
+        free(owned[i]);
+    }
+    assert(treemap_size(&map) == 0);
+    treemap_free(&map);
+
+    free(present);
+    free(probes);
+    free(keys);
+}
+
+#define BS_N 3000
+
+void test_bitset(){
+    char* ref_a = (char*) calloc(BS_N, 1);
+    char* ref_b = (char*) calloc(BS_N, 1);
+    size_t i, count;
+    ptrdiff_t ind;
+
+    // test an empty bitset
+    bitset_t a, b;
+    assert(bitset_init(&a));
+    assert(bitset_size(&a) == 64);
+    assert(!bitset_get(&a, 0) && !bitset_get(&a, 1000000));
+    assert(bitset_nextsetbit(&a, 0) == -1);
+    assert(bitset_cardinality(&a) == 0);
+
+    // test indices whose words cannot be allocated are refused, not wrapped
+    assert(!bitset_set(&a, SIZE_MAX));
+    assert(!bitset_reserve(&a, SIZE_MAX));
+    assert(bitset_size(&a) == 64 && bitset_cardinality(&a) == 0);
+    assert(bitset_length(&a) == 0);
+    bitset_clear(&a, 1000000);
+
+    // test set grows the bitset and get, clear and length agree
+    assert(bitset_set(&a, 0));
+    assert(bitset_set(&a, 63));
+    assert(bitset_set(&a, 64));
+    assert(bitset_set(&a, 1000));
+    assert(bitset_size(&a) == 1024);
+    assert(bitset_get(&a, 0) && bitset_get(&a, 63) && bitset_get(&a, 64));
+    assert(!bitset_get(&a, 1) && !bitset_get(&a, 65) && !bitset_get(&a, 999));
+    assert(bitset_length(&a) == 1001);
+    assert(bitset_cardinality(&a) == 4);
+    bitset_clear(&a, 1000);
+    assert(!bitset_get(&a, 1000));
+    assert(bitset_length(&a) == 65);
+    assert(bitset_nextsetbit(&a, 1) == 63);
+    assert(bitset_nextsetbit(&a, 65) == -1);
+    bitset_clearall(&a);
+    assert(bitset_cardinality(&a) == 0 && bitset_size(&a) == 1024);
+
+    // test nextsetbit and cardinality against a scan, past the vector tails
+    assert(bitset_init(&b));
+    for(i = 0; i < BS_N; i++){
+        ref_a[i] = (i*7919) % 5 < 2;
+        ref_b[i] = i < BS_N/2 && (i*104729) % 3 == 0;
+        if(ref_a[i]){
+            assert(bitset_set(&a, i));
+        }
+        if(ref_b[i]){
+            assert(bitset_set(&b, i));
+        }
+    }
+    count = 0;
+    i = 0;
+    for(ind = bitset_nextsetbit(&a, 0); ind >= 0;
+        ind = bitset_nextsetbit(&a, ind + 1)){
+        while(!ref_a[i]){
+            i++;
+        }
+        assert((size_t) ind == i++);
+        count++;
+    }
+    assert(bitset_cardinality(&a) == count);
+
+    // test the bulk operations against the scans, with a shorter other set
+    bitset_t c;
+    assert(bitset_init(&c));
+    assert(bitset_or(&c, &a));
+    bitset_and(&c, &b);
+    for(i = 0; i < BS_N; i++){
+        assert(bitset_get(&c, i) == (ref_a[i] && ref_b[i]));
+    }
+    assert(bitset_or(&c, &a));
+    assert(bitset_or(&c, &b));
+    for(i = 0; i < BS_N; i++){
+        assert(bitset_get(&c, i) == (ref_a[i] || ref_b[i]));
+    }
+    bitset_andnot(&c, &b);
+    for(i = 0; i < BS_N; i++){
+        assert(bitset_get(&c, i) == (ref_a[i] && !ref_b[i]));
+    }
+    bitset_clearall(&c);
+    assert(bitset_xor(&c, &b));
+    assert(bitset_xor(&c, &a));
+    count = 0;
+    for(i = 0; i < BS_N; i++){
+        assert(bitset_get(&c, i) == (ref_a[i] != ref_b[i]));
+        count += ref_a[i] != ref_b[i];
+    }
+    assert(bitset_cardinality(&c) == count);
+
+    // test or only grows to the highest set bit of the other set
+    bitset_t d;
+    assert(bitset_init(&d));
+    assert(bitset_reserve(&b, 100000));
+    assert(bitset_or(&d, &b));
+    assert(bitset_size(&d) < bitset_size(&b));
+    assert(bitset_length(&d) == bitset_length(&b));
+
+    bitset_free(&d);
+    bitset_free(&c);
+    bitset_free(&b);
+    bitset_free(&a);
+    free(ref_b);
+    free(ref_a);
+}
+
 void test_linkedlist(){
     // test init and length
     linkedlist_t* lst = (linkedlist_t*) malloc(sizeof(linkedlist_t));
@@ -92,6 +1176,430 @@ void test_linkedlist(){
     free(lst);
 }
 
+void test_linkedlist_deque(){
+    int vals[100];
+    size_t i;
+    bool deque;
+    for(i = 0; i < 100; i++){
+        vals[i] = (int) i;
+    }
+    for(deque = false; ; deque = true){
+        linkedlist_t lst;
+        if(deque){
+            linkedlist_init_deque(&lst);
+        }
+        else{
+            linkedlist_init(&lst);
+        }
+        assert(linkedlist_pollfirst(&lst) == NULL);
+        assert(linkedlist_polllast(&lst) == NULL);
+        assert(linkedlist_peekfirst(&lst) == NULL);
+
+        // test addlast and addfirst build 0..99 in order
+        for(i = 50; i < 100; i++){
+            assert(linkedlist_addlast(&lst, &vals[i]));
+        }
+        for(i = 50; i > 0; i--){
+            assert(linkedlist_addfirst(&lst, &vals[i - 1]));
+        }
+        assert(linkedlist_length(&lst) == 100);
+        assert(linkedlist_peekfirst(&lst) == &vals[0]);
+        assert(linkedlist_peeklast(&lst) == &vals[99]);
+        for(i = 0; i < 100; i++){
+            assert(linkedlist_get(&lst, i) == &vals[i]);
+        }
+        assert(linkedlist_get(&lst, 100) == NULL);
+        void** ary = linkedlist_toarray(&lst);
+        for(i = 0; i < 100; i++){
+            assert(ary[i] == &vals[i]);
+        }
+        free(ary);
+
+        // test removing from both ends keeps the tail valid
+        assert(linkedlist_pollfirst(&lst) == &vals[0]);
+        assert(linkedlist_polllast(&lst) == &vals[99]);
+        assert(linkedlist_removelast(&lst) == &vals[98]);
+        assert(linkedlist_removefirst(&lst) == &vals[1]);
+        assert(linkedlist_remove(&lst, linkedlist_length(&lst) - 1) ==
+               &vals[97]);
+        assert(linkedlist_peeklast(&lst) == &vals[96]);
+        assert(linkedlist_append(&lst, &vals[99]));
+        assert(linkedlist_peeklast(&lst) == &vals[99]);
+        assert(linkedlist_get(&lst, linkedlist_length(&lst) - 2) == &vals[96]);
+
+        // test positional add and out of range indices
+        assert(linkedlist_add(&lst, 1, &vals[0]));
+        assert(linkedlist_get(&lst, 1) == &vals[0]);
+        assert(linkedlist_get(&lst, 2) == &vals[3]);
+        assert(!linkedlist_add(&lst, linkedlist_length(&lst) + 1, &vals[0]));
+        assert(linkedlist_add(&lst, linkedlist_length(&lst), &vals[1]));
+        assert(linkedlist_peeklast(&lst) == &vals[1]);
+        assert(linkedlist_remove(&lst, linkedlist_length(&lst)) == NULL);
+
+        // test draining from the back
+        size_t len = linkedlist_length(&lst);
+        for(i = 0; i < len; i++){
+            assert(linkedlist_polllast(&lst) != NULL);
+        }
+        assert(linkedlist_length(&lst) == 0);
+        assert(lst.start == NULL && lst.end == NULL);
+        linkedlist_free(&lst);
+        if(deque){
+            break;
+        }
+    }
+}
+
+void test_linkedlist_pool(){
+    int vals[3000];
+    size_t i, round;
+    for(i = 0; i < 3000; i++){
+        vals[i] = (int) i;
+    }
+
+    // test a private pool recycles nodes and is released in bulk
+    linkedlist_t lst;
+    linkedlist_init(&lst);
+    assert(linkedlist_setpool(&lst, NULL));
+    assert(lst.ownpool && lst.pool->nodesize == sizeof(_llnode_t));
+    for(round = 0; round < 3; round++){
+        for(i = 0; i < 3000; i++){
+            assert(linkedlist_append(&lst, &vals[i]));
+        }
+        assert(linkedlist_get(&lst, 2999) == &vals[2999]);
+        assert(!linkedlist_setpool(&lst, NULL));
+        for(i = 0; i < 3000; i++){
+            assert(linkedlist_pollfirst(&lst) == &vals[i]);
+        }
+    }
+    assert(lst.pool->allocs == 9000 && lst.pool->frees == 9000);
+    assert(lst.pool->slabcount == 3);
+    assert(linkedlist_pool_hitrate(lst.pool) > 0.99);
+    assert(linkedlist_append(&lst, &vals[0]));
+    linkedlist_free(&lst);
+    assert(lst.pool == NULL && !lst.ownpool);
+
+    // test lists of both kinds share a pool and give nodes back on free
+    linkedlist_pool_t pool;
+    assert(linkedlist_pool_init(&pool, false));
+    assert(linkedlist_pool_hitrate(&pool) == 0);
+    linkedlist_t a, b;
+    linkedlist_init(&a);
+    linkedlist_init_deque(&b);
+    assert(linkedlist_setpool(&a, &pool));
+    assert(linkedlist_setpool(&b, &pool));
+    for(i = 0; i < 1000; i++){
+        assert(linkedlist_addfirst(&a, &vals[i]));
+        assert(linkedlist_addlast(&b, &vals[i]));
+    }
+    assert(linkedlist_polllast(&b) == &vals[999]);
+    assert(linkedlist_get(&a, 0) == &vals[999]);
+    linkedlist_free(&a);
+    assert(pool.allocs == 2000 && pool.frees == 1001);
+    for(i = 0; i < 1000; i++){
+        assert(linkedlist_addlast(&a, &vals[i]));
+    }
+    assert(pool.slabcount == 2);
+    linkedlist_free(&a);
+    linkedlist_free(&b);
+    assert(pool.frees == pool.allocs);
+    linkedlist_pool_free(&pool);
+}
+
+static void sum_int(void* data, void* arg){
+    *((int*) arg) += *((int*) data);
+}
+
+static bool is_odd(const void* data, void* arg){
+    (void) arg;
+    return *((const int*) data) % 2 != 0;
+}
+
+void test_linkedlist_iterator(){
+    int vals[200];
+    size_t i;
+    bool deque;
+    for(i = 0; i < 200; i++){
+        vals[i] = (int) i;
+    }
+    for(deque = false; ; deque = true){
+        linkedlist_t lst;
+        linkedlist_iterator_t it;
+        if(deque){
+            linkedlist_init_deque(&lst);
+        }
+        else{
+            linkedlist_init(&lst);
+        }
+
+        // test an empty list has nothing to visit or remove
+        linkedlist_iterator(&lst, &it);
+        assert(!linkedlist_iterator_hasnext(&it));
+        assert(linkedlist_iterator_next(&it) == NULL);
+        assert(!linkedlist_iterator_remove(&it));
+        assert(!linkedlist_iterator_set(&it, &vals[0]));
+
+        // test add at the cursor builds the list in order
+        for(i = 0; i < 100; i++){
+            assert(linkedlist_iterator_add(&it, &vals[i]));
+            assert(linkedlist_iterator_nextindex(&it) == i + 1);
+        }
+        assert(!linkedlist_iterator_hasnext(&it));
+        assert(!linkedlist_iterator_remove(&it));
+        assert(linkedlist_length(&lst) == 100);
+        assert(linkedlist_peeklast(&lst) == &vals[99]);
+        for(i = 0; i < 100; i++){
+            assert(linkedlist_get(&lst, i) == &vals[i]);
+        }
+
+        // test traversal visits every element in order
+        int sum = 0;
+        linkedlist_iterator(&lst, &it);
+        for(i = 0; linkedlist_iterator_hasnext(&it); i++){
+            assert(linkedlist_iterator_nextindex(&it) == i);
+            assert(linkedlist_iterator_next(&it) == &vals[i]);
+        }
+        assert(i == 100 && linkedlist_iterator_nextindex(&it) == 100);
+        linkedlist_foreach(&lst, sum_int, &sum);
+        assert(sum == 99*100/2);
+
+        // test removing every other element, then once more is refused
+        linkedlist_iterator(&lst, &it);
+        for(i = 0; linkedlist_iterator_hasnext(&it); i++){
+            assert(linkedlist_iterator_next(&it) == &vals[i]);
+            if(i % 2 == 0){
+                assert(linkedlist_iterator_remove(&it));
+                assert(!linkedlist_iterator_remove(&it));
+                assert(!linkedlist_iterator_set(&it, &vals[0]));
+            }
+        }
+        assert(linkedlist_length(&lst) == 50);
+        assert(linkedlist_peekfirst(&lst) == &vals[1]);
+        assert(linkedlist_peeklast(&lst) == &vals[99]);
+        for(i = 0; i < 50; i++){
+            assert(linkedlist_get(&lst, i) == &vals[2*i + 1]);
+        }
+
+        // test set replaces and add inserts behind the cursor, then removing
+        // the last element keeps the tail valid
+        linkedlist_iterator(&lst, &it);
+        assert(linkedlist_iterator_next(&it) == &vals[1]);
+        assert(linkedlist_iterator_set(&it, &vals[101]));
+        assert(linkedlist_iterator_add(&it, &vals[102]));
+        assert(!linkedlist_iterator_set(&it, &vals[0]));
+        assert(linkedlist_iterator_next(&it) == &vals[3]);
+        assert(linkedlist_get(&lst, 0) == &vals[101]);
+        assert(linkedlist_get(&lst, 1) == &vals[102]);
+        assert(linkedlist_get(&lst, 2) == &vals[3]);
+        while(linkedlist_iterator_hasnext(&it)){
+            linkedlist_iterator_next(&it);
+        }
+        assert(linkedlist_iterator_remove(&it));
+        assert(linkedlist_peeklast(&lst) == &vals[97]);
+        assert(linkedlist_iterator_add(&it, &vals[199]));
+        assert(linkedlist_peeklast(&lst) == &vals[199]);
+        assert(linkedlist_length(&lst) == 51);
+        if(deque){
+            assert(linkedlist_polllast(&lst) == &vals[199]);
+            assert(linkedlist_polllast(&lst) == &vals[97]);
+            assert(linkedlist_addlast(&lst, &vals[97]));
+        }
+        else{
+            assert(linkedlist_remove(&lst, 50) == &vals[199]);
+        }
+
+        // test the iterator fails fast after a change it did not make
+        linkedlist_iterator(&lst, &it);
+        assert(linkedlist_iterator_next(&it) == &vals[101]);
+        assert(linkedlist_append(&lst, &vals[150]));
+        assert(!linkedlist_iterator_isvalid(&it));
+        assert(!linkedlist_iterator_hasnext(&it));
+        assert(linkedlist_iterator_next(&it) == NULL);
+        assert(!linkedlist_iterator_remove(&it));
+        assert(!linkedlist_iterator_add(&it, &vals[0]));
+        assert(!linkedlist_iterator_set(&it, &vals[0]));
+        assert(linkedlist_length(&lst) == 51);
+
+        // test removeif drops the odd values in one pass
+        assert(linkedlist_removeif(&lst, is_odd, NULL) == 49);
+        assert(linkedlist_length(&lst) == 2);
+        assert(linkedlist_peekfirst(&lst) == &vals[102]);
+        assert(linkedlist_peeklast(&lst) == &vals[150]);
+        assert(linkedlist_removeif(&lst, is_odd, NULL) == 0);
+        linkedlist_free(&lst);
+        linkedlist_iterator(&lst, &it);
+        assert(!linkedlist_iterator_hasnext(&it));
+        if(deque){
+            break;
+        }
+    }
+}
+
+#define POOL_THREADS 4
+#define POOL_PER_THREAD 10000
+
+static void* pool_worker(void* arg){
+    linkedlist_pool_t* pool = (linkedlist_pool_t*) arg;
+    linkedlist_t lst;
+    size_t i, round;
+    linkedlist_init_deque(&lst);
+    linkedlist_setpool(&lst, pool);
+    for(round = 0; round < 4; round++){
+        for(i = 0; i < POOL_PER_THREAD; i++){
+            assert(linkedlist_addlast(&lst, (void*) (uintptr_t) i));
+        }
+        for(i = 0; i < POOL_PER_THREAD/2; i++){
+            assert(linkedlist_pollfirst(&lst) == (void*) (uintptr_t) i);
+        }
+        linkedlist_free(&lst);
+    }
+    linkedlist_pool_flushcache(pool);
+    return NULL;
+}
+
+static void* pool_freer(void* arg){
+    linkedlist_pool_free((linkedlist_pool_t*) arg);
+    free(arg);
+    return NULL;
+}
+
+void test_linkedlist_pool_threadsafe(){
+    linkedlist_pool_t pool;
+    assert(linkedlist_pool_init(&pool, true));
+    pthread_t threads[POOL_THREADS];
+    size_t t;
+
+    // test concurrent lists on one pool, every node is accounted for
+    for(t = 0; t < POOL_THREADS; t++){
+        pthread_create(&threads[t], NULL, pool_worker, &pool);
+    }
+    for(t = 0; t < POOL_THREADS; t++){
+        pthread_join(threads[t], NULL);
+    }
+    assert(pool.allocs == 4*POOL_THREADS*POOL_PER_THREAD);
+    assert(pool.frees == pool.allocs);
+    assert(pool.cachehits > pool.allocs/2);
+    assert(linkedlist_pool_hitrate(&pool) > 0.9);
+    linkedlist_pool_free(&pool);
+
+    // test a thread alternating between two pools gives its cached nodes back
+    // on every switch instead of stranding them
+    linkedlist_pool_t p1, p2;
+    linkedlist_t l1, l2;
+    size_t i;
+    assert(linkedlist_pool_init(&p1, true));
+    assert(linkedlist_pool_init(&p2, true));
+    linkedlist_init(&l1);
+    linkedlist_init(&l2);
+    assert(linkedlist_setpool(&l1, &p1));
+    assert(linkedlist_setpool(&l2, &p2));
+    for(i = 0; i < 100000; i++){
+        assert(linkedlist_append(&l1, (void*) (uintptr_t) i));
+        assert(linkedlist_pollfirst(&l1) == (void*) (uintptr_t) i);
+        assert(linkedlist_append(&l2, (void*) (uintptr_t) i));
+        assert(linkedlist_pollfirst(&l2) == (void*) (uintptr_t) i);
+    }
+    assert(p1.slabcount == 1 && p2.slabcount == 1);
+    linkedlist_pool_flushcache(&p2);
+    assert(p1.allocs == 100000 && p1.frees == p1.allocs);
+    assert(p2.allocs == 100000 && p2.frees == p2.allocs);
+    linkedlist_free(&l1);
+    linkedlist_free(&l2);
+    linkedlist_pool_free(&p1);
+    linkedlist_pool_free(&p2);
+
+    // test a pool flushed here and freed by another thread is never touched
+    // again when this thread moves on to a new pool
+    linkedlist_pool_t* shared = malloc(sizeof(linkedlist_pool_t));
+    assert(shared != NULL && linkedlist_pool_init(shared, true));
+    assert(linkedlist_pool_init(&p1, true));
+    assert(linkedlist_setpool(&l1, shared));
+    assert(linkedlist_append(&l1, &pool));
+    linkedlist_free(&l1);
+    linkedlist_pool_flushcache(shared);
+    assert(shared->frees == shared->allocs);
+    pthread_t freer;
+    pthread_create(&freer, NULL, pool_freer, shared);
+    pthread_join(freer, NULL);
+    linkedlist_init(&l1);
+    assert(linkedlist_setpool(&l1, &p1));
+    assert(linkedlist_append(&l1, &pool));
+    linkedlist_free(&l1);
+    linkedlist_pool_free(&p1);
+}
+
+void test_unrolledlist(){
+    int vals[1000];
+    size_t i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) i;
+    }
+    unrolledlist_t lst;
+    unrolledlist_init(&lst);
+    assert(unrolledlist_length(&lst) == 0);
+    assert(unrolledlist_get(&lst, 0) == NULL);
+    assert(unrolledlist_remove(&lst, 0) == NULL);
+
+    // test appends fill whole nodes
+    for(i = 0; i < 500; i++){
+        assert(unrolledlist_append(&lst, &vals[2*i]));
+    }
+    assert(unrolledlist_length(&lst) == 500);
+    assert(lst.start->count == _UL_NODECAP);
+    assert(unrolledlist_get(&lst, 499) == &vals[998]);
+
+    // test adds into full nodes split them and keep the order
+    for(i = 0; i < 500; i++){
+        assert(unrolledlist_add(&lst, 2*i + 1, &vals[2*i + 1]));
+    }
+    assert(!unrolledlist_add(&lst, 1001, &vals[0]));
+    assert(unrolledlist_length(&lst) == 1000);
+    for(i = 0; i < 1000; i++){
+        assert(unrolledlist_get(&lst, i) == &vals[i]);
+    }
+    void** ary = unrolledlist_toarray(&lst);
+    for(i = 0; i < 1000; i++){
+        assert(ary[i] == &vals[i]);
+    }
+    free(ary);
+
+    // test indexof
+    int key = 737;
+    assert(unrolledlist_indexof(&lst, &key, cmp_int) == 737);
+    key = 1000;
+    assert(unrolledlist_indexof(&lst, &key, cmp_int) == -1);
+
+    // test removes merge nodes and keep them at least half full
+    for(i = 0; i < 500; i++){
+        assert(unrolledlist_remove(&lst, i + 1) == &vals[2*i + 1]);
+    }
+    assert(unrolledlist_length(&lst) == 500);
+    size_t total = 0;
+    _ulnode_t* node;
+    for(node = lst.start; node != NULL; node = node->next){
+        assert(node->count >= _UL_NODECAP/2 || node == lst.end);
+        total += node->count;
+        assert(node->next != NULL || node == lst.end);
+    }
+    assert(total == 500);
+    for(i = 0; i < 500; i++){
+        assert(unrolledlist_get(&lst, i) == &vals[2*i]);
+    }
+
+    // test draining from both ends and appending afterwards
+    for(i = 0; i < 250; i++){
+        assert(unrolledlist_remove(&lst, unrolledlist_length(&lst) - 1) ==
+               &vals[998 - 2*i]);
+        assert(unrolledlist_remove(&lst, 0) == &vals[2*i]);
+    }
+    assert(lst.start == NULL && lst.end == NULL);
+    assert(unrolledlist_append(&lst, &vals[1]));
+    assert(unrolledlist_add(&lst, 0, &vals[0]));
+    assert(unrolledlist_get(&lst, 1) == &vals[1]);
+    unrolledlist_free(&lst);
+    assert(unrolledlist_length(&lst) == 0);
+}
+
 void test_priorityqueue(){
     // test init and length
     priorityqueue_t* pq = (priorityqueue_t*) malloc(sizeof(priorityqueue_t));
@@ -138,17 +1646,849 @@ void test_priorityqueue(){
     free(pq);
 }
 
+void test_priorityqueue_arity(){
+    int vals[1000];
+    size_t arities[3] = {2, 4, 8};
+    size_t a, i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) ((i*7919) % 1000);
+    }
+    for(a = 0; a < 3; a++){
+        priorityqueue_t pq;
+        assert(priorityqueue_init_arity(&pq, cmp_int, arities[a]));
+        assert(pq.arity == arities[a]);
+
+        // test add and alignment of child groups to cache lines
+        for(i = 0; i < 1000; i++){
+            assert(priorityqueue_add(&pq, &vals[i]));
+        }
+        assert(priorityqueue_size(&pq) == 1000);
+        assert(validate_heap(&pq));
+        for(i = 0; i < 10; i++){
+            uintptr_t child = (uintptr_t) &pq.data[_PQ_CHILD(i, pq.arity)];
+            assert(child % (pq.arity*sizeof(void*)) == 0);
+        }
+
+        // test remove keeps the heap valid
+        int v = 500;
+        assert(priorityqueue_remove(&pq, &v));
+        assert(!priorityqueue_contains(&pq, &v));
+        assert(validate_heap(&pq));
+
+        // test poll returns elements in order
+        int prev = -1;
+        for(i = 0; i < 999; i++){
+            int cur = *((int*) priorityqueue_poll(&pq));
+            assert(cur > prev);
+            prev = cur;
+        }
+        assert(priorityqueue_poll(&pq) == NULL);
+        assert(priorityqueue_peek(&pq) == NULL);
+        priorityqueue_free(&pq);
+    }
+    priorityqueue_t pq;
+    assert(!priorityqueue_init_arity(&pq, cmp_int, 1));
+    assert(!priorityqueue_init_arity(&pq, cmp_int,
+                                     priorityqueue_max_arity + 1));
+}
+
+void test_priorityqueue_heapify(){
+    size_t n = 10000;
+    int* vals = (int*) malloc(n*sizeof(int));
+    void** ary = (void**) malloc(n*sizeof(void*));
+    size_t i;
+    for(i = 0; i < n; i++){
+        vals[i] = (int) (n - i);
+        ary[i] = &vals[i];
+    }
+
+    // test init from array heapifies in a linear number of comparisons
+    priorityqueue_t pq;
+    cmp_count = 0;
+    assert(priorityqueue_init_from_array(&pq, cmp_int_counted, ary, n));
+    assert(cmp_count < 3*n);
+    assert(priorityqueue_size(&pq) == n);
+    assert(priorityqueue_toarray(&pq) == ary);
+    assert(validate_heap(&pq));
+    assert(*((int*) priorityqueue_peek(&pq)) == 1);
+
+    // test the adopted array can grow
+    int extra = 0;
+    assert(priorityqueue_add(&pq, &extra));
+    assert(*((int*) priorityqueue_peek(&pq)) == 0);
+    assert(validate_heap(&pq));
+
+    // test large and small batches added to a non-empty queue
+    void* batch[100];
+    int more[100];
+    for(i = 0; i < 100; i++){
+        more[i] = -((int) i);
+        batch[i] = &more[i];
+    }
+    assert(priorityqueue_addall(&pq, batch, 10));
+    assert(validate_heap(&pq));
+    priorityqueue_t small;
+    priorityqueue_init_arity(&small, cmp_int, 4);
+    priorityqueue_add(&small, &vals[0]);
+    priorityqueue_add(&small, &vals[1]);
+    assert(priorityqueue_addall(&small, batch, 100));
+    assert(priorityqueue_size(&small) == 102);
+    assert(validate_heap(&small));
+    assert(*((int*) priorityqueue_poll(&small)) == -99);
+    priorityqueue_free(&small);
+
+    int prev = *((int*) priorityqueue_poll(&pq));
+    while(priorityqueue_size(&pq) > 0){
+        int cur = *((int*) priorityqueue_poll(&pq));
+        assert(cur >= prev);
+        prev = cur;
+    }
+    priorityqueue_free(&pq);
+    free(vals);
+}
+
+void test_priorityqueue_indexed(){
+    priorityqueue_t pq;
+    int vals[100];
+    priorityqueue_handle_t handles[100];
+    size_t i;
+    assert(priorityqueue_init_indexed(&pq, cmp_int, 4));
+
+    // test handles of added elements
+    for(i = 0; i < 100; i++){
+        vals[i] = (int) ((i*37) % 100);
+        assert(priorityqueue_add_handle(&pq, &vals[i], &handles[i]));
+    }
+    assert(priorityqueue_size(&pq) == 100);
+    assert(validate_heap(&pq));
+    for(i = 0; i < 100; i++){
+        assert(priorityqueue_contains_handle(&pq, handles[i]));
+        assert(priorityqueue_get_handle(&pq, handles[i]) == &vals[i]);
+    }
+
+    // test remove by handle
+    assert(priorityqueue_remove_handle(&pq, handles[10]) == &vals[10]);
+    assert(!priorityqueue_contains_handle(&pq, handles[10]));
+    assert(priorityqueue_remove_handle(&pq, handles[10]) == NULL);
+    assert(priorityqueue_size(&pq) == 99);
+    assert(validate_heap(&pq));
+
+    // test decrease and update key in place
+    vals[50] = -1;
+    assert(priorityqueue_decrease_key(&pq, handles[50], &vals[50]));
+    assert(priorityqueue_peek(&pq) == &vals[50]);
+    vals[50] = 1000;
+    assert(priorityqueue_update_key(&pq, handles[50], &vals[50]));
+    assert(priorityqueue_peek(&pq) != &vals[50]);
+    assert(validate_heap(&pq));
+    assert(!priorityqueue_update_key(&pq, handles[10], &vals[10]));
+
+    // test poll releases handles, which are reused and stay consistent
+    void* min = priorityqueue_poll(&pq);
+    size_t polled = (size_t) ((int*) min - vals);
+    assert(!priorityqueue_contains_handle(&pq, handles[polled]));
+    priorityqueue_handle_t h;
+    assert(priorityqueue_add_handle(&pq, &vals[10], &h));
+    assert(h == handles[10] || h == handles[polled]);
+    for(i = 0; i < 100; i++){
+        if(i != polled && i != 10){
+            assert(priorityqueue_get_handle(&pq, handles[i]) == &vals[i]);
+        }
+    }
+    assert(priorityqueue_get_handle(&pq, h) == &vals[10]);
+
+    // test clear releases every handle
+    priorityqueue_clear(&pq);
+    assert(!priorityqueue_contains_handle(&pq, h));
+    assert(priorityqueue_add_handle(&pq, &vals[0], &h));
+    assert(priorityqueue_get_handle(&pq, h) == &vals[0]);
+    priorityqueue_free(&pq);
+
+    // test handles are unavailable on a plain queue
+    priorityqueue_init(&pq, cmp_int);
+    assert(!priorityqueue_add_handle(&pq, &vals[0], &h));
+    assert(!priorityqueue_contains_handle(&pq, 0));
+    priorityqueue_free(&pq);
+}
+
+int snapshot_pool[2000];
+size_t snapshot_used = 0;
+
+void encode_int(const void* elem, void* buf){
+    memcpy(buf, elem, sizeof(int));
+}
+
+void* decode_int(const void* buf){
+    int* elem = &snapshot_pool[snapshot_used++];
+    memcpy(elem, buf, sizeof(int));
+    return elem;
+}
+
+int cmp_int_reverse(const void* a, const void* b){
+    return cmp_int(b, a);
+}
+
+void test_priorityqueue_snapshot(){
+    int vals[1000];
+    size_t i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) ((i*7919) % 1000);
+    }
+    priorityqueue_t pq, restored;
+    priorityqueue_init_arity(&pq, cmp_int, 4);
+    for(i = 0; i < 1000; i++){
+        priorityqueue_add(&pq, &vals[i]);
+    }
+    for(i = 0; i < 100; i++){
+        priorityqueue_poll(&pq);
+    }
+
+    // test a restored queue holds the same heap without comparing anything
+    FILE* f = tmpfile();
+    assert(priorityqueue_snapshot(&pq, f, sizeof(int), encode_int));
+    long end = ftell(f);
+    rewind(f);
+    cmp_count = 0;
+    assert(priorityqueue_restore(&restored, cmp_int_counted, f, decode_int));
+    assert(cmp_count == restored.length - 1); // validate_heap only
+    assert(restored.arity == 4);
+    assert(priorityqueue_size(&restored) == 900);
+    for(i = 0; i < 900; i++){
+        assert(*((int*) restored.data[i]) == *((int*) pq.data[i]));
+    }
+    for(i = 100; i < 1000; i++){
+        assert(*((int*) priorityqueue_poll(&restored)) == (int) i);
+    }
+    priorityqueue_free(&restored);
+
+    // test a comparator that disagrees with the heap order is caught
+    rewind(f);
+    snapshot_used = 0;
+    assert(!priorityqueue_restore(&restored, cmp_int_reverse, f, decode_int));
+
+    // test truncated and foreign streams are refused
+    fflush(f);
+    assert(ftruncate(fileno(f), end - 1) == 0);
+    rewind(f);
+    snapshot_used = 0;
+    assert(!priorityqueue_restore(&restored, cmp_int, f, decode_int));
+    rewind(f);
+    fputs("not a snapshot of a priority queue", f);
+    rewind(f);
+    assert(!priorityqueue_restore(&restored, cmp_int, f, decode_int));
+
+    // test an empty queue round trips
+    rewind(f);
+    priorityqueue_clear(&pq);
+    assert(priorityqueue_snapshot(&pq, f, sizeof(int), encode_int));
+    rewind(f);
+    assert(priorityqueue_restore(&restored, cmp_int, f, decode_int));
+    assert(priorityqueue_size(&restored) == 0);
+    priorityqueue_free(&restored);
+
+    // test a snapshot claiming an arity too large to allocate is refused
+    uint64_t arity = (uint64_t) 1 << 62;
+    assert(fseek(f, sizeof(uint64_t), SEEK_SET) == 0);
+    assert(fwrite(&arity, sizeof(arity), 1, f) == 1);
+    rewind(f);
+    assert(!priorityqueue_restore(&restored, cmp_int, f, decode_int));
+    fclose(f);
+    priorityqueue_free(&pq);
+}
+
+void test_keyedpriorityqueue(){
+    // test init and size
+    keyedpriorityqueue_t kpq;
+    assert(keyedpriorityqueue_init(&kpq));
+    assert(keyedpriorityqueue_size(&kpq) == 0);
+    assert(keyedpriorityqueue_poll(&kpq, NULL) == NULL);
+
+    // test add & peek
+    int vals[1000];
+    size_t i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) ((i*7919) % 1000);
+        assert(keyedpriorityqueue_add(&kpq, (uint64_t) vals[i], &vals[i]));
+    }
+    assert(keyedpriorityqueue_size(&kpq) == 1000);
+    assert(validate_keyedheap(&kpq));
+    uint64_t key;
+    assert(*((int*) keyedpriorityqueue_peek(&kpq, &key)) == 0);
+    assert(key == 0);
+
+    // test child groups of keys are cache line aligned
+    assert((uintptr_t) &kpq.keys[_PQ_CHILD(0, 8)] % 64 == 0);
+
+    // test poll returns elements in key order
+    for(i = 0; i < 1000; i++){
+        int* elem = (int*) keyedpriorityqueue_poll(&kpq, &key);
+        assert(key == i && *elem == (int) i);
+    }
+    assert(keyedpriorityqueue_size(&kpq) == 0);
+
+    // test large keys, where the sign bit matters for the vector compare
+    uint64_t big[20];
+    for(i = 0; i < 20; i++){
+        big[i] = (i % 2 ? UINT64_MAX - i : (uint64_t) 1 << 63) + i;
+        keyedpriorityqueue_add(&kpq, big[i], &big[i]);
+    }
+    uint64_t prev = 0;
+    for(i = 0; i < 20; i++){
+        keyedpriorityqueue_poll(&kpq, &key);
+        assert(key >= prev);
+        prev = key;
+    }
+
+    // test double keys keep their order
+    double ds[5] = {3.5, -1.0, 0.0, -7.25, 2.0};
+    for(i = 0; i < 5; i++){
+        keyedpriorityqueue_add(&kpq, keyedpriorityqueue_key_double(ds[i]),
+                               &ds[i]);
+    }
+    assert(keyedpriorityqueue_poll(&kpq, &key) == &ds[3]);
+    assert(keyedpriorityqueue_double_key(key) == -7.25);
+    assert(keyedpriorityqueue_poll(&kpq, NULL) == &ds[1]);
+    assert(keyedpriorityqueue_poll(&kpq, NULL) == &ds[2]);
+
+    // test NaNs of either sign order after +infinity
+    uint64_t nanbits = 0xfff8000000000001ull;
+    double negnan, inf = 1.0/0.0;
+    memcpy(&negnan, &nanbits, sizeof(negnan));
+    assert(keyedpriorityqueue_key_double(negnan) >
+           keyedpriorityqueue_key_double(inf));
+    assert(keyedpriorityqueue_key_double(negnan) ==
+           keyedpriorityqueue_key_double(-negnan));
+    double back = keyedpriorityqueue_double_key(
+        keyedpriorityqueue_key_double(negnan));
+    assert(back != back);
+
+    // test clear and free
+    keyedpriorityqueue_clear(&kpq);
+    assert(keyedpriorityqueue_size(&kpq) == 0);
+    keyedpriorityqueue_free(&kpq);
+}
+
+void test_radixheap(){
+    // test init and size
+    radixheap_t rh;
+    assert(radixheap_init(&rh));
+    assert(radixheap_size(&rh) == 0);
+    assert(radixheap_poll(&rh, NULL) == NULL);
+
+    // test add & peek
+    int vals[1000];
+    size_t i;
+    for(i = 0; i < 1000; i++){
+        vals[i] = (int) ((i*7919) % 1000);
+        assert(radixheap_add(&rh, (uint64_t) vals[i], &vals[i]));
+    }
+    assert(radixheap_size(&rh) == 1000);
+    uint64_t key;
+    assert(*((int*) radixheap_peek(&rh, &key)) == 0);
+    assert(key == 0);
+
+    // test poll returns keys in order, interleaved with monotone adds
+    for(i = 0; i < 500; i++){
+        int* elem = (int*) radixheap_poll(&rh, &key);
+        assert(key == i && *elem == (int) i);
+    }
+    assert(!radixheap_add(&rh, 10, &vals[0]));
+    assert(radixheap_add(&rh, 500, &vals[0]));
+    assert(radixheap_add(&rh, UINT64_MAX, &vals[1]));
+    uint64_t prev = 500;
+    for(i = 0; i < 501; i++){
+        radixheap_poll(&rh, &key);
+        assert(key >= prev);
+        prev = key;
+    }
+    assert(radixheap_poll(&rh, &key) == &vals[1]);
+    assert(key == UINT64_MAX);
+    assert(radixheap_size(&rh) == 0);
+
+    // test clear allows small keys again
+    radixheap_clear(&rh);
+    assert(radixheap_add(&rh, 0, &vals[0]));
+    assert(radixheap_poll(&rh, NULL) == &vals[0]);
+    radixheap_free(&rh);
+}
+
+#define CPQ_THREADS 4
+#define CPQ_PER_THREAD 20000
+
+typedef struct cpq_worker_t{
+    concurrentpriorityqueue_t* cpq;
+    int* vals;      // Values this thread adds
+    int** polled;   // Elements this thread polled
+    size_t npolled;
+} cpq_worker_t;
+
+void* cpq_worker(void* arg){
+    cpq_worker_t* w = (cpq_worker_t*) arg;
+    size_t i;
+    for(i = 0; i < CPQ_PER_THREAD; i++){
+        assert(concurrentpriorityqueue_add(w->cpq, &w->vals[i]));
+        if(i % 2 == 1){
+            int* elem = (int*) concurrentpriorityqueue_poll(w->cpq);
+            if(elem != NULL){
+                w->polled[w->npolled++] = elem;
+            }
+        }
+    }
+    return NULL;
+}
+
+void test_concurrentpriorityqueue_stress(bool strict){
+    concurrentpriorityqueue_t cpq;
+    assert(concurrentpriorityqueue_init(&cpq, cmp_int, CPQ_THREADS, strict));
+    int* vals = (int*) malloc(CPQ_THREADS*CPQ_PER_THREAD*sizeof(int));
+    int** polled = (int**) malloc(CPQ_THREADS*CPQ_PER_THREAD*sizeof(int*));
+    char* seen = (char*) calloc(CPQ_THREADS*CPQ_PER_THREAD, 1);
+    cpq_worker_t workers[CPQ_THREADS];
+    pthread_t threads[CPQ_THREADS];
+    size_t i, t;
+    for(i = 0; i < CPQ_THREADS*CPQ_PER_THREAD; i++){
+        vals[i] = (int) i;
+    }
+
+    // test concurrent adds and polls lose and duplicate nothing
+    for(t = 0; t < CPQ_THREADS; t++){
+        workers[t].cpq = &cpq;
+        workers[t].vals = &vals[t*CPQ_PER_THREAD];
+        workers[t].polled = &polled[t*CPQ_PER_THREAD];
+        workers[t].npolled = 0;
+        pthread_create(&threads[t], NULL, cpq_worker, &workers[t]);
+    }
+    size_t total = 0;
+    for(t = 0; t < CPQ_THREADS; t++){
+        pthread_join(threads[t], NULL);
+        for(i = 0; i < workers[t].npolled; i++){
+            size_t v = (size_t) *workers[t].polled[i];
+            assert(!seen[v]);
+            seen[v] = 1;
+        }
+        total += workers[t].npolled;
+    }
+    assert(concurrentpriorityqueue_size(&cpq) == CPQ_THREADS*CPQ_PER_THREAD -
+                                                 total);
+
+    // test draining returns every remaining element, in order when strict
+    int* elem;
+    int prev = -1;
+    while((elem = (int*) concurrentpriorityqueue_poll(&cpq)) != NULL){
+        assert(!seen[*elem]);
+        seen[*elem] = 1;
+        assert(!strict || *elem > prev);
+        prev = *elem;
+        total++;
+    }
+    assert(total == CPQ_THREADS*CPQ_PER_THREAD);
+    assert(concurrentpriorityqueue_size(&cpq) == 0);
+
+    concurrentpriorityqueue_free(&cpq);
+    free(seen);
+    free(polled);
+    free(vals);
+}
+
+#define CQ_PRODUCERS 3
+#define CQ_CONSUMERS 3
+#define CQ_PER_THREAD 50000
+#define CQ_CAPACITY 64
+#define CQ_BATCH 16
+
+typedef struct cq_worker_t{
+    void* q;              // spscqueue_t or mpmcqueue_t
+    size_t id;            // Producer number, values start at id*CQ_PER_THREAD
+    atomic_size_t* taken; // # of elements taken by all consumers
+    size_t count;         // # of elements this consumer took
+    uint64_t sum;         // Sum of the values this consumer took
+} cq_worker_t;
+
+// Elements are the integers 1 to CQ_PRODUCERS*CQ_PER_THREAD cast to pointers
+void* spsc_producer(void* arg){
+    cq_worker_t* w = (cq_worker_t*) arg;
+    void* batch[CQ_BATCH];
+    size_t i = 0, j;
+    while(i < CQ_PER_THREAD){
+        size_t len = i % CQ_BATCH + 1;
+        len = len < CQ_PER_THREAD - i ? len : CQ_PER_THREAD - i;
+        for(j = 0; j < len; j++){
+            batch[j] = (void*) (uintptr_t) (i + j + 1);
+        }
+        if(len == 1){
+            while(!spscqueue_offer((spscqueue_t*) w->q, batch[0])){
+                sched_yield();
+            }
+            i++;
+            continue;
+        }
+        for(j = 0; j < len; ){
+            size_t n = spscqueue_offerall((spscqueue_t*) w->q, batch + j,
+                                          len - j);
+            if(n == 0){
+                sched_yield();
+            }
+            j += n;
+        }
+        i += len;
+    }
+    return NULL;
+}
+
+void* mpmc_producer(void* arg){
+    cq_worker_t* w = (cq_worker_t*) arg;
+    void* batch[CQ_BATCH];
+    size_t base = w->id*CQ_PER_THREAD + 1;
+    size_t i = 0, j;
+    while(i < CQ_PER_THREAD){
+        if(i % 2 == 0){
+            while(!mpmcqueue_offer((mpmcqueue_t*) w->q,
+                                   (void*) (uintptr_t) (base + i))){
+                sched_yield();
+            }
+            i++;
+            continue;
+        }
+        size_t len = i % CQ_BATCH + 1;
+        len = len < CQ_PER_THREAD - i ? len : CQ_PER_THREAD - i;
+        for(j = 0; j < len; j++){
+            batch[j] = (void*) (uintptr_t) (base + i + j);
+        }
+        for(j = 0; j < len; ){
+            size_t n = mpmcqueue_offerall((mpmcqueue_t*) w->q, batch + j,
+                                          len - j);
+            if(n == 0){
+                sched_yield();
+            }
+            j += n;
+        }
+        i += len;
+    }
+    return NULL;
+}
+
+void* mpmc_consumer(void* arg){
+    cq_worker_t* w = (cq_worker_t*) arg;
+    const size_t total = CQ_PRODUCERS*CQ_PER_THREAD;
+    size_t last[CQ_PRODUCERS] = {0};
+    void* batch[CQ_BATCH];
+    size_t i, n;
+    while(atomic_load(w->taken) < total){
+        if(w->count % 2 == 0){
+            batch[0] = mpmcqueue_poll((mpmcqueue_t*) w->q);
+            n = batch[0] != NULL;
+        }
+        else{
+            n = mpmcqueue_drainto((mpmcqueue_t*) w->q, batch, CQ_BATCH);
+        }
+        if(n == 0){
+            sched_yield();
+            continue;
+        }
+        atomic_fetch_add(w->taken, n);
+        for(i = 0; i < n; i++){
+            // Elements of one producer arrive at one consumer in order
+            size_t v = (size_t) (uintptr_t) batch[i];
+            size_t p = (v - 1)/CQ_PER_THREAD;
+            assert(p < CQ_PRODUCERS && v > last[p]);
+            last[p] = v;
+            w->sum += v;
+        }
+        w->count += n;
+    }
+    return NULL;
+}
+
+void test_concurrentqueue(){
+    int vals[8];
+    void* ary[16];
+    size_t i;
+
+    // test spscqueue rounds its capacity up and is FIFO across the wrap
+    spscqueue_t sq;
+    assert(spscqueue_init(&sq, 5));
+    assert(spscqueue_capacity(&sq) == 8);
+    assert(spscqueue_poll(&sq) == NULL);
+    assert(spscqueue_drainto(&sq, ary, 16) == 0);
+    for(i = 0; i < 8; i++){
+        assert(spscqueue_offer(&sq, &vals[i]));
+    }
+    assert(!spscqueue_offer(&sq, &vals[0]));
+    assert(spscqueue_size(&sq) == 8);
+    for(i = 0; i < 3; i++){
+        assert(spscqueue_poll(&sq) == &vals[i]);
+    }
+    for(i = 0; i < 5; i++){
+        ary[i] = &vals[i];
+    }
+    assert(spscqueue_offerall(&sq, ary, 5) == 3);
+    assert(spscqueue_offerall(&sq, ary, 5) == 0);
+    assert(spscqueue_drainto(&sq, ary, 16) == 8);
+    for(i = 0; i < 8; i++){
+        assert(ary[i] == &vals[i < 5 ? i + 3 : i - 5]);
+    }
+    assert(spscqueue_size(&sq) == 0);
+    spscqueue_free(&sq);
+
+    // test mpmcqueue the same way
+    mpmcqueue_t mq;
+    assert(mpmcqueue_init(&mq, 5));
+    assert(mpmcqueue_capacity(&mq) == 8);
+    assert(mpmcqueue_poll(&mq) == NULL);
+    assert(mpmcqueue_drainto(&mq, ary, 16) == 0);
+    for(i = 0; i < 8; i++){
+        assert(mpmcqueue_offer(&mq, &vals[i]));
+    }
+    assert(!mpmcqueue_offer(&mq, &vals[0]));
+    assert(mpmcqueue_size(&mq) == 8);
+    for(i = 0; i < 3; i++){
+        assert(mpmcqueue_poll(&mq) == &vals[i]);
+    }
+    for(i = 0; i < 5; i++){
+        ary[i] = &vals[i];
+    }
+    assert(mpmcqueue_offerall(&mq, ary, 5) == 3);
+    assert(mpmcqueue_offerall(&mq, ary, 5) == 0);
+    assert(mpmcqueue_drainto(&mq, ary, 2) == 2);
+    assert(mpmcqueue_drainto(&mq, ary + 2, 16) == 6);
+    for(i = 0; i < 8; i++){
+        assert(ary[i] == &vals[i < 5 ? i + 3 : i - 5]);
+    }
+    assert(mpmcqueue_size(&mq) == 0);
+    mpmcqueue_free(&mq);
+}
+
+void test_concurrentqueue_stress(){
+    pthread_t threads[CQ_PRODUCERS + CQ_CONSUMERS];
+    cq_worker_t workers[CQ_PRODUCERS + CQ_CONSUMERS];
+    atomic_size_t taken;
+    void* batch[CQ_BATCH];
+    size_t i, t, n;
+
+    // test a producer thread's elements reach the consumer once and in order
+    spscqueue_t sq;
+    assert(spscqueue_init(&sq, CQ_CAPACITY));
+    workers[0].q = &sq;
+    pthread_create(&threads[0], NULL, spsc_producer, &workers[0]);
+    size_t next = 1;
+    while(next <= CQ_PER_THREAD){
+        if(next % 2 == 0){
+            batch[0] = spscqueue_poll(&sq);
+            n = batch[0] != NULL;
+        }
+        else{
+            n = spscqueue_drainto(&sq, batch, CQ_BATCH);
+        }
+        if(n == 0){
+            sched_yield();
+        }
+        for(i = 0; i < n; i++){
+            assert((size_t) (uintptr_t) batch[i] == next++);
+        }
+    }
+    pthread_join(threads[0], NULL);
+    assert(spscqueue_poll(&sq) == NULL);
+    spscqueue_free(&sq);
+
+    // test many producers and consumers lose and duplicate nothing
+    mpmcqueue_t mq;
+    assert(mpmcqueue_init(&mq, CQ_CAPACITY));
+    atomic_init(&taken, 0);
+    for(t = 0; t < CQ_PRODUCERS + CQ_CONSUMERS; t++){
+        workers[t].q = &mq;
+        workers[t].id = t;
+        workers[t].taken = &taken;
+        workers[t].count = 0;
+        workers[t].sum = 0;
+        pthread_create(&threads[t], NULL, t < CQ_PRODUCERS ? mpmc_producer :
+                       mpmc_consumer, &workers[t]);
+    }
+    size_t count = 0;
+    uint64_t sum = 0;
+    for(t = 0; t < CQ_PRODUCERS + CQ_CONSUMERS; t++){
+        pthread_join(threads[t], NULL);
+        count += workers[t].count;
+        sum += workers[t].sum;
+    }
+    n = CQ_PRODUCERS*CQ_PER_THREAD;
+    assert(count == n);
+    assert(sum == (uint64_t) n*(n + 1)/2);
+    assert(mpmcqueue_size(&mq) == 0);
+    mpmcqueue_free(&mq);
+}
+
+#ifdef JAVAUTIL_STATS
+#define STATS_ON 1
+#else
+#define STATS_ON 0
+#endif
+
+#define STATS_N 100
+
+void test_stats(){
+    int vals[STATS_N];
+    size_t i;
+    for(i = 0; i < STATS_N; i++){
+        vals[i] = (int) ((i*37) % STATS_N);
+    }
+    javautil_stats_t st;
+
+    // test arraylist counts reallocs, shifts and comparisons
+    arraylist_t lst;
+    arraylist_init(&lst);
+    for(i = 0; i < STATS_N; i++){
+        arraylist_append(&lst, &vals[i]);
+    }
+    arraylist_stats(&lst, &st);
+    assert(st.reallocs == STATS_ON*4);
+    assert(st.bytes == STATS_ON*(8 + 16 + 32 + 64 + 128)*sizeof(void*));
+    assert(st.highwater == STATS_ON*STATS_N);
+    assert(st.moves == 0);
+    arraylist_add(&lst, 0, &vals[0]);
+    arraylist_remove(&lst, 0);
+    arraylist_stats(&lst, &st);
+    assert(st.moves == STATS_ON*2*STATS_N);
+    assert(st.highwater == STATS_ON*(STATS_N + 1));
+
+    arraylist_resetstats(&lst);
+    cmp_count = 0;
+    assert(arraylist_indexof(&lst, &vals[STATS_N - 1], cmp_int_counted) ==
+           STATS_N - 1);
+    arraylist_sort(&lst, cmp_int_counted);
+    assert(arraylist_binarysearch(&lst, &vals[5], cmp_int_counted) ==
+           vals[5]);
+    arraylist_stats(&lst, &st);
+    assert(st.cmps == STATS_ON*cmp_count);
+    assert(st.highwater == STATS_ON*STATS_N);
+    assert(st.reallocs == 0 && st.moves == 0);
+    arraylist_free(&lst);
+
+    // test linkedlist counts node mallocs and the nodes walked
+    linkedlist_t ll;
+    linkedlist_init(&ll);
+    for(i = 0; i < STATS_N; i++){
+        linkedlist_append(&ll, &vals[i]);
+    }
+    linkedlist_get(&ll, 10);
+    cmp_count = 0;
+    assert(linkedlist_indexof(&ll, &vals[20], cmp_int_counted) == 20);
+    linkedlist_stats(&ll, &st);
+    assert(st.nodes == STATS_ON*STATS_N);
+    assert(st.bytes == STATS_ON*STATS_N*sizeof(_llnode_t));
+    assert(st.highwater == STATS_ON*STATS_N);
+    assert(st.steps == STATS_ON*(10 + 20));
+    assert(st.cmps == STATS_ON*cmp_count);
+    linkedlist_resetstats(&ll);
+    linkedlist_stats(&ll, &st);
+    assert(st.nodes == 0 && st.steps == 0);
+    linkedlist_free(&ll);
+
+    // test priorityqueue counts comparisons and sift depths
+    priorityqueue_t pq;
+    cmp_count = 0;
+    priorityqueue_init(&pq, cmp_int_counted);
+    for(i = 0; i < STATS_N; i++){
+        priorityqueue_add(&pq, &vals[i]);
+    }
+    while(priorityqueue_poll(&pq) != NULL);
+    priorityqueue_stats(&pq, &st);
+    assert(st.cmps == STATS_ON*cmp_count);
+    assert(st.sifts == STATS_ON*(2*STATS_N - 1));
+    assert(STATS_ON ? st.maxsift > 0 && st.maxsift <= 6 : st.maxsift == 0);
+    assert(st.siftlevels <= st.sifts*6);
+    assert(st.reallocs == STATS_ON*3);
+    assert(st.moves == st.siftlevels + STATS_ON*(16 + 32 + 64));
+    assert(st.highwater == STATS_ON*STATS_N);
+    priorityqueue_resetstats(&pq);
+    priorityqueue_stats(&pq, &st);
+    assert(st.cmps == 0 && st.highwater == 0);
+    priorityqueue_free(&pq);
+}
+
 int main(int argc, char const *argv[]){
+    printf("Testing threadpool\n");
+    test_threadpool();
+    printf("Threadpool passed tests\n");
+
+    printf("Testing allocator\n");
+    test_allocator();
+    printf("Allocator passed tests\n");
+
     printf("Testing arraylist\n");
     test_arraylist();
+    test_arraylist_gapbuffer();
+    test_arraylist_sort();
+    test_arraylist_search();
     printf("Arraylist passed tests\n");
 
+    printf("Testing arraylist template\n");
+    test_arraylist_template();
+    printf("Arraylist template passed tests\n");
+
+    printf("Testing arraydeque\n");
+    test_arraydeque();
+    printf("Arraydeque passed tests\n");
+
+    printf("Testing segmentedlist\n");
+    test_segmentedlist();
+    printf("Segmentedlist passed tests\n");
+
+    printf("Testing mappedlist\n");
+    test_mappedlist();
+    printf("Mappedlist passed tests\n");
+
+    printf("Testing hashmap\n");
+    test_hashmap();
+    printf("Hashmap passed tests\n");
+
+    printf("Testing treemap\n");
+    test_treemap();
+    printf("Treemap passed tests\n");
+
+    printf("Testing bitset\n");
+    test_bitset();
+    printf("Bitset passed tests\n");
+
     printf("Testing linkedlist\n");
     test_linkedlist();
+    test_linkedlist_deque();
+    test_linkedlist_iterator();
+    test_linkedlist_pool();
+    test_linkedlist_pool_threadsafe();
     printf("Linkedlist passed tests\n");
 
+    printf("Testing unrolledlist\n");
+    test_unrolledlist();
+    printf("Unrolledlist passed tests\n");
+
     printf("Testing priorityqueue\n");
     test_priorityqueue();
+    test_priorityqueue_arity();
+    test_priorityqueue_heapify();
+    test_priorityqueue_indexed();
+    test_priorityqueue_snapshot();
     printf("Priorityqueue passed tests\n");
+
+    printf("Testing keyedpriorityqueue\n");
+    test_keyedpriorityqueue();
+    printf("Keyedpriorityqueue passed tests\n");
+
+    printf("Testing radixheap\n");
+    test_radixheap();
+    printf("Radixheap passed tests\n");
+
+    printf("Testing concurrentpriorityqueue\n");
+    test_concurrentpriorityqueue_stress(true);
+    test_concurrentpriorityqueue_stress(false);
+    printf("Concurrentpriorityqueue passed tests\n");
+
+    printf("Testing concurrentqueue\n");
+    test_concurrentqueue();
+    test_concurrentqueue_stress();
+    printf("Concurrentqueue passed tests\n");
+
+    printf("Testing stats\n");
+    test_stats();
+    printf("Stats passed tests\n");
     return 0;
 }
@@ -0,0 +1,308 @@
+/*
+ c work stealing thread pool
+*/
+#include <stdint.h>
+#include <sched.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+const size_t threadpool_deque_initsize = 64;
+
+// The pool and deque of the current thread. Threads outside any pool use
+// deque 0 of whichever pool they fork into
+static _Thread_local threadpool_t* _tp_self = NULL;
+static _Thread_local size_t _tp_index = 0;
+static _Thread_local uint64_t _tp_seed = 0;
+
+static threadpool_t _tp_default;
+static bool _tp_default_ok = false;
+static pthread_once_t _tp_default_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Returns the deque the calling thread pushes to and pops from
+ */
+static inline size_t _tp_own(const threadpool_t* pool){
+    return _tp_self == pool ? _tp_index : 0;
+}
+
+/**
+ * Append a task to the newest end of a deque, growing it if full
+ */
+static bool _tp_push(_tpdeque_t* dq, threadpool_task_t* task){
+    pthread_mutex_lock(&dq->lock);
+    if(dq->length == dq->size){
+        size_t size = dq->size*2;
+        threadpool_task_t** tasks = (threadpool_task_t**)
+                                    malloc(size*sizeof(threadpool_task_t*));
+        if(tasks == NULL){
+            pthread_mutex_unlock(&dq->lock);
+            return false;
+        }
+        size_t i;
+        for(i = 0; i < dq->length; i++){
+            tasks[i] = dq->tasks[(dq->head + i) % dq->size];
+        }
+        free(dq->tasks);
+        dq->tasks = tasks;
+        dq->head = 0;
+        dq->size = size;
+    }
+    dq->tasks[(dq->head + dq->length) % dq->size] = task;
+    dq->length++;
+    pthread_mutex_unlock(&dq->lock);
+    return true;
+}
+
+/**
+ * Take the newest task of a deque if newest, otherwise the oldest
+ * @return  The task, or NULL if the deque was empty
+ */
+static threadpool_task_t* _tp_take(_tpdeque_t* dq, bool newest){
+    threadpool_task_t* task = NULL;
+    pthread_mutex_lock(&dq->lock);
+    if(dq->length > 0){
+        dq->length--;
+        if(newest){
+            task = dq->tasks[(dq->head + dq->length) % dq->size];
+        }
+        else{
+            task = dq->tasks[dq->head];
+            dq->head = (dq->head + 1) % dq->size;
+        }
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return task;
+}
+
+/**
+ * Find a queued task, first in the calling thread's own deque and then by
+ * stealing from the other deques starting at a random one
+ * @return  The task, or NULL if no task was found
+ */
+static threadpool_task_t* _tp_find(threadpool_t* pool){
+    if(atomic_load_explicit(&pool->pending, memory_order_acquire) == 0){
+        return NULL;
+    }
+    size_t ndeques = pool->nthreads + 1;
+    size_t own = _tp_own(pool);
+    threadpool_task_t* task = _tp_take(&pool->deques[own], true);
+    if(task == NULL){
+        if(_tp_seed == 0){
+            _tp_seed = (uint64_t) (uintptr_t) &_tp_seed | 1;
+        }
+        _tp_seed ^= _tp_seed << 13;
+        _tp_seed ^= _tp_seed >> 7;
+        _tp_seed ^= _tp_seed << 17;
+        size_t start = (size_t) (_tp_seed % ndeques);
+        size_t i;
+        for(i = 0; i < ndeques && task == NULL; i++){
+            size_t victim = (start + i) % ndeques;
+            if(victim != own){
+                task = _tp_take(&pool->deques[victim], false);
+            }
+        }
+    }
+    if(task != NULL){
+        atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+/**
+ * Run a task and mark it done
+ */
+static void _tp_run(threadpool_task_t* task){
+    task->fn(task->arg);
+    atomic_store_explicit(&task->done, true, memory_order_release);
+}
+
+typedef struct _tpstart_t _tpstart_t;
+struct _tpstart_t{
+    threadpool_t* pool; // The pool the worker belongs to
+    size_t index;       // The worker's deque
+};
+
+/**
+ * Worker loop: run tasks until the pool is stopped, sleeping while idle
+ */
+static void* _tp_worker(void* arg){
+    _tpstart_t* start = (_tpstart_t*) arg;
+    threadpool_t* pool = start->pool;
+    _tp_self = pool;
+    _tp_index = start->index;
+    free(start);
+    while(!atomic_load_explicit(&pool->stop, memory_order_acquire)){
+        threadpool_task_t* task = _tp_find(pool);
+        if(task != NULL){
+            _tp_run(task);
+            continue;
+        }
+        pthread_mutex_lock(&pool->idlelock);
+        while(atomic_load(&pool->pending) == 0 && !atomic_load(&pool->stop)){
+            pthread_cond_wait(&pool->idle, &pool->idlelock);
+        }
+        pthread_mutex_unlock(&pool->idlelock);
+    }
+    return NULL;
+}
+
+/**
+ * Stop and join the first n workers of a pool and free its deques
+ */
+static void _tp_shutdown(threadpool_t* pool, size_t n){
+    pthread_mutex_lock(&pool->idlelock);
+    atomic_store(&pool->stop, true);
+    pthread_cond_broadcast(&pool->idle);
+    pthread_mutex_unlock(&pool->idlelock);
+    size_t i;
+    for(i = 0; i < n; i++){
+        pthread_join(pool->threads[i], NULL);
+    }
+    for(i = 0; i <= pool->nthreads; i++){
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    free(pool->deques);
+    free(pool->threads);
+    pthread_cond_destroy(&pool->idle);
+    pthread_mutex_destroy(&pool->idlelock);
+}
+
+/**
+ * Start a thread pool
+ * @param pool      The pool to initialize
+ * @param nthreads  The number of worker threads, or 0 for one less than the
+ *                  number of online processors since the thread that joins
+ *                  tasks also runs them
+ * @return  t/f depending on the successful allocation of the deques and the
+ *          creation of the threads
+ */
+bool threadpool_init(threadpool_t* pool, size_t nthreads){
+    if(nthreads == 0){
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = cpus > 1 ? (size_t) cpus - 1 : 0;
+    }
+    pool->nthreads = nthreads;
+    atomic_init(&pool->pending, 0);
+    atomic_init(&pool->stop, false);
+    pool->threads = (pthread_t*) malloc((nthreads + 1)*sizeof(pthread_t));
+    pool->deques = (_tpdeque_t*) aligned_alloc(_Alignof(_tpdeque_t),
+                                               (nthreads + 1)*
+                                               sizeof(_tpdeque_t));
+    if(pool->threads == NULL || pool->deques == NULL){
+        free(pool->threads);
+        free(pool->deques);
+        return false;
+    }
+    pthread_mutex_init(&pool->idlelock, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    size_t i;
+    for(i = 0; i <= nthreads; i++){
+        _tpdeque_t* dq = &pool->deques[i];
+        pthread_mutex_init(&dq->lock, NULL);
+        dq->tasks = (threadpool_task_t**)
+                    malloc(threadpool_deque_initsize*sizeof(threadpool_task_t*));
+        dq->head = 0;
+        dq->length = 0;
+        dq->size = threadpool_deque_initsize;
+        if(dq->tasks == NULL){
+            pool->nthreads = i;
+            _tp_shutdown(pool, 0);
+            return false;
+        }
+    }
+    for(i = 0; i < nthreads; i++){
+        _tpstart_t* start = (_tpstart_t*) malloc(sizeof(_tpstart_t));
+        if(start != NULL){
+            start->pool = pool;
+            start->index = i + 1;
+        }
+        if(start == NULL ||
+           pthread_create(&pool->threads[i], NULL, _tp_worker, start) != 0){
+            free(start);
+            _tp_shutdown(pool, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Stop the workers of a thread pool and release its memory
+ * <p>
+ * Every forked task must have been joined before the pool is freed
+ * @param pool  The pool to free
+ */
+void threadpool_free(threadpool_t* pool){
+    _tp_shutdown(pool, pool->nthreads);
+}
+
+static void _tp_default_init(void){
+    _tp_default_ok = threadpool_init(&_tp_default, 0);
+}
+
+/**
+ * Returns a pool shared by the whole process with one worker per processor
+ * besides the caller, starting it on first use. The pool is never freed
+ * @return  The shared pool, or NULL if it could not be started
+ */
+threadpool_t* threadpool_default(void){
+    pthread_once(&_tp_default_once, _tp_default_init);
+    return _tp_default_ok ? &_tp_default : NULL;
+}
+
+/**
+ * Returns the number of threads that can run tasks at once, counting the
+ * thread that joins them
+ * @param pool  The pool
+ * @return  The number of workers plus one
+ */
+size_t threadpool_parallelism(const threadpool_t* pool){
+    return pool->nthreads + 1;
+}
+
+/**
+ * Queue a task to run fn(arg) on any thread of the pool
+ * <p>
+ * The task must stay valid until it has been joined. If the task cannot be
+ * queued it is run immediately by the calling thread
+ * @param pool  The pool to run the task on
+ * @param task  Storage for the task, usually on the caller's stack
+ * @param fn    The work to run
+ * @param arg   The argument passed to fn
+ * @return  t/f depending on whether the task was queued rather than run
+ */
+bool threadpool_fork(threadpool_t* pool, threadpool_task_t* task,
+                     void (*fn)(void*), void* arg){
+    task->fn = fn;
+    task->arg = arg;
+    atomic_init(&task->done, false);
+    // Counted before it is visible so that pending never drops below zero
+    atomic_fetch_add_explicit(&pool->pending, 1, memory_order_relaxed);
+    if(!_tp_push(&pool->deques[_tp_own(pool)], task)){
+        atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_relaxed);
+        _tp_run(task);
+        return false;
+    }
+    pthread_mutex_lock(&pool->idlelock);
+    pthread_cond_signal(&pool->idle);
+    pthread_mutex_unlock(&pool->idlelock);
+    return true;
+}
+
+/**
+ * Wait for a forked task to finish, running queued tasks in the meantime
+ * @param pool  The pool the task was forked on
+ * @param task  The task to wait for
+ */
+void threadpool_join(threadpool_t* pool, threadpool_task_t* task){
+    while(!atomic_load_explicit(&task->done, memory_order_acquire)){
+        threadpool_task_t* other = _tp_find(pool);
+        if(other != NULL){
+            _tp_run(other);
+        }
+        else{
+            sched_yield();
+        }
+    }
+}
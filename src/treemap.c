@@ -0,0 +1,694 @@
+/*
+ c ordered map structure in a B+-tree
+*/
+#include <string.h>
+#include "treemap.h"
+
+#define _TM_LEAF(n) ((_tmleaf_t*) (n))
+#define _TM_INNER(n) ((_tminner_t*) (n))
+
+/**
+ * Binary search a node for a key
+ * @param found  Set to whether the node contains the key
+ * @return  The position of the key in the node if found, otherwise the
+ *          position of the first larger key
+ */
+static size_t _tm_search(const treemap_t* map, const _tmnode_t* node,
+                         const void* key, bool* found){
+    size_t lo = 0, hi = node->length;
+    while(lo < hi){
+        size_t mid = lo + (hi - lo)/2;
+        int c = map->cmp(node->keys[mid], key);
+        if(c == 0){
+            // Keys are unique, so every key before mid is smaller
+            *found = true;
+            return mid;
+        }
+        if(c < 0){
+            lo = mid + 1;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    *found = false;
+    return lo;
+}
+
+/**
+ * Returns the leaf whose range of keys contains key
+ */
+static _tmleaf_t* _tm_findleaf(const treemap_t* map, const void* key){
+    const _tmnode_t* node = map->root;
+    while(!node->leaf){
+        bool found;
+        size_t i = _tm_search(map, node, key, &found);
+        node = _TM_INNER(node)->children[i + found];
+    }
+    return _TM_LEAF(node);
+}
+
+/**
+ * Returns the position of the first key not less than key as a leaf and an
+ * index in it. A position past the end of a leaf is moved to the start of the
+ * next leaf, so every position has a single representation
+ */
+static void _tm_position(const treemap_t* map, const void* key,
+                         _tmleaf_t** leaf, size_t* index){
+    bool found;
+    _tmleaf_t* l = _tm_findleaf(map, key);
+    size_t i = _tm_search(map, &l->node, key, &found);
+    if(i == l->node.length && l->next != NULL){
+        l = l->next;
+        i = 0;
+    }
+    *leaf = l;
+    *index = i;
+}
+
+static _tmleaf_t* _tm_newleaf(void){
+    _tmleaf_t* leaf = (_tmleaf_t*) malloc(sizeof(_tmleaf_t));
+    if(leaf != NULL){
+        leaf->node.length = 0;
+        leaf->node.leaf = true;
+        leaf->prev = NULL;
+        leaf->next = NULL;
+    }
+    return leaf;
+}
+
+static _tminner_t* _tm_newinner(void){
+    _tminner_t* inner = (_tminner_t*) malloc(sizeof(_tminner_t));
+    if(inner != NULL){
+        inner->node.length = 0;
+        inner->node.leaf = false;
+    }
+    return inner;
+}
+
+/**
+ * Free a subtree, except for the node keep
+ */
+static void _tm_freenode(_tmnode_t* node, const _tmnode_t* keep){
+    if(!node->leaf){
+        size_t i;
+        for(i = 0; i <= node->length; i++){
+            _tm_freenode(_TM_INNER(node)->children[i], keep);
+        }
+    }
+    if(node != keep){
+        free(node);
+    }
+}
+
+/**
+ * Split the full child at position i of an inner node into two halves
+ * <p>
+ * A leaf keeps all of its keys and copies the least key of its right half up
+ * as the separator, while an inner node moves its middle key up
+ * @param parent  An inner node with room for one more key
+ * @return  t/f depending on the successful allocation of the new node
+ */
+static bool _tm_split(treemap_t* map, _tminner_t* parent, size_t i){
+    _tmnode_t* child = parent->children[i];
+    const size_t half = _TM_ORDER/2;
+    _tmnode_t* right;
+    void* upkey;
+    if(child->leaf){
+        _tmleaf_t* l = _TM_LEAF(child);
+        _tmleaf_t* r = _tm_newleaf();
+        if(r == NULL){
+            return false;
+        }
+        r->node.length = _TM_ORDER - half;
+        memcpy(r->node.keys, l->node.keys + half,
+               r->node.length*sizeof(void*));
+        memcpy(r->values, l->values + half, r->node.length*sizeof(void*));
+        r->prev = l;
+        r->next = l->next;
+        if(l->next != NULL){
+            l->next->prev = r;
+        }
+        else{
+            map->last = r;
+        }
+        l->next = r;
+        upkey = r->node.keys[0];
+        right = &r->node;
+    }
+    else{
+        _tminner_t* l = _TM_INNER(child);
+        _tminner_t* r = _tm_newinner();
+        if(r == NULL){
+            return false;
+        }
+        r->node.length = _TM_ORDER - half - 1;
+        memcpy(r->node.keys, l->node.keys + half + 1,
+               r->node.length*sizeof(void*));
+        memcpy(r->children, l->children + half + 1,
+               (r->node.length + 1)*sizeof(_tmnode_t*));
+        upkey = l->node.keys[half];
+        right = &r->node;
+    }
+    child->length = half;
+    size_t len = parent->node.length;
+    memmove(parent->node.keys + i + 1, parent->node.keys + i,
+            (len - i)*sizeof(void*));
+    memmove(parent->children + i + 2, parent->children + i + 1,
+            (len - i)*sizeof(_tmnode_t*));
+    parent->node.keys[i] = upkey;
+    parent->children[i + 1] = right;
+    parent->node.length++;
+    return true;
+}
+
+/**
+ * Move the last entry of the child left of position i to the child at i
+ */
+static void _tm_borrowleft(_tminner_t* parent, size_t i){
+    _tmnode_t* c = parent->children[i];
+    _tmnode_t* l = parent->children[i - 1];
+    memmove(c->keys + 1, c->keys, c->length*sizeof(void*));
+    if(c->leaf){
+        memmove(_TM_LEAF(c)->values + 1, _TM_LEAF(c)->values,
+                c->length*sizeof(void*));
+        c->keys[0] = l->keys[l->length - 1];
+        _TM_LEAF(c)->values[0] = _TM_LEAF(l)->values[l->length - 1];
+        parent->node.keys[i - 1] = c->keys[0];
+    }
+    else{
+        memmove(_TM_INNER(c)->children + 1, _TM_INNER(c)->children,
+                (c->length + 1)*sizeof(_tmnode_t*));
+        c->keys[0] = parent->node.keys[i - 1];
+        _TM_INNER(c)->children[0] = _TM_INNER(l)->children[l->length];
+        parent->node.keys[i - 1] = l->keys[l->length - 1];
+    }
+    l->length--;
+    c->length++;
+}
+
+/**
+ * Move the first entry of the child right of position i to the child at i
+ */
+static void _tm_borrowright(_tminner_t* parent, size_t i){
+    _tmnode_t* c = parent->children[i];
+    _tmnode_t* r = parent->children[i + 1];
+    if(c->leaf){
+        c->keys[c->length] = r->keys[0];
+        _TM_LEAF(c)->values[c->length] = _TM_LEAF(r)->values[0];
+        memmove(_TM_LEAF(r)->values, _TM_LEAF(r)->values + 1,
+                (r->length - 1)*sizeof(void*));
+        memmove(r->keys, r->keys + 1, (r->length - 1)*sizeof(void*));
+        parent->node.keys[i] = r->keys[0];
+    }
+    else{
+        c->keys[c->length] = parent->node.keys[i];
+        _TM_INNER(c)->children[c->length + 1] = _TM_INNER(r)->children[0];
+        parent->node.keys[i] = r->keys[0];
+        memmove(_TM_INNER(r)->children, _TM_INNER(r)->children + 1,
+                r->length*sizeof(_tmnode_t*));
+        memmove(r->keys, r->keys + 1, (r->length - 1)*sizeof(void*));
+    }
+    r->length--;
+    c->length++;
+}
+
+/**
+ * Merge the child right of position i into the child at i and free it
+ */
+static void _tm_merge(treemap_t* map, _tminner_t* parent, size_t i){
+    _tmnode_t* l = parent->children[i];
+    _tmnode_t* r = parent->children[i + 1];
+    if(l->leaf){
+        memcpy(l->keys + l->length, r->keys, r->length*sizeof(void*));
+        memcpy(_TM_LEAF(l)->values + l->length, _TM_LEAF(r)->values,
+               r->length*sizeof(void*));
+        l->length += r->length;
+        _TM_LEAF(l)->next = _TM_LEAF(r)->next;
+        if(_TM_LEAF(r)->next != NULL){
+            _TM_LEAF(r)->next->prev = _TM_LEAF(l);
+        }
+        else{
+            map->last = _TM_LEAF(l);
+        }
+    }
+    else{
+        l->keys[l->length] = parent->node.keys[i];
+        memcpy(l->keys + l->length + 1, r->keys, r->length*sizeof(void*));
+        memcpy(_TM_INNER(l)->children + l->length + 1, _TM_INNER(r)->children,
+               (r->length + 1)*sizeof(_tmnode_t*));
+        l->length += r->length + 1;
+    }
+    free(r);
+    size_t len = parent->node.length;
+    memmove(parent->node.keys + i, parent->node.keys + i + 1,
+            (len - i - 1)*sizeof(void*));
+    memmove(parent->children + i + 1, parent->children + i + 2,
+            (len - i - 1)*sizeof(_tmnode_t*));
+    parent->node.length--;
+}
+
+/**
+ * Returns the key following the least key of a subtree, or NULL if the
+ * subtree's least key is the largest in the map
+ */
+static void* _tm_secondkey(const _tmnode_t* node){
+    while(!node->leaf){
+        node = _TM_INNER(node)->children[0];
+    }
+    if(node->length > 1){
+        return node->keys[1];
+    }
+    const _tmleaf_t* next = _TM_LEAF(node)->next;
+    return next != NULL ? next->node.keys[0] : NULL;
+}
+
+/**
+ * Remove a key from a subtree, refilling any child left with fewer than
+ * _TM_MIN keys from a sibling or merging it with one
+ * <p>
+ * A key equal to a separator is the least key of the subtree right of it, so
+ * the separator is replaced by the next key before descending. Separators
+ * therefore only ever point at keys in the map, and a caller may free a key
+ * once it is removed
+ * @param value  Set to the value of the key if it is found
+ * @return  t/f depending on the key being found
+ */
+static bool _tm_remove(treemap_t* map, _tmnode_t* node, const void* key,
+                       void** value){
+    bool found;
+    size_t i = _tm_search(map, node, key, &found);
+    if(node->leaf){
+        if(!found){
+            return false;
+        }
+        _tmleaf_t* leaf = _TM_LEAF(node);
+        *value = leaf->values[i];
+        memmove(node->keys + i, node->keys + i + 1,
+                (node->length - i - 1)*sizeof(void*));
+        memmove(leaf->values + i, leaf->values + i + 1,
+                (node->length - i - 1)*sizeof(void*));
+        node->length--;
+        return true;
+    }
+    _tminner_t* inner = _TM_INNER(node);
+    if(found){
+        void* next = _tm_secondkey(inner->children[i + 1]);
+        if(next != NULL){
+            node->keys[i] = next;
+        }
+    }
+    i += found;
+    if(!_tm_remove(map, inner->children[i], key, value)){
+        return false;
+    }
+    if(inner->children[i]->length < _TM_MIN){
+        if(i > 0 && inner->children[i - 1]->length > _TM_MIN){
+            _tm_borrowleft(inner, i);
+        }
+        else if(i < node->length && inner->children[i + 1]->length > _TM_MIN){
+            _tm_borrowright(inner, i);
+        }
+        else{
+            _tm_merge(map, inner, i > 0 ? i - 1 : i);
+        }
+    }
+    return true;
+}
+
+/**
+ * Initialize an empty tree map
+ * @param map  The pointer to initialize as a treemap
+ * @param cmp  The compare function ordering the keys
+ * @return  t/f depending on the successful allocation of the root
+ */
+bool treemap_init(treemap_t* map, int (*cmp)(const void*, const void*)){
+    _tmleaf_t* leaf = _tm_newleaf();
+    map->root = leaf != NULL ? &leaf->node : NULL;
+    map->first = leaf;
+    map->last = leaf;
+    map->size = 0;
+    map->cmp = cmp;
+    return leaf != NULL;
+}
+
+/**
+ * Free the memory held by a tree map. The keys and values are not freed
+ * <p>
+ * This function should be called when the map is no longer needed and before
+ * freeing the pointer itself
+ * @param map  The map to free
+ */
+void treemap_free(treemap_t* map){
+    if(map->root != NULL){
+        _tm_freenode(map->root, NULL);
+    }
+    map->root = NULL;
+    map->first = NULL;
+    map->last = NULL;
+    map->size = 0;
+}
+
+/**
+ * Associate a value with a key in O(log n), replacing the value of an equal
+ * key already in the map
+ * <p>
+ * Full nodes are split on the way down, so the leaf always has room and a
+ * failed allocation leaves a valid tree. A replaced key keeps the pointer it
+ * was first added with
+ * @param map    The map to add to
+ * @param key    The pointer to the key
+ * @param value  The pointer to the value
+ * @return  t/f depending on the successful allocation of the requested space
+ */
+bool treemap_put(treemap_t* map, void* key, void* value){
+    if(map->root->length == _TM_ORDER){
+        _tminner_t* root = _tm_newinner();
+        if(root == NULL){
+            return false;
+        }
+        root->children[0] = map->root;
+        if(!_tm_split(map, root, 0)){
+            free(root);
+            return false;
+        }
+        map->root = &root->node;
+    }
+    _tmnode_t* node = map->root;
+    bool found;
+    size_t i;
+    while(!node->leaf){
+        _tminner_t* inner = _TM_INNER(node);
+        i = _tm_search(map, node, key, &found) + found;
+        if(inner->children[i]->length == _TM_ORDER){
+            if(!_tm_split(map, inner, i)){
+                return false;
+            }
+            // The new separator at i decides which half the key belongs in
+            i += map->cmp(key, node->keys[i]) >= 0;
+        }
+        node = inner->children[i];
+    }
+    _tmleaf_t* leaf = _TM_LEAF(node);
+    i = _tm_search(map, node, key, &found);
+    if(found){
+        leaf->values[i] = value;
+        return true;
+    }
+    memmove(node->keys + i + 1, node->keys + i,
+            (node->length - i)*sizeof(void*));
+    memmove(leaf->values + i + 1, leaf->values + i,
+            (node->length - i)*sizeof(void*));
+    node->keys[i] = key;
+    leaf->values[i] = value;
+    node->length++;
+    map->size++;
+    return true;
+}
+
+/**
+ * Remove a key from the map in O(log n)
+ * <p>
+ * The map keeps no pointer to a removed key, so the caller may free it
+ * @param map  The map to remove from
+ * @param key  The key to remove
+ * @return  The value the key was associated with, or NULL if it was not found
+ */
+void* treemap_remove(treemap_t* map, const void* key){
+    void* value = NULL;
+    if(!_tm_remove(map, map->root, key, &value)){
+        return NULL;
+    }
+    map->size--;
+    if(!map->root->leaf && map->root->length == 0){
+        _tmnode_t* root = map->root;
+        map->root = _TM_INNER(root)->children[0];
+        free(root);
+    }
+    return value;
+}
+
+/**
+ * Delete all keys from the map, keeping a single empty leaf
+ * @param map  The map to clear
+ */
+void treemap_clear(treemap_t* map){
+    _tm_freenode(map->root, &map->first->node);
+    map->first->node.length = 0;
+    map->first->next = NULL;
+    map->root = &map->first->node;
+    map->last = map->first;
+    map->size = 0;
+}
+
+/**
+ * Returns the value associated with a key in O(log n)
+ * @param map  The map to look in
+ * @param key  The key to look for
+ * @return  The value of the key, or NULL if the map does not contain it
+ */
+void* treemap_get(const treemap_t* map, const void* key){
+    bool found;
+    _tmleaf_t* leaf = _tm_findleaf(map, key);
+    size_t i = _tm_search(map, &leaf->node, key, &found);
+    return found ? leaf->values[i] : NULL;
+}
+
+/**
+ * Returns whether the map contains a key, which distinguishes keys with a NULL
+ * value from missing keys
+ * @param map  The map to look in
+ * @param key  The key to look for
+ * @return  t/f depending on the key being in the map
+ */
+bool treemap_containskey(const treemap_t* map, const void* key){
+    bool found;
+    _tm_search(map, &_tm_findleaf(map, key)->node, key, &found);
+    return found;
+}
+
+/**
+ * Returns the smallest key in the map
+ * @param map  The map to look in
+ * @return  The first key, or NULL if the map is empty
+ */
+void* treemap_firstkey(const treemap_t* map){
+    return map->size > 0 ? map->first->node.keys[0] : NULL;
+}
+
+/**
+ * Returns the largest key in the map
+ * @param map  The map to look in
+ * @return  The last key, or NULL if the map is empty
+ */
+void* treemap_lastkey(const treemap_t* map){
+    return map->size > 0 ? map->last->node.keys[map->last->node.length - 1] :
+                           NULL;
+}
+
+/**
+ * Returns the largest key in the map less than or equal to key in O(log n)
+ * @param map  The map to look in
+ * @param key  The key to compare against
+ * @return  The floor key, or NULL if every key in the map is larger
+ */
+void* treemap_floorkey(const treemap_t* map, const void* key){
+    bool found;
+    _tmleaf_t* leaf = _tm_findleaf(map, key);
+    size_t i = _tm_search(map, &leaf->node, key, &found);
+    if(found){
+        return leaf->node.keys[i];
+    }
+    if(i > 0){
+        return leaf->node.keys[i - 1];
+    }
+    // Every key of the previous leaf is below this leaf's separator
+    leaf = leaf->prev;
+    return leaf != NULL ? leaf->node.keys[leaf->node.length - 1] : NULL;
+}
+
+/**
+ * Returns the smallest key in the map greater than or equal to key in
+ * O(log n)
+ * @param map  The map to look in
+ * @param key  The key to compare against
+ * @return  The ceiling key, or NULL if every key in the map is smaller
+ */
+void* treemap_ceilingkey(const treemap_t* map, const void* key){
+    _tmleaf_t* leaf;
+    size_t i;
+    _tm_position(map, key, &leaf, &i);
+    return i < leaf->node.length ? leaf->node.keys[i] : NULL;
+}
+
+/**
+ * Returns the number of keys in the map
+ * @param map  The map
+ * @return  The number of keys in the map
+ */
+size_t treemap_size(const treemap_t* map){
+    return map->size;
+}
+
+/**
+ * Prefetch a leaf into the cache. Leaves are allocated as the tree grows, so
+ * neighbouring leaves are rarely adjacent in memory and a scan would wait on
+ * a cache miss at every leaf without this
+ */
+static inline void _tm_prefetchleaf(const _tmleaf_t* leaf){
+    if(leaf != NULL){
+        const char* p = (const char*) leaf;
+        size_t off;
+        for(off = 0; off < sizeof(_tmleaf_t); off += 64){
+            __builtin_prefetch(p + off);
+        }
+    }
+}
+
+/**
+ * Start an iterator over the entries with keys from lo up to but not
+ * including hi, in ascending order of the keys
+ * <p>
+ * Both ends are found in O(log n) up front, so stepping through the range
+ * walks the linked leaves without calling the comparator. The map must not
+ * be modified while the iterator is in use
+ * @param map  The map to iterate over
+ * @param it   The iterator to initialize
+ * @param lo   The least key of the range, or NULL to start at the first key
+ * @param hi   The key the range ends before, or NULL to end after the last key
+ */
+void treemap_iterator(const treemap_t* map, treemap_iterator_t* it,
+                      const void* lo, const void* hi){
+    if(hi == NULL){
+        it->endleaf = map->last;
+        it->endindex = map->last->node.length;
+    }
+    else{
+        _tm_position(map, hi, &it->endleaf, &it->endindex);
+    }
+    if(lo == NULL){
+        it->leaf = map->first;
+        it->index = 0;
+    }
+    else if(hi != NULL && map->cmp(lo, hi) >= 0){
+        it->leaf = it->endleaf;
+        it->index = it->endindex;
+    }
+    else{
+        _tm_position(map, lo, &it->leaf, &it->index);
+    }
+}
+
+/**
+ * Returns whether an iterator has entries left in its range
+ * @param it  The iterator
+ * @return  t/f depending on there being a next entry
+ */
+bool treemap_iterator_hasnext(const treemap_iterator_t* it){
+    return it->leaf != it->endleaf || it->index != it->endindex;
+}
+
+/**
+ * Advance an iterator to the next entry of its range
+ * <p>
+ * On reaching a leaf, the leaf after it is prefetched, so the next cache miss
+ * overlaps with visiting the current leaf
+ * @param it   The iterator
+ * @param key  Set to the key of the entry, unless NULL
+ * @return  The value of the entry, or NULL if the range is exhausted
+ */
+void* treemap_iterator_next(treemap_iterator_t* it, void** key){
+    if(!treemap_iterator_hasnext(it)){
+        return NULL;
+    }
+    _tmleaf_t* leaf = it->leaf;
+    size_t i = it->index++;
+    if(it->index == leaf->node.length && leaf->next != NULL){
+        it->leaf = leaf->next;
+        it->index = 0;
+        _tm_prefetchleaf(it->leaf->next);
+    }
+    if(key != NULL){
+        *key = leaf->node.keys[i];
+    }
+    return leaf->values[i];
+}
+
+/**
+ * Returns the least key of a non empty subtree
+ */
+static const void* _tm_leastkey(const _tmnode_t* node){
+    while(!node->leaf){
+        node = _TM_INNER(node)->children[0];
+    }
+    return node->keys[0];
+}
+
+/**
+ * Checks the depth, occupancy and separator keys of a subtree. Each
+ * separator must be the least key of the subtree right of it, which keeps
+ * removed keys out of inner nodes
+ * @param lo  Every key must be at least lo, unless lo is NULL
+ * @param hi  Every key must be less than hi, unless hi is NULL
+ * @return  The depth of the subtree's leaves, or -1 if it is invalid
+ */
+static int _tm_validate(const treemap_t* map, const _tmnode_t* node,
+                        const void* lo, const void* hi, size_t* count){
+    size_t i;
+    if(node != map->root && node->length < _TM_MIN){
+        return -1;
+    }
+    for(i = 0; i < node->length; i++){
+        if((i > 0 && map->cmp(node->keys[i - 1], node->keys[i]) >= 0) ||
+           (lo != NULL && map->cmp(node->keys[i], lo) < 0) ||
+           (hi != NULL && map->cmp(node->keys[i], hi) >= 0)){
+            return -1;
+        }
+    }
+    if(node->leaf){
+        *count += node->length;
+        return 0;
+    }
+    int depth = -1;
+    for(i = 0; i <= node->length; i++){
+        int d = _tm_validate(map, _TM_INNER(node)->children[i],
+                             i > 0 ? node->keys[i - 1] : lo,
+                             i < node->length ? node->keys[i] : hi, count);
+        if(d < 0 || (i > 0 && d != depth) ||
+           (i > 0 && _tm_leastkey(_TM_INNER(node)->children[i]) !=
+                     node->keys[i - 1])){
+            return -1;
+        }
+        depth = d;
+    }
+    return depth + 1;
+}
+
+/**
+ * Verifies that a tree map is a valid B+-tree: keys are ordered and within
+ * the bounds of their separators, every separator is the least key of the
+ * subtree right of it, every leaf is at the same depth, nodes are at least
+ * half full and the leaf list holds every key in order
+ * @param map  The map to be checked
+ * @return  t/f indicating if the tree is valid
+ */
+bool validate_treemap(const treemap_t* map){
+    size_t count = 0;
+    if(_tm_validate(map, map->root, NULL, NULL, &count) < 0 ||
+       count != map->size){
+        return false;
+    }
+    const _tmleaf_t* leaf;
+    const _tmleaf_t* prev = NULL;
+    count = 0;
+    for(leaf = map->first; leaf != NULL; leaf = leaf->next){
+        if(leaf->prev != prev || (prev != NULL && leaf->node.length > 0 &&
+           map->cmp(prev->node.keys[prev->node.length - 1],
+                    leaf->node.keys[0]) >= 0)){
+            return false;
+        }
+        count += leaf->node.length;
+        prev = leaf;
+    }
+    return prev == map->last && count == map->size;
+}
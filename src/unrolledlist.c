@@ -0,0 +1,297 @@
+/*
+ c unrolled linked list structure
+*/
+#include <string.h>
+#include "unrolledlist.h"
+
+const size_t unrolledlist_nodealign = 64;
+
+/**
+ * Allocate an empty cache line aligned node
+ */
+static _ulnode_t* _ul_newnode(void){
+    _ulnode_t* node = (_ulnode_t*) aligned_alloc(unrolledlist_nodealign,
+                                                 sizeof(_ulnode_t));
+    if(node != NULL){
+        node->next = NULL;
+        node->count = 0;
+    }
+    return node;
+}
+
+/**
+ * Find the node holding the element at ind
+ * @param lst   The list to look in
+ * @param ind   The index to find, which must be less than the list length
+ * @param off   Set to the position of the element within the node
+ * @param prev  Set to the node before the returned one, or NULL if it is the
+ *              first. Not set by the fast path for the last node if NULL
+ * @return  The node holding the element
+ */
+static _ulnode_t* _ul_find(const unrolledlist_t* lst, size_t ind, size_t* off,
+                           _ulnode_t** prev){
+    if(prev == NULL && ind >= lst->length - lst->end->count){
+        *off = ind - (lst->length - lst->end->count);
+        return lst->end;
+    }
+    _ulnode_t* before = NULL;
+    _ulnode_t* current = lst->start;
+    while(ind >= current->count){
+        ind -= current->count;
+        before = current;
+        current = current->next;
+    }
+    *off = ind;
+    if(prev){
+        *prev = before;
+    }
+    return current;
+}
+
+/**
+ * Move the upper half of a full node into a new node linked after it
+ * @return  The new node, or NULL if it could not be allocated
+ */
+static _ulnode_t* _ul_split(unrolledlist_t* lst, _ulnode_t* node){
+    _ulnode_t* half = _ul_newnode();
+    if(half == NULL){
+        return NULL;
+    }
+    size_t keep = node->count/2;
+    half->count = node->count - keep;
+    memcpy(half->data, node->data + keep, half->count*sizeof(void*));
+    node->count = keep;
+    half->next = node->next;
+    node->next = half;
+    if(lst->end == node){
+        lst->end = half;
+    }
+    return half;
+}
+
+/**
+ * Restore the fill of a node that dropped below half full by merging its
+ * successor into it or by moving elements over from the successor
+ */
+static void _ul_rebalance(unrolledlist_t* lst, _ulnode_t* node){
+    _ulnode_t* next = node->next;
+    if(next == NULL || node->count >= _UL_NODECAP/2){
+        return;
+    }
+    if(node->count + next->count <= _UL_NODECAP){
+        memcpy(node->data + node->count, next->data,
+               next->count*sizeof(void*));
+        node->count += next->count;
+        node->next = next->next;
+        if(lst->end == next){
+            lst->end = node;
+        }
+        free(next);
+        return;
+    }
+    size_t move = (next->count - node->count)/2;
+    memcpy(node->data + node->count, next->data, move*sizeof(void*));
+    node->count += move;
+    next->count -= move;
+    memmove(next->data, next->data + move, next->count*sizeof(void*));
+}
+
+/**
+ * Initialize an empty unrolled list
+ * @param lst  The pointer to intialize as an unrolledlist
+ */
+void unrolledlist_init(unrolledlist_t* lst){
+    lst->length = 0;
+    lst->start = NULL;
+    lst->end = NULL;
+}
+
+/**
+ * Frees the nodes of an unrolledlist, leaving it empty
+ * <p>
+ * This function should be called when the unrolledlist is no longer needed and
+ * before freeing the pointer itself
+ * @param lst  The unrolledlist to free
+ */
+void unrolledlist_free(unrolledlist_t* lst){
+    _ulnode_t* current = lst->start;
+    while(current != NULL){
+        _ulnode_t* next = current->next;
+        free(current);
+        current = next;
+    }
+    lst->length = 0;
+    lst->start = NULL;
+    lst->end = NULL;
+}
+
+/**
+ * Append the given item to the end of the unrolledlist in O(1)
+ * <p>
+ * Appending fills the last node before starting a new one, so a list built by
+ * appending has full nodes
+ * @param lst   The unrolledlist to append to
+ * @param data  The data to add
+ * @return  t/f depending on the successful allocation of a new node
+ */
+bool unrolledlist_append(unrolledlist_t* lst, void* data){
+    _ulnode_t* end = lst->end;
+    if(end == NULL || end->count == _UL_NODECAP){
+        _ulnode_t* node = _ul_newnode();
+        if(node == NULL){
+            return false;
+        }
+        if(end == NULL){
+            lst->start = node;
+        }
+        else{
+            end->next = node;
+        }
+        lst->end = node;
+        end = node;
+    }
+    end->data[end->count++] = data;
+    lst->length++;
+    return true;
+}
+
+/**
+ * Add the given item to the unrolledlist at the specified index
+ * <p>
+ * Shifts at most one node's elements, splitting the node first if it is full
+ * @param lst   The unrolledlist to add to
+ * @param ind   The index at which to add the data
+ * @param data  The data to add
+ * @return  t/f depending on the validity of the index and the successful
+ *          allocation of a node if one had to be split
+ */
+bool unrolledlist_add(unrolledlist_t* lst, const size_t ind, void* data){
+    if(ind > lst->length){
+        return false;
+    }
+    if(ind == lst->length){
+        return unrolledlist_append(lst, data);
+    }
+    size_t off;
+    _ulnode_t* node = _ul_find(lst, ind, &off, NULL);
+    if(node->count == _UL_NODECAP){
+        _ulnode_t* half = _ul_split(lst, node);
+        if(half == NULL){
+            return false;
+        }
+        if(off > node->count){
+            off -= node->count;
+            node = half;
+        }
+    }
+    memmove(node->data + off + 1, node->data + off,
+            (node->count - off)*sizeof(void*));
+    node->data[off] = data;
+    node->count++;
+    lst->length++;
+    return true;
+}
+
+/**
+ * Removes the data at the specified index from the list and returns the removed
+ * data pointer
+ * @param lst  The unrolledlist to remove from
+ * @param ind  The index of the element to remove
+ * @return  The removed element, or NULL if the index is out of range
+ */
+void* unrolledlist_remove(unrolledlist_t* lst, const size_t ind){
+    if(ind >= lst->length){
+        return NULL;
+    }
+    size_t off;
+    _ulnode_t* prev;
+    _ulnode_t* node = _ul_find(lst, ind, &off, &prev);
+    void* data = node->data[off];
+    node->count--;
+    memmove(node->data + off, node->data + off + 1,
+            (node->count - off)*sizeof(void*));
+    lst->length--;
+    if(node->count == 0){
+        if(prev == NULL){
+            lst->start = node->next;
+        }
+        else{
+            prev->next = node->next;
+        }
+        if(lst->end == node){
+            lst->end = prev;
+        }
+        free(node);
+    }
+    else{
+        _ul_rebalance(lst, node);
+    }
+    return data;
+}
+
+/**
+ * Returns the number of items in the unrolledlist
+ * @param lst  The unrolledlist
+ * @return  The length of the given unrolledlist
+ */
+size_t unrolledlist_length(const unrolledlist_t* lst){
+    return lst->length;
+}
+
+/**
+ * Copies the elements of the list into a newly allocated array, which the
+ * caller must free
+ * @param lst  The unrolledlist
+ * @return  The array of elements in list order, or NULL if allocation failed
+ */
+void** unrolledlist_toarray(const unrolledlist_t* lst){
+    void** ary = (void**) malloc(lst->length*sizeof(void*));
+    if(ary == NULL){
+        return NULL;
+    }
+    void** out = ary;
+    _ulnode_t* current;
+    for(current = lst->start; current != NULL; current = current->next){
+        memcpy(out, current->data, current->count*sizeof(void*));
+        out += current->count;
+    }
+    return ary;
+}
+
+/**
+ * Returns the item at the specified index of the unrolledlist
+ * <p>
+ * Skips whole nodes, and the last node is found in O(1)
+ * @param lst  The unrolledlist to look in
+ * @param ind  The index of the element to get
+ * @return  The element at the specified index, or NULL if it is out of range
+ */
+void* unrolledlist_get(const unrolledlist_t* lst, const size_t ind){
+    if(ind >= lst->length){
+        return NULL;
+    }
+    size_t off;
+    _ulnode_t* node = _ul_find(lst, ind, &off, NULL);
+    return node->data[off];
+}
+
+/**
+ * Searches the unrolledlist for the specified item using the given comparator
+ * function to check for equality. Returns the index at which the item was found
+ * or -1 if it was not found
+ */
+ptrdiff_t unrolledlist_indexof(const unrolledlist_t* lst, const void* data,
+                               int (*cmp)(const void*, const void*)){
+    size_t base = 0;
+    _ulnode_t* current;
+    for(current = lst->start; current != NULL; current = current->next){
+        size_t i;
+        for(i = 0; i < current->count; i++){
+            if((*cmp)(data, current->data[i]) == 0){
+                return (ptrdiff_t) (base + i);
+            }
+        }
+        base += current->count;
+    }
+    return -1;
+}